@@ -0,0 +1,103 @@
+#ifndef __ASSET_REGISTRY_HPP__
+#define __ASSET_REGISTRY_HPP__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace utils
+{
+class Mesh;
+class ShadersManager;
+class Texture;
+
+struct AssetStats
+{
+    std::size_t d_liveCount = 0;
+    // requests answered with an asset that already existed
+    std::size_t d_reusedCount = 0;
+    // GPU memory those requests would have allocated again
+    std::size_t d_savedBytes = 0;
+
+    bool operator==(const AssetStats&) const = default;
+};
+
+struct AssetRegistryStats
+{
+    utils::AssetStats d_textures;
+    utils::AssetStats d_meshes;
+    // programs save their compile and link time, their size isn't known to the GL
+    utils::AssetStats d_programs;
+
+    bool operator==(const AssetRegistryStats&) const = default;
+};
+
+// Process-wide index of the GPU assets alive at the moment, so models and shader sets share them instead of creating them twice.
+// The registry only holds weak references: the handles are shared pointers and an asset is freed with its last user.
+// Textures are found by normalized path and by a hash of their file's content, so the same image under another path is shared too;
+// a file loaded block compressed and loaded as it is are two textures, their formats and streaming differ.
+// meshes by a hash of their geometry and material, programs by their sources and defines.
+// find and add are for the context thread, the has lookups can be done from loader threads to skip decoding.
+class AssetRegistry
+{
+public:
+    AssetRegistry(const AssetRegistry&) = delete;
+    AssetRegistry& operator=(const AssetRegistry&) = delete;
+
+    static AssetRegistry& getInstance();
+
+    static std::string normalizePath(std::string_view i_path);
+    static std::uint64_t hashFile(const std::filesystem::path& i_path);
+
+    // a content hash of 0 means unknown, only the path is looked up then; i_isCompressed is the variant, see loadTextureImage()
+    bool hasTexture(std::string_view i_path, bool i_isCompressed, std::uint64_t i_contentHash = 0) const;
+    // the path is remembered as an alias when the texture is found by its content
+    std::shared_ptr<utils::Texture> findTexture(std::string_view i_path, bool i_isCompressed, std::uint64_t i_contentHash = 0);
+    // if a texture with the same content got registered since the lookup, that one is returned and i_texture dropped
+    std::shared_ptr<utils::Texture> addTexture(std::string_view i_path, bool i_isCompressed, std::uint64_t i_contentHash,
+                                               std::shared_ptr<utils::Texture> i_texture);
+
+    std::shared_ptr<utils::Mesh> findMesh(std::uint64_t i_key);
+    std::shared_ptr<utils::Mesh> addMesh(std::uint64_t i_key, std::shared_ptr<utils::Mesh> i_mesh);
+
+    std::shared_ptr<utils::ShadersManager> findProgram(std::uint64_t i_key);
+    std::shared_ptr<utils::ShadersManager> addProgram(std::uint64_t i_key, std::shared_ptr<utils::ShadersManager> i_program);
+
+    utils::AssetRegistryStats getStats() const;
+
+private:
+    AssetRegistry() = default;
+
+    template <typename Asset>
+    struct AssetTable
+    {
+        std::unordered_map<std::uint64_t, std::weak_ptr<Asset>> d_assets;
+        utils::AssetStats d_stats;
+    };
+
+    template <typename Asset>
+    static std::shared_ptr<Asset> find(AssetTable<Asset>& io_table, std::uint64_t i_key);
+    template <typename Asset>
+    static std::shared_ptr<Asset> add(AssetTable<Asset>& io_table, std::uint64_t i_key, std::shared_ptr<Asset> i_asset);
+    template <typename Asset>
+    static utils::AssetStats getStats(const AssetTable<Asset>& i_table);
+
+    // key of a texture path's variant
+    std::uint64_t findTextureKey(const std::string& i_normalizedPath, bool i_isCompressed) const;
+
+    mutable std::mutex d_mutex;
+    // textures are keyed by content and variant, the paths lead to it; indexed by i_isCompressed
+    std::array<std::unordered_map<std::string, std::uint64_t>, 2> d_texturePaths;
+    AssetTable<utils::Texture> d_textures;
+    AssetTable<utils::Mesh> d_meshes;
+    AssetTable<utils::ShadersManager> d_programs;
+};
+}
+
+#endif // __ASSET_REGISTRY_HPP__
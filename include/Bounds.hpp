@@ -0,0 +1,29 @@
+#ifndef __BOUNDS_HPP__
+#define __BOUNDS_HPP__
+
+#include "UtilsFwd.hpp"
+
+#include <glm/glm.hpp>
+
+#include <span>
+
+namespace utils
+{
+// Bounding volumes of a mesh in its local space, a sphere and an axis-aligned box sharing the center
+struct Bounds
+{
+    glm::vec3 d_center{ 0.0f };
+    float d_radius = 0.0f;
+    glm::vec3 d_extents{ 0.0f }; // half size of the box
+};
+
+utils::Bounds computeBounds(std::span<const utils::Vertex> i_vertices);
+
+// bounds of the transformed volumes, the box stays axis-aligned so it grows under rotation
+utils::Bounds transformBounds(const utils::Bounds& i_bounds, const glm::mat4& i_transform);
+
+// length of the longest basis vector of the transform
+float getMaxScale(const glm::mat4& i_transform);
+}
+
+#endif // __BOUNDS_HPP__
@@ -20,6 +20,8 @@ public:
     glm::vec3 getCameraPos() const;
 
     glm::vec3 getCameraFront() const;
+    float getFov() const;            // vertical, in degrees
+    float getViewportHeight() const; // in pixels
 
 private:
     void updateCameraVectors();
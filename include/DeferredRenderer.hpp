@@ -0,0 +1,53 @@
+#ifndef __DEFERRED_RENDERER_HPP__
+#define __DEFERRED_RENDERER_HPP__
+
+#include "GLObject.hpp"
+#include "ShaderVariants.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string_view>
+
+namespace utils
+{
+// Deferred shading: the geometry pass writes the material and normal of the closest surface of every pixel to a G-buffer,
+// the lighting pass then shades every pixel once with a fullscreen triangle, so overdrawn fragments only cost their G-buffer writes.
+// The G-buffer holds the diffuse color and specular intensity (RGBA8), the octahedral encoded normal (RG16F) and the depth (DEPTH24_STENCIL8),
+// which the world position is reconstructed from. The lighting pass is the forward fragment shader with DEFERRED_LIGHTING,
+// so it evaluates the same lights, the clustered ones through the screen tiles of LightClusters.
+class DeferredRenderer
+{
+public:
+    // meshes are drawn with i_vertexShaderPath and i_geometryShaderPath, the G-buffer is shaded with i_fullscreenShaderPath
+    // and i_lightingShaderPath
+    DeferredRenderer(std::string_view i_vertexShaderPath, std::string_view i_geometryShaderPath, std::string_view i_fullscreenShaderPath,
+                     std::string_view i_lightingShaderPath);
+
+    // the variants meshes are drawn with between beginGeometryPass() and drawLighting(), only their material features matter
+    utils::ShaderVariants& getGeometryShaders();
+    utils::ShaderVariants& getLightingShaders();
+
+    // binds and clears the G-buffer, resized to the framebuffer first if needed
+    void beginGeometryPass(GLsizei i_width, GLsizei i_height);
+    // shades the G-buffer into the default framebuffer with the lights of i_sceneFeatures and copies the G-buffer's depth there,
+    // so forward draws that follow are depth tested against the scene; the background color is left as it is.
+    // The default framebuffer has to be the size of the G-buffer, with a 24 bit depth and 8 bit stencil buffer
+    void drawLighting(utils::ShaderFeatures i_sceneFeatures, const glm::mat4& i_viewProjection);
+
+private:
+    void resize(GLsizei i_width, GLsizei i_height);
+
+    utils::ShaderVariants d_geometryShaders;
+    utils::ShaderVariants d_lightingShaders;
+    utils::FramebufferHandle d_framebuffer;
+    utils::TextureHandle d_albedoSpecular;
+    utils::TextureHandle d_normal;
+    utils::TextureHandle d_depth;
+    utils::VertexArrayHandle d_emptyVAO; // the fullscreen triangle has no attributes, but core profiles draw with a VAO
+    GLsizei d_width = 0;
+    GLsizei d_height = 0;
+};
+}
+
+#endif // __DEFERRED_RENDERER_HPP__
@@ -0,0 +1,66 @@
+#ifndef __FRUSTUM_HPP__
+#define __FRUSTUM_HPP__
+
+#include "Bounds.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace utils
+{
+// Six planes (xyz: normal pointing inside, w: distance) in the space the matrix they were extracted from transforms from;
+// extracting them from projection * view * model culls model space bounds without transforming them
+struct Frustum
+{
+    std::array<glm::vec4, 6> d_planes;
+};
+
+utils::Frustum extractFrustum(const glm::mat4& i_matrix);
+
+// false if the box of i_bounds is completely outside of one of the planes;
+// conservative, boxes near the frustum corners can pass
+bool isVisible(const utils::Frustum& i_frustum, const utils::Bounds& i_bounds);
+
+// Instruction sets AabbBatch can test the boxes with, they all give the same results
+enum class CullKernel
+{
+    Scalar,
+    Sse, // 4 boxes at once
+    Avx  // 8 boxes at once
+};
+
+// whether the build has the kernel and the CPU running it supports its instructions
+bool isCullKernelSupported(utils::CullKernel i_kernel);
+// the widest supported kernel, checked once
+utils::CullKernel getBestCullKernel();
+
+// Boxes in structure of arrays layout, so the culling can test several of them per instruction
+class AabbBatch
+{
+public:
+    void add(const utils::Bounds& i_bounds);
+    void clear();
+    std::size_t size() const;
+
+    // tests every box against the frustum with getBestCullKernel(),
+    // o_visible must hold size() elements and gets 1 for the boxes that may be visible and 0 for the others
+    void cull(const utils::Frustum& i_frustum, std::span<std::uint8_t> o_visible) const;
+    // with the given kernel, which has to be supported
+    void cull(const utils::Frustum& i_frustum, std::span<std::uint8_t> o_visible, utils::CullKernel i_kernel) const;
+
+private:
+    std::vector<float> d_centerX;
+    std::vector<float> d_centerY;
+    std::vector<float> d_centerZ;
+    std::vector<float> d_extentX;
+    std::vector<float> d_extentY;
+    std::vector<float> d_extentZ;
+};
+}
+
+#endif // __FRUSTUM_HPP__
@@ -0,0 +1,152 @@
+#ifndef __GL_OBJECT_HPP__
+#define __GL_OBJECT_HPP__
+
+#include "GLStateCache.hpp"
+
+#include <glad/glad.h>
+
+#include <utility>
+
+namespace utils
+{
+// Move-only owner of a GL object name, Traits provide create() and destroy()
+template <typename Traits>
+class GLObject
+{
+public:
+    GLObject() = default;
+    explicit GLObject(GLuint i_id) : d_id(i_id)
+    {
+    }
+
+    ~GLObject()
+    {
+        reset();
+    }
+
+    GLObject(const GLObject&) = delete;
+    GLObject& operator=(const GLObject&) = delete;
+
+    GLObject(GLObject&& io_other) noexcept : d_id(std::exchange(io_other.d_id, 0))
+    {
+    }
+
+    GLObject& operator=(GLObject&& io_other) noexcept
+    {
+        if (this != &io_other)
+            reset(std::exchange(io_other.d_id, 0));
+        return *this;
+    }
+
+    static GLObject create()
+    {
+        return GLObject(Traits::create());
+    }
+
+    GLuint get() const
+    {
+        return d_id;
+    }
+
+    explicit operator bool() const
+    {
+        return d_id != 0;
+    }
+
+    void reset(GLuint i_id = 0)
+    {
+        if (d_id)
+            Traits::destroy(d_id);
+        d_id = i_id;
+    }
+
+private:
+    GLuint d_id = 0;
+};
+
+struct VertexArrayTraits
+{
+    static GLuint create()
+    {
+        GLuint id = 0;
+        glGenVertexArrays(1, &id);
+        return id;
+    }
+
+    static void destroy(GLuint i_id)
+    {
+        utils::GLStateCache::getInstance().onVertexArrayDeleted(i_id);
+        glDeleteVertexArrays(1, &i_id);
+    }
+};
+
+struct BufferTraits
+{
+    static GLuint create()
+    {
+        GLuint id = 0;
+        glGenBuffers(1, &id);
+        return id;
+    }
+
+    static void destroy(GLuint i_id)
+    {
+        utils::GLStateCache::getInstance().onBufferDeleted(i_id);
+        glDeleteBuffers(1, &i_id);
+    }
+};
+
+struct TextureTraits
+{
+    static GLuint create()
+    {
+        GLuint id = 0;
+        glGenTextures(1, &id);
+        return id;
+    }
+
+    static void destroy(GLuint i_id)
+    {
+        utils::GLStateCache::getInstance().onTextureDeleted(i_id);
+        glDeleteTextures(1, &i_id);
+    }
+};
+
+struct FramebufferTraits
+{
+    static GLuint create()
+    {
+        GLuint id = 0;
+        glGenFramebuffers(1, &id);
+        return id;
+    }
+
+    static void destroy(GLuint i_id)
+    {
+        utils::GLStateCache::getInstance().onFramebufferDeleted(i_id);
+        glDeleteFramebuffers(1, &i_id);
+    }
+};
+
+struct ProgramTraits
+{
+    static GLuint create()
+    {
+        return glCreateProgram();
+    }
+
+    static void destroy(GLuint i_id)
+    {
+        utils::GLStateCache::getInstance().onProgramDeleted(i_id);
+        glDeleteProgram(i_id);
+    }
+};
+
+using VertexArrayHandle = GLObject<VertexArrayTraits>;
+using BufferHandle = GLObject<BufferTraits>;
+using TextureHandle = GLObject<TextureTraits>;
+using FramebufferHandle = GLObject<FramebufferTraits>;
+using ProgramHandle = GLObject<ProgramTraits>;
+}
+
+#endif // __GL_OBJECT_HPP__
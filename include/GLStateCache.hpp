@@ -0,0 +1,94 @@
+#ifndef __GL_STATE_CACHE_HPP__
+#define __GL_STATE_CACHE_HPP__
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace utils
+{
+struct GLStateStats
+{
+    std::size_t d_issuedCalls = 0;
+    std::size_t d_skippedCalls = 0;
+};
+
+// Shadows the GL state this codebase changes and drops calls that would set what is already set.
+// All state changes of the context thread have to go through it, otherwise invalidate() has to be called afterwards.
+// Element array buffer bindings are part of the VAO, so they are passed through untracked.
+class GLStateCache
+{
+public:
+    GLStateCache(const GLStateCache&) = delete;
+    GLStateCache& operator=(const GLStateCache&) = delete;
+
+    // the application has a single context
+    static GLStateCache& getInstance();
+
+    void useProgram(GLuint i_program);
+    void bindVertexArray(GLuint i_vertexArray);
+    // both the draw and the read framebuffer
+    void bindFramebuffer(GLuint i_framebuffer);
+    // one of them, e.g. for glBlitFramebuffer
+    void bindDrawFramebuffer(GLuint i_framebuffer);
+    void bindReadFramebuffer(GLuint i_framebuffer);
+    void bindBuffer(GLenum i_target, GLuint i_buffer);
+    // indexed bindings are set once per buffer, they are not tracked, only the generic binding they also change
+    void bindBufferBase(GLenum i_target, GLuint i_index, GLuint i_buffer);
+    // i_unit is the index, not GL_TEXTURE0 + index
+    void bindTexture(GLuint i_unit, GLenum i_target, GLuint i_texture);
+    void activeTexture(GLuint i_unit);
+
+    void setDepthTest(bool i_isEnabled);
+    void setDepthMask(bool i_isEnabled);
+    void setDepthFunc(GLenum i_func);
+    void setBlend(bool i_isEnabled);
+    void setBlendFunc(GLenum i_source, GLenum i_destination);
+    void setViewport(GLint i_x, GLint i_y, GLsizei i_width, GLsizei i_height);
+
+    // deleting a bound object resets the binding to 0 in GL, and the name can be reused
+    void onProgramDeleted(GLuint i_program);
+    void onVertexArrayDeleted(GLuint i_vertexArray);
+    void onFramebufferDeleted(GLuint i_framebuffer);
+    void onBufferDeleted(GLuint i_buffer);
+    void onTextureDeleted(GLuint i_texture);
+
+    // forgets everything, the next call of each kind is issued
+    void invalidate();
+
+    const utils::GLStateStats& getStats() const;
+    void resetStats();
+
+private:
+    GLStateCache();
+
+    bool isRedundant(bool i_isSame);
+
+    static constexpr GLuint UNKNOWN = ~GLuint(0);
+    static constexpr std::size_t BUFFER_TARGETS_COUNT = 7;
+    static constexpr std::size_t TEXTURE_TARGETS_COUNT = 4;
+    static constexpr std::size_t TEXTURE_UNITS_COUNT = 32;
+
+    GLuint d_program;
+    GLuint d_vertexArray;
+    GLuint d_drawFramebuffer;
+    GLuint d_readFramebuffer;
+    std::array<GLuint, BUFFER_TARGETS_COUNT> d_buffers;
+    std::array<std::array<GLuint, TEXTURE_TARGETS_COUNT>, TEXTURE_UNITS_COUNT> d_textures;
+    GLuint d_activeTextureUnit;
+
+    // -1 unknown, 0 disabled, 1 enabled
+    std::int8_t d_isDepthTestEnabled;
+    std::int8_t d_isDepthMaskEnabled;
+    std::int8_t d_isBlendEnabled;
+    GLenum d_depthFunc;
+    std::array<GLenum, 2> d_blendFunc;
+    std::array<GLint, 4> d_viewport;
+
+    utils::GLStateStats d_stats;
+};
+}
+
+#endif // __GL_STATE_CACHE_HPP__
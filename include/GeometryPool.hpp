@@ -0,0 +1,55 @@
+#ifndef __GEOMETRY_POOL_HPP__
+#define __GEOMETRY_POOL_HPP__
+
+#include "GLObject.hpp"
+#include "VertexFormat.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <span>
+
+namespace utils
+{
+// Location of a mesh's geometry in GPU buffers, drawn with glDrawElementsBaseVertex
+struct GeometryRange
+{
+    GLuint d_VAO = 0;
+    GLint d_baseVertex = 0;
+    size_t d_indexOffset = 0; // in bytes
+    GLsizei d_indicesCount = 0;
+    GLenum d_indexType = GL_UNSIGNED_INT;
+};
+
+// One vertex buffer and one index buffer behind a single VAO, meshes are suballocated from them.
+// Indices of every mesh stay local to it, base vertex offsets them at draw time,
+// so meshes with few vertices keep their 16-bit indices.
+class GeometryPool
+{
+public:
+    explicit GeometryPool(utils::VertexFormat i_vertexFormat, size_t i_vertexCapacity = 4 << 20, size_t i_indexCapacity = 1 << 20);
+
+    // i_vertices must already be in the pool's vertex format; the buffers grow when full
+    utils::GeometryRange allocate(std::span<const std::byte> i_vertices, std::span<const std::byte> i_indices, GLenum i_indexType);
+
+    GLuint getVAO() const;
+    utils::VertexFormat getVertexFormat() const;
+    size_t getUsedBytes() const;
+
+private:
+    void grow(utils::BufferHandle& io_buffer, GLenum i_target, size_t& io_capacity, size_t i_usedBytes, size_t i_requiredBytes);
+
+    utils::VertexFormat d_vertexFormat;
+
+    utils::VertexArrayHandle d_VAO;
+    utils::BufferHandle d_VBO;
+    utils::BufferHandle d_EBO;
+
+    size_t d_vertexCapacity;
+    size_t d_indexCapacity;
+    size_t d_vertexBytesUsed = 0;
+    size_t d_indexBytesUsed = 0;
+};
+}
+
+#endif // __GEOMETRY_POOL_HPP__
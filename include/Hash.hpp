@@ -0,0 +1,45 @@
+#ifndef __HASH_HPP__
+#define __HASH_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace utils
+{
+static constexpr std::uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+static constexpr std::uint64_t FNV_PRIME = 0x100000001b3ull;
+
+// 64-bit FNV-1a, stable across runs and platforms so it can be used in on-disk keys
+constexpr std::uint64_t fnv1a(std::string_view i_data, std::uint64_t i_seed = FNV_OFFSET_BASIS)
+{
+    std::uint64_t hash = i_seed;
+    for (const char c : i_data)
+    {
+        hash ^= static_cast<std::uint8_t>(c);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// string literals and char buffers, up to their terminator; with a seed they would convert to the const void* overload instead
+template <std::size_t Size>
+constexpr std::uint64_t fnv1a(const char (&i_data)[Size], std::uint64_t i_seed = FNV_OFFSET_BASIS)
+{
+    return fnv1a(std::string_view(i_data), i_seed);
+}
+
+inline std::uint64_t fnv1a(const void* i_data, std::size_t i_size, std::uint64_t i_seed = FNV_OFFSET_BASIS)
+{
+    std::uint64_t hash = i_seed;
+    const auto* bytes = static_cast<const std::uint8_t*>(i_data);
+    for (std::size_t i = 0; i < i_size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+}
+
+#endif // __HASH_HPP__
@@ -0,0 +1,54 @@
+#ifndef __INSTANCE_BUFFER_HPP__
+#define __INSTANCE_BUFFER_HPP__
+
+#include "GLObject.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace utils
+{
+// attribute locations of the per-instance data in vertex.vs with INSTANCED, the matrix takes four of them
+static constexpr GLuint INSTANCE_TRANSFORM_LOCATION = 3;
+static constexpr GLuint INSTANCE_DATA_LOCATION = 7;
+
+struct InstanceData
+{
+    glm::mat4 d_transform;
+    glm::vec4 d_data; // free for the shader, e.g. a tint
+};
+
+// Per-instance transforms and data in a vertex buffer, read with a divisor of 1 by instanced draws.
+// Static sets are uploaded once and drawn every frame, the buffer is reallocated only when it has to grow.
+class InstanceBuffer
+{
+public:
+    InstanceBuffer();
+
+    // i_data is optional, missing entries are zero
+    void update(std::span<const glm::mat4> i_transforms, std::span<const glm::vec4> i_data = {});
+
+    // points the instance attributes of the bound VAO to this buffer, disableAttributes() restores the VAO
+    void enableAttributes() const;
+    static void disableAttributes();
+
+    size_t getInstancesCount() const;
+    // translations of the instances, kept on the CPU for LOD selection
+    std::span<const glm::vec3> getPositions() const;
+    // largest scale of any instance transform
+    float getMaxScale() const;
+
+private:
+    utils::BufferHandle d_buffer;
+    size_t d_capacity = 0; // in instances
+    std::vector<utils::InstanceData> d_staging;
+    std::vector<glm::vec3> d_positions;
+    float d_maxScale = 0.0f;
+};
+}
+
+#endif // __INSTANCE_BUFFER_HPP__
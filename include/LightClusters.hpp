@@ -0,0 +1,115 @@
+#ifndef __LIGHT_CLUSTERS_HPP__
+#define __LIGHT_CLUSTERS_HPP__
+
+#include "GLObject.hpp"
+#include "UniformBlocks.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace utils
+{
+// past this distance a light adds less than 1/256 of its brightest color, the shaders don't evaluate it there
+float getLightRange(const utils::PointLightUniforms& i_light);
+float getLightRange(const utils::SpotLightUniforms& i_light);
+
+struct LightClustersStats
+{
+    std::size_t d_lightsCount = 0;
+    std::size_t d_visibleLightsCount = 0; // inside the view frustum
+    std::size_t d_lightIndicesCount = 0;
+    std::size_t d_maxClusterLights = 0;
+    std::size_t d_droppedLights = 0;      // over the per-cluster limit
+    double d_buildMilliseconds = 0.0;
+};
+
+// Bins point and spot lights into clusters: the view frustum split into screen tiles and exponentially growing depth slices,
+// so a fragment only evaluates the lights whose range reaches its cluster.
+// Every light is bounded by a view space sphere, a slice takes the lights overlapping its depth range in the tiles
+// the sphere's bounding box covers between the slice's planes; conservative, a light can land in clusters it misses.
+// The slices are binned concurrently on the thread pool. No GL calls, LightClusterBuffers uploads the result.
+class LightClusters
+{
+public:
+    // a cluster keeps at most i_maxClusterLights lights, the first ones by index
+    explicit LightClusters(const glm::uvec3& i_gridSize = glm::uvec3(16, 9, 24), std::uint32_t i_maxClusterLights = 256);
+
+    // i_projection has to be a perspective projection (glm::perspective), its field of view and planes define the grid;
+    // the lights are indexed point lights first, then spot lights
+    void build(const glm::mat4& i_view, const glm::mat4& i_projection, std::span<const utils::PointLightUniforms> i_pointLights,
+               std::span<const utils::SpotLightUniforms> i_spotLights);
+
+    const glm::uvec3& getGridSize() const;
+    std::uint32_t getMaxClusterLights() const;
+    // offset into getLightIndices() and count of every cluster's lights, x fastest, then y, then the depth slice
+    std::span<const glm::uvec2> getClusters() const;
+    std::span<const std::uint32_t> getLightIndices() const;
+    // what the shaders need to find a fragment's cluster, i_viewportSize in pixels
+    utils::ClusterUniforms getUniforms(const glm::vec2& i_viewportSize) const;
+
+    const utils::LightClustersStats& getStats() const;
+
+private:
+    // depth slice of a positive view space depth, clamped to the grid
+    std::uint32_t getSlice(float i_depth) const;
+    void binSlice(std::uint32_t i_slice);
+
+    glm::uvec3 d_gridSize;
+    std::uint32_t d_maxClusterLights;
+    // of the last build's projection
+    glm::vec2 d_tanHalfFov{ 1.0f };
+    float d_near = 0.1f;
+    float d_far = 100.0f;
+    float d_sliceScale = 0.0f;
+    float d_sliceBias = 0.0f;
+    std::vector<float> d_sliceDepths; // the planes between the slices, from the near plane to the far one
+
+    std::vector<glm::vec4> d_lightSpheres;  // view space center, radius
+    std::vector<glm::uvec2> d_lightSlices;  // first and last slice, first > last if the light is outside the depth range
+    std::vector<std::vector<std::uint32_t>> d_clusterLights; // per cluster, reused between builds
+    std::vector<glm::uvec2> d_clusters;
+    std::vector<std::uint32_t> d_lightIndices;
+    utils::LightClustersStats d_stats;
+};
+
+// The texture buffers and the uniform block the CLUSTERED_LIGHTS shader variants read the binned lights from
+// (GL 3.3 has no storage buffers); they are bound to their fixed units, see UNIFORM_SAMPLERS, for their whole lifetime.
+class LightClusterBuffers
+{
+public:
+    // throws if the GL's texture buffers can't hold the worst case of i_clusters
+    explicit LightClusterBuffers(const utils::LightClusters& i_clusters);
+
+    // uploads the lights i_clusters was built from and its clusters; throws if there are more than getMaxLightsCount() lights
+    void update(const utils::LightClusters& i_clusters, std::span<const utils::PointLightUniforms> i_pointLights,
+                std::span<const utils::SpotLightUniforms> i_spotLights, const glm::vec2& i_viewportSize);
+
+    // point and spot lights together, about 13k with the GL 3.3 minimum of 65536 texels per texture buffer
+    std::size_t getMaxLightsCount() const;
+
+private:
+    struct TextureBuffer
+    {
+        utils::BufferHandle d_buffer;
+        utils::TextureHandle d_texture;
+    };
+
+    static TextureBuffer createTextureBuffer(GLuint i_unit, GLenum i_format);
+    // orphans the previous contents, the GPU may still read them
+    static void upload(const TextureBuffer& i_textureBuffer, std::span<const std::byte> i_bytes);
+
+    TextureBuffer d_lights;       // RGBA32F, 5 texels per light
+    TextureBuffer d_ranges;       // RG32UI, offset and count per cluster
+    TextureBuffer d_lightIndices; // R32UI
+    utils::UniformBuffer d_uniforms;
+    std::vector<glm::vec4> d_packedLights;
+    std::size_t d_maxLightsCount = 0;
+};
+}
+
+#endif // __LIGHT_CLUSTERS_HPP__
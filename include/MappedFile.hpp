@@ -0,0 +1,39 @@
+#ifndef __MAPPED_FILE_HPP__
+#define __MAPPED_FILE_HPP__
+
+#include <cstddef>
+#include <filesystem>
+
+namespace utils
+{
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path& i_path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& io_other) noexcept;
+    MappedFile& operator=(MappedFile&& io_other) noexcept;
+
+    const std::byte* getData() const;
+    std::size_t getSize() const;
+
+private:
+    void release();
+
+    const std::byte* d_data = nullptr;
+    std::size_t d_size = 0;
+#ifdef _WIN32
+    void* d_fileHandle = nullptr;
+    void* d_mappingHandle = nullptr;
+#endif
+};
+
+// a path next to i_path that no other thread or process writes to at the same time, for files that are renamed to i_path once complete
+std::filesystem::path getTemporaryPath(const std::filesystem::path& i_path);
+}
+
+#endif // __MAPPED_FILE_HPP__
@@ -2,9 +2,21 @@
 #define __MESH_HPP__
 
 #include "UtilsFwd.hpp"
+#include "Bounds.hpp"
+#include "GeometryPool.hpp"
+#include "GLObject.hpp"
+#include "ShaderVariants.hpp"
+#include "ShadersManager.hpp"
+#include "TextureArray.hpp"
+#include "VertexFormat.hpp"
 
+#include <assimp/material.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
 #include <vector>
 
 namespace utils
@@ -16,21 +28,105 @@ struct Vertex
 	glm::vec2 d_texCoords;
 };
 
+struct TextureRef
+{
+	aiTextureType d_type;
+	std::string d_path;
+};
+
+// Part of a mesh's indices drawing one level of detail, LOD 0 is the full resolution mesh
+struct LodRange
+{
+	std::uint32_t d_indexOffset;
+	std::uint32_t d_indicesCount;
+	float d_error; // deviation from LOD 0 in model units
+};
+
+// CPU-side geometry of a single mesh, before it is uploaded to the GPU
+struct MeshData
+{
+	std::vector<utils::Vertex> d_vertices;
+	std::vector<unsigned int> d_indices; // indices of all LODs one after another
+	std::vector<utils::TextureRef> d_textures;
+	std::vector<utils::LodRange> d_lods;
+	utils::Bounds d_bounds;
+	std::uint32_t d_node = 0; // transform graph node the mesh is attached to
+};
+
+// What a mesh samples, 2D textures or layers of texture arrays (drawn with the SHADER_TEXTURE_ARRAY variants)
+struct MeshMaterial
+{
+	std::vector<std::shared_ptr<utils::Texture>> d_textures;
+	std::vector<utils::TextureLayer> d_layers;
+};
+
+// Non-owning view of a mesh's geometry, either in MeshData or in a mapped cache file
+struct MeshView
+{
+	std::span<const utils::Vertex> d_vertices;
+	std::span<const unsigned int> d_indices;
+	std::vector<utils::TextureRef> d_textures;
+	std::span<const utils::LodRange> d_lods;
+	utils::Bounds d_bounds;
+	std::uint32_t d_node = 0;
+};
+
+// Move-only, owns its GL buffers unless they come from a GeometryPool.
+// Drawing only needs the GPU buffers, the CPU copy of the geometry can be dropped with i_keepCpuGeometry.
 class Mesh
 {
 public:
-	Mesh(const std::vector<utils::Vertex>& i_vertices, const std::vector<unsigned int>& i_indices, const std::vector<utils::Texture>& i_textures);
-	void Draw(const utils::ShadersManager& i_shaderManager);
-	~Mesh();
+	Mesh(const utils::MeshView& i_mesh, utils::MeshMaterial i_material, utils::VertexFormat i_vertexFormat = utils::VertexFormat::Float,
+		 bool i_keepCpuGeometry = true);
+	// suballocates the geometry from the pool instead of creating its own buffers
+	Mesh(const utils::MeshView& i_mesh, utils::MeshMaterial i_material, utils::GeometryPool& io_geometryPool, bool i_keepCpuGeometry = true);
+	void Draw(const utils::ShadersManager& i_shaderManager, size_t i_lod = 0);
+	// draws every instance of the buffer in one call, for shaders reading the instance attributes (vertex.vs with SHADER_INSTANCED)
+	void DrawInstanced(const utils::ShadersManager& i_shaderManager, const utils::InstanceBuffer& i_instances, size_t i_lod = 0);
+
+	// the steps of Draw() for callers that skip redundant state changes (RenderQueue):
+	// binds the textures and sets their sampler uniforms
+	void bindMaterial(const utils::ShadersManager& i_shaderManager) const;
+	// sets the per-mesh uniforms (transform of the positions, texture layers) and draws, getVAO() has to be bound
+	void drawElements(const utils::ShadersManager& i_shaderManager, size_t i_lod) const;
+	GLuint getVAO() const;
+	// equal for meshes with the same textures, or the same texture arrays whatever layers they sample
+	std::uint64_t getMaterialHash() const;
+	// the features of the material a shader variant needs, e.g. SHADER_SPECULAR_MAP or SHADER_TEXTURE_ARRAY
+	utils::ShaderFeatures getShaderFeatures() const;
+
+	// a mesh without generated LODs has a single one covering all of its indices
+	size_t getLodsCount() const;
+	const utils::LodRange& getLod(size_t i_lod) const;
+	const utils::Bounds& getBounds() const;
+
+	// size of the vertex and index buffers on the GPU
+	size_t getGeometryBytes() const;
+	// size of the geometry copy kept in RAM
+	size_t getCpuGeometryBytes() const;
 
 private:
+	void setPositionTransform(const utils::ShadersManager& i_shaderManager) const;
+	void setTextureLayers(const utils::ShadersManager& i_shaderManager) const;
+
 	std::vector<utils::Vertex> d_vertices;
 	std::vector<unsigned int> d_indices;
-	std::vector<utils::Texture> d_textures;
+	utils::MeshMaterial d_material;
+	std::uint64_t d_materialHash;
+	std::vector<utils::UniformId> d_samplerUniforms; // one per texture or layer
+	std::vector<utils::UniformId> d_layerUniforms;   // one per layer
+	utils::ShaderFeatures d_shaderFeatures;
+	std::vector<utils::LodRange> d_lods;
+	utils::Bounds d_bounds;
+
+	utils::PositionTransform d_positionTransform;
+	utils::GeometryRange d_geometry;
+	size_t d_geometryBytes = 0;
 
-	unsigned int d_VAO = 0;
-	unsigned int d_VBO = 0;
-	unsigned int d_EBO = 0;
+	// only set when the mesh owns its buffers
+	utils::VertexArrayHandle d_VAO;
+	utils::BufferHandle d_VBO;
+	utils::BufferHandle d_EBO;
 };
 }
 
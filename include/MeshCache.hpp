@@ -0,0 +1,48 @@
+#ifndef __MESH_CACHE_HPP__
+#define __MESH_CACHE_HPP__
+
+#include "Mesh.hpp"
+#include "MappedFile.hpp"
+#include "TransformGraph.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace utils
+{
+// On-disk cache of the flattened meshes of a model.
+// Entries are keyed by the source path, its modification time, the import flags
+// and a hash of any other settings the stored meshes depend on (e.g. LOD generation),
+// so editing the asset or changing the import pipeline invalidates them.
+class MeshCache
+{
+public:
+    MeshCache(const std::filesystem::path& i_sourcePath, unsigned int i_importFlags, std::uint64_t i_settingsHash = 0);
+
+    // maps the cache file, returns false if it is missing or stale;
+    // the views point straight into the mapping and live as long as the cache
+    bool load();
+    const std::vector<utils::MeshView>& getMeshes() const;
+    std::span<const utils::TransformNode> getNodes() const;
+
+    void store(std::span<const utils::MeshData> i_meshes, std::span<const utils::TransformNode> i_nodes) const;
+    // deletes the cache file, the next load() of the source misses
+    void invalidate();
+
+private:
+    std::filesystem::path d_sourcePath;
+    std::filesystem::path d_cachePath;
+    unsigned int d_importFlags;
+    std::uint64_t d_settingsHash;
+    std::int64_t d_sourceTime = 0;
+
+    std::optional<utils::MappedFile> d_file;
+    std::vector<utils::MeshView> d_meshes;
+    std::span<const utils::TransformNode> d_nodes;
+};
+}
+
+#endif // __MESH_CACHE_HPP__
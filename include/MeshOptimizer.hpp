@@ -0,0 +1,51 @@
+#ifndef __MESH_OPTIMIZER_HPP__
+#define __MESH_OPTIMIZER_HPP__
+
+#include "Mesh.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace utils
+{
+// Post-transform vertex cache statistics, counters are kept so stats of several meshes can be summed up
+struct VertexCacheStats
+{
+    std::size_t d_transformedCount = 0;
+    std::size_t d_trianglesCount = 0;
+    std::size_t d_verticesCount = 0;
+
+    float getAcmr() const; // average cache miss ratio, transformed vertices per triangle (0.5 - 3)
+    float getAtvr() const; // average transformed to vertex ratio (1 is optimal)
+
+    VertexCacheStats& operator+=(const VertexCacheStats& i_other);
+};
+
+struct MeshOptimizationStats
+{
+    VertexCacheStats d_before;
+    VertexCacheStats d_after;
+};
+
+// simulates a FIFO post-transform cache of the given size
+VertexCacheStats analyzeVertexCache(std::span<const unsigned int> i_indices, std::size_t i_verticesCount, std::size_t i_cacheSize = 16);
+
+// merges bitwise identical vertices and remaps the indices
+void weldVertices(utils::MeshData& io_mesh);
+
+// reorders triangles for post-transform cache locality (Forsyth's linear-speed algorithm)
+std::vector<unsigned int> optimizeVertexCache(std::span<const unsigned int> i_indices, std::size_t i_verticesCount);
+
+// reorders clusters of cache-optimized triangles so outward facing ones come first,
+// the result is only kept if its ACMR stays within i_threshold of the input
+std::vector<unsigned int> optimizeOverdraw(std::span<const unsigned int> i_indices, std::span<const utils::Vertex> i_vertices, float i_threshold = 1.05f);
+
+// reorders vertices in the order the indices first reference them and drops unreferenced ones
+void optimizeVertexFetch(utils::MeshData& io_mesh);
+
+// runs all of the above
+MeshOptimizationStats optimizeMesh(utils::MeshData& io_mesh);
+}
+
+#endif // __MESH_OPTIMIZER_HPP__
@@ -0,0 +1,24 @@
+#ifndef __MESH_SIMPLIFIER_HPP__
+#define __MESH_SIMPLIFIER_HPP__
+
+#include "Mesh.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace utils
+{
+// Quadric error edge collapse. Vertices are only ever collapsed onto other existing vertices,
+// so the result indexes the same vertex buffer. Border vertices (including UV seams) never move.
+// Stops once the index count reaches i_targetIndicesCount or the next collapse would exceed i_targetError,
+// which is relative to the mesh extent. o_resultError receives the reached error in model units.
+std::vector<unsigned int> simplifyMesh(std::span<const utils::Vertex> i_vertices, std::span<const unsigned int> i_indices,
+                                       std::size_t i_targetIndicesCount, float i_targetError, float* o_resultError = nullptr);
+
+// Appends up to i_lodsCount - 1 simplified versions of LOD 0 to io_mesh.d_indices,
+// each with about i_reduction of the previous LOD's triangles, and fills io_mesh.d_lods
+void generateLods(utils::MeshData& io_mesh, std::size_t i_lodsCount, float i_reduction = 0.5f, float i_maxError = 0.05f);
+}
+
+#endif // __MESH_SIMPLIFIER_HPP__
@@ -2,33 +2,148 @@
 #define __MODEL_HPP__
 
 #include "UtilsFwd.hpp"
+#include "Frustum.hpp"
+#include "ShaderVariants.hpp"
+#include "TextureArray.hpp"
+#include "TransformGraph.hpp"
+#include "VertexFormat.hpp"
 
 #include <assimp/scene.h>
+#include <glm/glm.hpp>
 
-
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
+#include <utility>
 #include <filesystem>
 #include "unordered_map"
 
 namespace utils
 {
+class Camera;
+class GeometryPool;
+class TextureResidency;
+class TextureStreamer;
+class UploadQueue;
+
+struct ModelOptions
+{
+	utils::VertexFormat d_vertexFormat = utils::VertexFormat::Float;
+
+	// suballocate all meshes from one vertex and index buffer behind a single VAO,
+	// d_geometryPool shares a pool between models (its vertex format wins), otherwise the model creates its own
+	bool d_useGeometryPool = false;
+	utils::GeometryPool* d_geometryPool = nullptr;
+
+	// free the CPU copy of every mesh's geometry once it is uploaded
+	bool d_releaseCpuGeometry = false;
+
+	// textures are block compressed (BC1/BC3/BC4/BC5) with all their mips, the results are cached on disk;
+	// formats the GL can't sample stay uncompressed
+	bool d_compressTextures = false;
+	// block compressed textures are created with only their small mips, the streamer uploads the others over the next frames;
+	// it has to outlive the model
+	utils::TextureStreamer* d_textureStreamer = nullptr;
+	// textures are reduced to lower mips when the budget is exceeded and reloaded from their files when used again;
+	// it has to outlive the model
+	utils::TextureResidency* d_textureResidency = nullptr;
+	// textures of one size and format are packed into the layers of texture arrays, so meshes with different materials
+	// share their bindings and are drawn with the SHADER_TEXTURE_ARRAY variants; the arrays belong to the model,
+	// they are neither streamed, reduced nor shared with other models
+	bool d_packTextures = false;
+
+	// LOD chain generated at import, every LOD keeps about d_lodReduction of the previous one's triangles
+	// and deviates at most d_lodMaxError (relative to the mesh size) from it; 1 disables LODs
+	size_t d_lodsCount = 4;
+	float d_lodReduction = 0.5f;
+	float d_lodMaxError = 0.02f;
+	// the coarsest LOD whose error projects to at most this many pixels on screen is drawn
+	float d_lodPixelError = 1.0f;
+};
+
 class Model
 {
 public:
-	Model(std::string_view i_path);
-	void Draw(const utils::ShadersManager& i_shaders);
+	Model(std::string_view i_path, const utils::ModelOptions& i_options = {});
+	~Model();
+
+	// returns immediately, the import and texture decoding run on the thread pool
+	// and the GL uploads are queued to io_uploadQueue, which must be processed on the context thread;
+	// the model draws nothing until all of its meshes are resident
+	static std::shared_ptr<Model> loadAsync(std::string_view i_path, utils::UploadQueue& io_uploadQueue, const utils::ModelOptions& i_options = {});
+	// deletes the mesh cache entry of the file, its next load imports it with Assimp again
+	static void invalidateMeshCache(std::string_view i_path);
+
+	// sets the "model" uniform and draws every mesh inside the camera frustum at the LOD its distance to the camera allows;
+	// a mesh is placed by i_modelMatrix * the world transform of its node
+	void Draw(const utils::ShadersManager& i_shaders, const utils::Camera& i_camera, const glm::mat4& i_modelMatrix);
+	// same selection, but the draws are pushed to io_queue, which sorts them with the rest of the frame
+	void Draw(utils::RenderQueue& io_queue, const utils::ShadersManager& i_shaders, const utils::Camera& i_camera, const glm::mat4& i_modelMatrix);
+	// every mesh is drawn with the variant for i_sceneFeatures (the lights) and the features of its material
+	void Draw(utils::RenderQueue& io_queue, utils::ShaderVariants& io_variants, utils::ShaderFeatures i_sceneFeatures, const utils::Camera& i_camera,
+			  const glm::mat4& i_modelMatrix);
+
+	// draws all instances with one instanced call per mesh, for shaders reading the instance attributes (vertex.vs with SHADER_INSTANCED);
+	// instances are not culled and every mesh uses the LOD its closest instance needs
+	void DrawInstanced(const utils::ShadersManager& i_shaders, const utils::Camera& i_camera, const utils::InstanceBuffer& i_instances);
+	// uploads the transforms (and optional data) to the model's own instance buffer first, static sets should rather keep their own buffer
+	void DrawInstanced(const utils::ShadersManager& i_shaders, const utils::Camera& i_camera, std::span<const glm::mat4> i_transforms,
+					   std::span<const glm::vec4> i_instanceData = {});
+
+	// the node hierarchy of the source file, parts are moved by changing the local transforms of their nodes
+	utils::TransformGraph& getTransforms();
+
+	bool isResident() const;
+	// whether the meshes were mapped from the mesh cache instead of imported
+	bool isMeshCacheHit() const;
+	size_t getGeometryBytes() const;
+	size_t getCpuGeometryBytes() const;
 
 private:
-	std::vector<utils::Mesh> d_meshes;
+	struct ImportedScene;
+
+	Model(const std::filesystem::path& i_directory, const utils::ModelOptions& i_options);
+
+	utils::ModelOptions d_options;
+	std::unique_ptr<utils::GeometryPool> d_ownGeometryPool;
+	std::vector<std::shared_ptr<utils::Mesh>> d_meshes; // shared with other models through the AssetRegistry
+	std::vector<std::uint32_t> d_meshNodes;
+	utils::TransformGraph d_transforms;
+	std::unique_ptr<utils::InstanceBuffer> d_instanceBuffer;
+	utils::AabbBatch d_meshBounds;
+	std::vector<std::uint8_t> d_meshVisibility;
 	std::filesystem::path d_directory;
-	std::unordered_map<std::string, utils::Texture> d_loadedTextures;
+	std::unordered_map<std::string, std::shared_ptr<utils::Texture>> d_loadedTextures;
+	std::unordered_map<std::string, utils::TextureLayer> d_textureLayers; // by path, see ModelOptions::d_packTextures
+	std::atomic<bool> d_isResident = false;
+	std::atomic<bool> d_isMeshCacheHit = false;
+	std::atomic<bool> d_isCancelled = false;
+	std::future<void> d_loadingTask;
 
-	void processNode(aiNode& i_node, const aiScene& i_scene);
-	utils::Mesh processMesh(aiMesh& i_mesh, const aiScene& i_scene);
+	// imports the meshes and decodes their textures, only the GL uploads are left for the context thread
+	std::unique_ptr<ImportedScene> importScene(std::string_view i_path) const;
+	// decodes every texture the meshes use once, concurrently on the thread pool
+	void decodeTextures(std::string_view i_path, ImportedScene& io_scene) const;
+	// uploads the decoded textures as layers of texture arrays, one array per size and format
+	void packTextures(std::string_view i_path, ImportedScene& io_scene);
+	void processNode(aiNode& i_node, const aiScene& i_scene, std::uint32_t i_parent, std::vector<utils::TransformNode>& o_nodes,
+					 std::vector<std::pair<aiMesh*, std::uint32_t>>& o_meshes) const;
+	utils::MeshData processMesh(aiMesh& i_mesh, const aiScene& i_scene) const;
 
-	std::vector<utils::Texture> loadMaterialTextures(aiMaterial& i_material, aiTextureType i_textureType);
+	std::vector<utils::TextureRef> loadMaterialTextures(aiMaterial& i_material, aiTextureType i_textureType) const;
+	// the registered mesh with the same geometry and material, otherwise a new one
+	std::shared_ptr<utils::Mesh> createMesh(const utils::MeshView& i_mesh, std::uint64_t i_meshHash);
+	void updateTransforms();
+	// calls i_draw(mesh, meshMatrix, lod, distance) for every mesh inside the camera frustum
+	template <typename DrawFunc>
+	void forEachVisibleMesh(const utils::Camera& i_camera, const glm::mat4& i_modelMatrix, DrawFunc&& i_draw);
+	// i_distance is from the camera to the mesh's bounding sphere, i_scale the mesh's largest scale in world space
+	size_t selectLod(const utils::Mesh& i_mesh, float i_distance, float i_scale, float i_pixelsPerUnit) const;
 };
 }
 
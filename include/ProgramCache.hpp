@@ -0,0 +1,45 @@
+#ifndef __PROGRAM_CACHE_HPP__
+#define __PROGRAM_CACHE_HPP__
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace utils
+{
+// On-disk cache of linked program binaries (ARB_get_program_binary).
+// Entries are keyed by a hash of the shader sources and of the driver vendor, renderer and version,
+// so editing a shader or updating the driver invalidates them.
+class ProgramCache
+{
+public:
+    explicit ProgramCache(std::uint64_t i_sourcesHash);
+
+    // false if the driver can't return program binaries, load() and store() do nothing then
+    static bool isSupported();
+
+    // loads the cached binary into i_program; false if it is missing, stale or rejected by the driver,
+    // the program has to be compiled and linked from source then
+    bool load(GLuint i_program);
+    // the program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT;
+    // i_buildMilliseconds is what compiling and linking took, loads report it as the time saved
+    void store(GLuint i_program, double i_buildMilliseconds) const;
+
+    // of the last successful load()
+    double getSavedMilliseconds() const;
+    // whether the last load() failed because the driver didn't accept the cached binary
+    bool isRejected() const;
+    // the entry's file, whether it exists or not
+    const std::filesystem::path& getCachePath() const;
+
+private:
+    std::uint64_t d_key;
+    std::filesystem::path d_cachePath;
+    double d_savedMilliseconds = 0.0;
+    bool d_isRejected = false;
+};
+}
+
+#endif // __PROGRAM_CACHE_HPP__
@@ -0,0 +1,70 @@
+#ifndef __RENDER_QUEUE_HPP__
+#define __RENDER_QUEUE_HPP__
+
+#include "UtilsFwd.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace utils
+{
+// state changes a submission order causes
+struct RenderQueueStats
+{
+    size_t d_drawsCount = 0;
+    size_t d_programChanges = 0;
+    size_t d_materialChanges = 0;
+    size_t d_vertexArrayChanges = 0;
+
+    bool operator==(const RenderQueueStats&) const = default;
+};
+
+// Collects the opaque draws of a frame and submits them sorted by a 64-bit key:
+//   program (8 bits) | material (16 bits) | vertex array (16 bits) | depth (24 bits)
+// so the draws sharing a program and textures are grouped, and go front to back inside a group for early depth rejection.
+// Submission only rebinds the state that differs from the previous draw.
+class RenderQueue
+{
+public:
+    // i_depth is the distance from the camera, i_mesh and i_shaders have to outlive the submission
+    void push(const utils::ShadersManager& i_shaders, const utils::Mesh& i_mesh, size_t i_lod, const glm::mat4& i_transform, float i_depth);
+
+    // sorts, draws and clears the queue
+    void submit();
+
+    // stats of the last submit() in the order the draws were pushed and in the sorted order
+    const utils::RenderQueueStats& getUnsortedStats() const;
+    const utils::RenderQueueStats& getSortedStats() const;
+
+private:
+    struct DrawItem
+    {
+        const utils::ShadersManager* d_shaders;
+        const utils::Mesh* d_mesh;
+        glm::mat4 d_transform;
+        size_t d_lod;
+    };
+
+    std::uint64_t makeKey(const utils::ShadersManager& i_shaders, const utils::Mesh& i_mesh, float i_depth);
+    utils::RenderQueueStats countStateChanges(const std::vector<std::uint32_t>& i_order) const;
+    void sortKeys();
+
+    std::vector<DrawItem> d_items;
+    std::vector<std::uint64_t> d_keys;
+    std::vector<std::uint32_t> d_order;   // item indices in submission order
+    std::vector<std::uint32_t> d_scratch; // radix sort ping-pong buffer
+
+    // dense ids keep the key fields small, they are stable for the lifetime of the queue
+    std::unordered_map<const utils::ShadersManager*, std::uint32_t> d_programIds;
+    std::unordered_map<std::uint64_t, std::uint32_t> d_materialIds;
+
+    utils::RenderQueueStats d_unsortedStats;
+    utils::RenderQueueStats d_sortedStats;
+};
+}
+
+#endif // __RENDER_QUEUE_HPP__
@@ -0,0 +1,58 @@
+#ifndef __SHADER_VARIANTS_HPP__
+#define __SHADER_VARIANTS_HPP__
+
+#include "UtilsFwd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace utils
+{
+// Bitmask of the features a variant is compiled with, every feature turns into a define of its sources
+using ShaderFeatures = std::uint32_t;
+
+static constexpr utils::ShaderFeatures SHADER_DIR_LIGHT = 1u << 0;         // DIR_LIGHT
+static constexpr utils::ShaderFeatures SHADER_SPOT_LIGHT = 1u << 1;        // SPOT_LIGHT
+static constexpr utils::ShaderFeatures SHADER_SPECULAR_MAP = 1u << 2;      // SPECULAR_MAP, the material has a specular texture
+static constexpr utils::ShaderFeatures SHADER_INSTANCED = 1u << 3;         // INSTANCED, reads the InstanceBuffer attributes
+static constexpr utils::ShaderFeatures SHADER_TEXTURE_ARRAY = 1u << 4;     // TEXTURE_ARRAY, the material samples layers of texture arrays
+static constexpr utils::ShaderFeatures SHADER_CLUSTERED_LIGHTS = 1u << 5;  // CLUSTERED_LIGHTS, the lights binned by LightClusters
+static constexpr utils::ShaderFeatures SHADER_DEFERRED_LIGHTING = 1u << 6; // DEFERRED_LIGHTING, shades the G-buffer, see DeferredRenderer
+// number of point lights to evaluate, POINT_LIGHTS_CNT
+static constexpr std::uint32_t SHADER_POINT_LIGHTS_SHIFT = 8;
+static constexpr utils::ShaderFeatures SHADER_POINT_LIGHTS_MASK = 0x7u << SHADER_POINT_LIGHTS_SHIFT;
+
+// the count is clamped to the size of the light block, see utils::POINT_LIGHTS_COUNT
+utils::ShaderFeatures makePointLightsFeature(size_t i_pointLightsCount);
+size_t getPointLightsCount(utils::ShaderFeatures i_features);
+
+// The programs built from one vertex and fragment source for the feature sets they are drawn with.
+// A variant is compiled the first time it is requested, or up front by prewarm(), and kept for the lifetime of the object,
+// so draws only pay for the features their material and the scene's lighting use. Variants are shared through the AssetRegistry.
+class ShaderVariants
+{
+public:
+    ShaderVariants(std::string_view i_vertexShaderPath, std::string_view i_fragmentShaderPath);
+    ~ShaderVariants();
+
+    const utils::ShadersManager& get(utils::ShaderFeatures i_features);
+    void prewarm(std::span<const utils::ShaderFeatures> i_features);
+
+    size_t getVariantsCount() const;
+
+private:
+    static std::vector<std::string> getDefines(utils::ShaderFeatures i_features);
+
+    std::string d_vertexShaderPath;
+    std::string d_fragmentShaderPath;
+    std::unordered_map<utils::ShaderFeatures, std::shared_ptr<utils::ShadersManager>> d_variants;
+};
+}
+
+#endif // __SHADER_VARIANTS_HPP__
@@ -1,31 +1,74 @@
 #ifndef __SHADERS_MANAGER_HPP__
 #define __SHADERS_MANAGER_HPP__
 
+#include "GLObject.hpp"
+#include "Hash.hpp"
+
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
+#include <span>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace utils
 {
+// Uniform name hashed at compile time, string literals convert to it implicitly;
+// names built at runtime go through fromName() once and are kept
+struct UniformId
+{
+    consteval UniformId(const char* i_name) : d_hash(utils::fnv1a(i_name)), d_name(i_name)
+    {
+    }
+
+    static UniformId fromName(std::string_view i_name)
+    {
+        return UniformId(utils::fnv1a(i_name));
+    }
+
+    std::uint64_t d_hash;
+    const char* d_name; // only known for literals, used in error messages
+
+private:
+    explicit UniformId(std::uint64_t i_hash) : d_hash(i_hash), d_name(nullptr)
+    {
+    }
+};
+
 class ShadersManager
 {
 public:
-    ShadersManager(std::string_view i_vertexShaderPath, std::string_view i_fragmentShaderPath);
+    // every define ("NAME" or "NAME VALUE") is added to both sources
+    ShadersManager(std::string_view i_vertexShaderPath, std::string_view i_fragmentShaderPath, std::span<const std::string> i_defines = {});
 
     void render() const;
 
     GLuint getId() const;
 
-    void setBool(const std::string& i_name, bool i_value) const;
-    void setInt(const std::string& i_name, int i_value) const;
-    void setFloat(const std::string& i_name, float i_value) const;
-    void setVec3(const std::string& i_name, const glm::vec3& i_vec) const;
-    void setMatrix4fv(const std::string& i_name, const glm::mat4& i_matrix) const;
+    // -1 for uniforms the program doesn't have (or the linker optimized away), GL ignores those
+    GLint getUniformLocation(utils::UniformId i_uniform) const;
+
+    // the program has to be in use; lookups go to the table reflected at link time, never to the driver
+    void setBool(utils::UniformId i_uniform, bool i_value) const;
+    void setInt(utils::UniformId i_uniform, int i_value) const;
+    void setFloat(utils::UniformId i_uniform, float i_value) const;
+    void setVec3(utils::UniformId i_uniform, const glm::vec3& i_vec) const;
+    void setMatrix4fv(utils::UniformId i_uniform, const glm::mat4& i_matrix) const;
 
 private:
-    GLuint d_programId;
+    struct UniformSlot
+    {
+        std::uint64_t d_hash = 0;
+        GLint d_location = -1;
+    };
+
+    void reflectUniforms();
 
+    utils::ProgramHandle d_program;
+    // open addressing with linear probing, the size is a power of two and at most half full
+    std::vector<UniformSlot> d_uniforms;
 };
 } // namespace utils
 
@@ -1,31 +1,99 @@
 #ifndef __TEXTURE_MANAGER_HPP__
 #define __TEXTURE_MANAGER_HPP__
 
+#include "GLObject.hpp"
+#include "TextureCompression.hpp"
+
 #include <glad/glad.h>
 
 #include <assimp/material.h>
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <variant>
+#include <vector>
 
 namespace utils
 {
+// Decoded pixels of an image file, can be produced off the GL thread
+struct ImageData
+{
+    struct Deleter
+    {
+        void operator()(unsigned char* i_pixels) const;
+    };
+
+    std::unique_ptr<unsigned char, Deleter> d_pixels;
+    int d_width = 0;
+    int d_height = 0;
+    int d_channels = 0;
+};
+
+ImageData loadImage(const std::string& i_imagePath);
+// GL_RED, GL_RGB or GL_RGBA, used as the internal format too
+GLenum getImageFormat(const ImageData& i_image);
+
+// what a texture is created from, the compressed image already holds its mips
+using TextureImage = std::variant<ImageData, CompressedImage>;
+
+// with i_compress the block compressed image from the texture cache, compressed and cached on a miss;
+// the decoded pixels if compression is off or the GL can't sample the format
+TextureImage loadTextureImage(const std::string& i_imagePath, bool i_compress);
+
 class Texture
 {
 public:
     Texture() = delete;
     Texture(const std::string& i_texturePath, aiTextureType i_textureType, GLenum i_wrapParam = GL_REPEAT);
     Texture(const std::string& i_texturePath, GLenum i_wrapParam);
+    Texture(const ImageData& i_image, aiTextureType i_textureType, GLenum i_wrapParam = GL_REPEAT);
+    Texture(const CompressedImage& i_image, aiTextureType i_textureType, GLenum i_wrapParam = GL_REPEAT);
+    Texture(const TextureImage& i_image, aiTextureType i_textureType, GLenum i_wrapParam = GL_REPEAT);
+    // only the levels from i_firstResidentLevel down to the smallest are defined and uploaded, the finer ones get their storage
+    // when they are streamed in (or reload() uploads them); sampling is clamped to the defined ones, see TextureStreamer
+    Texture(const CompressedImage& i_image, size_t i_firstResidentLevel, aiTextureType i_textureType, GLenum i_wrapParam = GL_REPEAT);
+
+    // uploads i_level of i_image from offset 0 of the bound GL_PIXEL_UNPACK_BUFFER and makes it the finest sampled one,
+    // it has to be the level right above the resident ones
+    void uploadStreamedLevel(const CompressedImage& i_image, size_t i_level);
+    // frees the levels finer than i_firstKeptLevel, sampling is clamped to the coarser ones; the smallest level is always kept
+    void dropLevels(size_t i_firstKeptLevel);
+    // uploads all levels again, e.g. after dropLevels(); the image has to be the one the texture was created from
+    void reload(const TextureImage& i_image);
 
     void activate(GLenum i_texUnit) const;
 
     GLuint getId() const;
     aiTextureType getType() const;
     std::string getTypeAsString() const;
+    // the name the shaders use for a type, "diffuse", "specular"
+    static std::string getTypeAsString(aiTextureType i_textureType);
+    // the finest mip that can be sampled, 0 once the texture is complete
+    size_t getResidentLevel() const;
+    size_t getLevelsCount() const;
+    // video memory of the resident levels
+    size_t getGpuBytes() const;
+
+    // the frame of the last activate(), frames are counted by TextureResidency
+    std::uint64_t getLastUsedFrame() const;
+    static std::uint64_t getCurrentFrame();
+    static void setCurrentFrame(std::uint64_t i_frame);
 
 private:
-    GLuint d_texId;
+    // binds the new texture and sets its sampling parameters
+    void prepare(GLenum i_wrapParam);
+    void upload(const ImageData& i_image);
+    void upload(const CompressedImage& i_image);
+
+    utils::TextureHandle d_texId;
     aiTextureType d_textureType;
+    size_t d_residentLevel = 0;
+    std::vector<size_t> d_levelBytes; // 0 for the levels that are not resident
+    GLenum d_internalFormat = GL_RGBA;
+    bool d_isCompressed = false;
+    mutable std::uint64_t d_lastUsedFrame = getCurrentFrame();
 };
 
 
@@ -0,0 +1,54 @@
+#ifndef __TEXTURE_ARRAY_HPP__
+#define __TEXTURE_ARRAY_HPP__
+
+#include "GLObject.hpp"
+#include "Texture.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace utils
+{
+// images with equal keys have the same size and format and can be layers of one array
+std::uint64_t getTextureArrayKey(const utils::TextureImage& i_image);
+
+// Images of one size and format packed into the layers of a GL_TEXTURE_2D_ARRAY, so meshes sampling different ones share a binding
+// and only differ by the layer they sample
+class TextureArray
+{
+public:
+    // the images have to share their key, layer i is i_images[i]
+    explicit TextureArray(std::span<const utils::TextureImage* const> i_images, GLenum i_wrapParam = GL_REPEAT);
+
+    void activate(GLenum i_texUnit) const;
+
+    GLuint getId() const;
+    size_t getLayersCount() const;
+    size_t getGpuBytes() const;
+
+    // arrays can't have more layers than the GL allows
+    static size_t getMaxLayersCount();
+
+private:
+    void upload(std::span<const utils::TextureImage* const> i_images, const utils::ImageData& i_first);
+    void upload(std::span<const utils::TextureImage* const> i_images, const utils::CompressedImage& i_first);
+
+    utils::TextureHandle d_texId;
+    size_t d_layersCount = 0;
+    size_t d_gpuBytes = 0;
+};
+
+// A material texture stored in a layer of a texture array, see ModelOptions::d_packTextures
+struct TextureLayer
+{
+    std::shared_ptr<utils::TextureArray> d_array;
+    int d_layer = 0;
+    aiTextureType d_type = aiTextureType_NONE;
+};
+}
+
+#endif // __TEXTURE_ARRAY_HPP__
@@ -0,0 +1,30 @@
+#ifndef __TEXTURE_CACHE_HPP__
+#define __TEXTURE_CACHE_HPP__
+
+#include "TextureCompression.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+namespace utils
+{
+// On-disk cache of block compressed images with their mip chains, stored as DDS files.
+// Entries are keyed by a hash of the source file's content and the encoder version,
+// so editing the image or improving the encoder invalidates them, and identical images share one entry.
+class TextureCache
+{
+public:
+    explicit TextureCache(const std::filesystem::path& i_sourcePath);
+
+    // nothing if the entry is missing or unreadable
+    std::optional<utils::CompressedImage> load() const;
+    void store(const utils::CompressedImage& i_image) const;
+
+private:
+    std::filesystem::path d_cachePath;
+    std::uint64_t d_sourceHash = 0;
+};
+}
+
+#endif // __TEXTURE_CACHE_HPP__
@@ -0,0 +1,53 @@
+#ifndef __TEXTURE_COMPRESSION_HPP__
+#define __TEXTURE_COMPRESSION_HPP__
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utils
+{
+struct ImageData;
+
+// 4x4 block compressed GPU formats
+enum class BlockFormat
+{
+    BC1, // 8 bytes per block: RGB
+    BC3, // 16 bytes per block: BC1 color + BC4 alpha
+    BC4, // 8 bytes per block: R
+    BC5  // 16 bytes per block: two BC4 blocks, RG
+};
+
+struct CompressedMip
+{
+    int d_width = 0;
+    int d_height = 0;
+    std::size_t d_offset = 0; // in CompressedImage::d_data
+    std::size_t d_size = 0;
+};
+
+// Full mip chain of a block compressed image, largest level first, can be produced off the GL thread
+struct CompressedImage
+{
+    utils::BlockFormat d_format = utils::BlockFormat::BC1;
+    std::vector<std::byte> d_data;
+    std::vector<utils::CompressedMip> d_mips;
+};
+
+const char* getBlockFormatName(utils::BlockFormat i_format);
+std::size_t getBlockBytes(utils::BlockFormat i_format);
+std::size_t getCompressedSize(utils::BlockFormat i_format, int i_width, int i_height);
+GLenum getCompressedGLFormat(utils::BlockFormat i_format);
+// BC1 and BC3 need EXT_texture_compression_s3tc, RGTC is core
+bool isBlockFormatSupported(utils::BlockFormat i_format);
+
+// BC4 for one channel, BC5 for two, BC1 for three and for four with an opaque alpha, BC3 otherwise
+utils::BlockFormat chooseBlockFormat(const utils::ImageData& i_image);
+
+// generates the full mip chain with a box filter and encodes every level, rows of blocks are encoded on the thread pool
+utils::CompressedImage compressImage(const utils::ImageData& i_image, utils::BlockFormat i_format);
+}
+
+#endif // __TEXTURE_COMPRESSION_HPP__
@@ -0,0 +1,73 @@
+#ifndef __TEXTURE_RESIDENCY_HPP__
+#define __TEXTURE_RESIDENCY_HPP__
+
+#include "Texture.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace utils
+{
+class TextureStreamer;
+
+struct TextureResidencyStats
+{
+    std::size_t d_trackedTextures = 0;
+    std::size_t d_residentBytes = 0;
+    std::size_t d_budgetBytes = 0;
+    // counters, since the last resetStats()
+    std::size_t d_reductions = 0; // textures dropped to half their resolution
+    std::size_t d_evictions = 0;  // textures dropped to their smallest mip
+    std::size_t d_reloads = 0;
+};
+
+// Keeps the video memory of the tracked textures within a budget.
+// Textures record the frame they were last bound in; when the resident bytes exceed the budget, the least recently used ones
+// that weren't bound for a while are first dropped to half their resolution, then, if that isn't enough, to their smallest mip.
+// A reduced texture still samples (blurrier) and is reloaded from its file on the thread pool as soon as it is bound again,
+// block compressed ones through the streamer if there is one. Context thread only.
+class TextureResidency
+{
+public:
+    // textures bound in the last i_minIdleFrames frames are never reduced, even over budget
+    explicit TextureResidency(std::size_t i_budgetBytes, utils::TextureStreamer* i_streamer = nullptr, std::uint64_t i_minIdleFrames = 60);
+
+    // i_path and i_compress are what the texture is reloaded with, see loadTextureImage(); tracking a texture twice does nothing
+    void track(const std::shared_ptr<utils::Texture>& i_texture, const std::string& i_path, bool i_compress);
+
+    // once per frame before drawing: uploads finished reloads, starts the ones bound textures need, enforces the budget
+    // and advances the frame the textures record their use with
+    void update();
+
+    void setBudget(std::size_t i_budgetBytes);
+    const utils::TextureResidencyStats& getStats() const;
+    void resetStats();
+
+private:
+    struct TrackedTexture
+    {
+        std::weak_ptr<utils::Texture> d_texture;
+        std::string d_path;
+        bool d_compress = false;
+        bool d_isReduced = false;
+        std::future<utils::TextureImage> d_reload;
+    };
+
+    void finishReloads();
+    void startReloads();
+    void enforceBudget();
+
+    std::size_t d_budgetBytes;
+    utils::TextureStreamer* d_streamer;
+    std::uint64_t d_minIdleFrames;
+    std::uint64_t d_frame = 0;
+    std::unordered_map<const utils::Texture*, TrackedTexture> d_textures;
+    utils::TextureResidencyStats d_stats;
+};
+}
+
+#endif // __TEXTURE_RESIDENCY_HPP__
@@ -0,0 +1,82 @@
+#ifndef __TEXTURE_STREAMER_HPP__
+#define __TEXTURE_STREAMER_HPP__
+
+#include "GLObject.hpp"
+#include "TextureCompression.hpp"
+
+#include <glad/glad.h>
+
+#include <assimp/material.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace utils
+{
+class Texture;
+
+struct TextureStreamerStats
+{
+    std::size_t d_pendingTextures = 0;
+    std::size_t d_uploadedLevels = 0;
+    std::size_t d_uploadedBytes = 0;
+    // process() calls that stopped because the GPU still read every staging buffer
+    std::size_t d_stalls = 0;
+};
+
+// Streams the mips of block compressed textures in over several frames instead of uploading them when the texture is created.
+// A texture starts with its small mips resident and sampling clamped to them, the larger ones are copied through
+// a ring of pixel buffer objects within a per-frame byte budget, the smallest missing mip of all textures first.
+// Every buffer gets a fence once its copy is issued and is only reused when that fence is signaled, so nothing waits on the driver.
+// Context thread only.
+class TextureStreamer
+{
+public:
+    // mips up to i_residentSize texels on their longest side are uploaded when the texture is created
+    explicit TextureStreamer(int i_residentSize = 64, std::size_t i_buffersCount = 3);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // the image is kept until all of its mips are resident; dropping the texture cancels its remaining uploads
+    std::shared_ptr<utils::Texture> create(std::shared_ptr<const utils::CompressedImage> i_image, aiTextureType i_textureType,
+                                           GLenum i_wrapParam = GL_REPEAT);
+    // uploads the missing levels of a texture created from i_image, e.g. after TextureResidency dropped them
+    void stream(const std::shared_ptr<utils::Texture>& i_texture, std::shared_ptr<const utils::CompressedImage> i_image);
+
+    // once per frame, uploads mips until i_byteBudget is spent or no staging buffer is free;
+    // at least one mip is uploaded per call so mips larger than the budget still arrive; returns the uploaded bytes
+    std::size_t process(std::size_t i_byteBudget);
+
+    bool isIdle() const;
+    const utils::TextureStreamerStats& getStats() const;
+    void resetStats();
+
+private:
+    struct PendingTexture
+    {
+        std::weak_ptr<utils::Texture> d_texture;
+        std::shared_ptr<const utils::CompressedImage> d_image;
+    };
+
+    struct StagingBuffer
+    {
+        utils::BufferHandle d_buffer;
+        std::size_t d_capacity = 0;
+        GLsync d_fence = nullptr;
+    };
+
+    // false while the GPU may still read the buffer's previous contents
+    bool isAvailable(StagingBuffer& io_buffer) const;
+
+    int d_residentSize;
+    std::vector<StagingBuffer> d_buffers;
+    std::size_t d_nextBuffer = 0;
+    std::vector<PendingTexture> d_pending;
+    utils::TextureStreamerStats d_stats;
+};
+}
+
+#endif // __TEXTURE_STREAMER_HPP__
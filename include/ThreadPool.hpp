@@ -0,0 +1,65 @@
+#ifndef __THREAD_POOL_HPP__
+#define __THREAD_POOL_HPP__
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace utils
+{
+class ThreadPool
+{
+public:
+    explicit ThreadPool(std::size_t i_workersCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // process-wide pool, sized to the hardware (LEARNOPENGL_WORKERS overrides it, 0 means run everything inline)
+    static ThreadPool& getInstance();
+
+    template <typename Func>
+    std::future<std::invoke_result_t<Func>> submit(Func&& i_func);
+
+    // runs i_func(i) for every i in [0, i_count) and blocks until all of them finished,
+    // the calling thread takes part in the work; the first thrown exception is rethrown
+    void parallelFor(std::size_t i_count, const std::function<void(std::size_t)>& i_func);
+
+    std::size_t getWorkersCount() const;
+
+private:
+    void enqueue(std::function<void()> i_task);
+    void workerLoop();
+
+    std::vector<std::thread> d_workers;
+    std::queue<std::function<void()>> d_tasks;
+    std::mutex d_mutex;
+    std::condition_variable d_condition;
+    bool d_isStopping = false;
+};
+
+template <typename Func>
+std::future<std::invoke_result_t<Func>> ThreadPool::submit(Func&& i_func)
+{
+    using Result = std::invoke_result_t<Func>;
+
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(i_func));
+    auto future = task->get_future();
+    if (d_workers.empty())
+        (*task)();
+    else
+        enqueue([task]() { (*task)(); });
+
+    return future;
+}
+}
+
+#endif // __THREAD_POOL_HPP__
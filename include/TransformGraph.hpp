@@ -0,0 +1,57 @@
+#ifndef __TRANSFORM_GRAPH_HPP__
+#define __TRANSFORM_GRAPH_HPP__
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace utils
+{
+static constexpr std::uint32_t NO_PARENT_NODE = std::numeric_limits<std::uint32_t>::max();
+
+// Node of a flattened hierarchy, as stored in the mesh cache
+struct TransformNode
+{
+    std::uint32_t d_parent; // NO_PARENT_NODE for roots
+    glm::mat4 d_localTransform;
+};
+
+// Hierarchy of transforms in flat arrays, every parent comes before its children,
+// so the world transforms are computed in a single forward pass without recursion.
+// Changing a local transform only marks the node dirty, update() recomputes the dirty subtrees.
+class TransformGraph
+{
+public:
+    TransformGraph() = default;
+    explicit TransformGraph(std::span<const utils::TransformNode> i_nodes);
+
+    // i_parent must already be in the graph
+    std::uint32_t addNode(std::uint32_t i_parent, const glm::mat4& i_localTransform);
+
+    void setLocalTransform(std::uint32_t i_node, const glm::mat4& i_localTransform);
+    const glm::mat4& getLocalTransform(std::uint32_t i_node) const;
+    std::uint32_t getParent(std::uint32_t i_node) const;
+
+    // valid after update()
+    const glm::mat4& getWorldTransform(std::uint32_t i_node) const;
+
+    // returns the number of recomputed world transforms
+    std::size_t update();
+
+    std::size_t size() const;
+
+private:
+    std::vector<std::uint32_t> d_parents;
+    std::vector<glm::mat4> d_localTransforms;
+    std::vector<glm::mat4> d_worldTransforms;
+    std::vector<std::uint8_t> d_isDirty;
+    std::vector<std::uint32_t> d_dirtyNodes; // scratch of update()
+    std::uint32_t d_firstDirtyNode = 0;      // nothing before it needs an update
+};
+}
+
+#endif // __TRANSFORM_GRAPH_HPP__
@@ -0,0 +1,185 @@
+#ifndef __UNIFORM_BLOCKS_HPP__
+#define __UNIFORM_BLOCKS_HPP__
+
+#include "GLObject.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+namespace utils
+{
+// Per-frame data shared by all programs through std140 uniform blocks. Every block has a fixed binding point,
+// ShadersManager connects the blocks a program declares to them after linking.
+// The structs mirror the GLSL declarations byte for byte: a vec3 takes 16 bytes, so it is followed by a float.
+
+static constexpr GLuint FRAME_UNIFORMS_BINDING = 0;
+static constexpr GLuint LIGHT_UNIFORMS_BINDING = 1;
+static constexpr GLuint CLUSTER_UNIFORMS_BINDING = 2;
+
+struct UniformBlockBinding
+{
+    const char* d_name;
+    GLuint d_binding;
+};
+
+static constexpr std::array<utils::UniformBlockBinding, 3> UNIFORM_BLOCKS = { {
+    { "FrameData", utils::FRAME_UNIFORMS_BINDING },
+    { "LightData", utils::LIGHT_UNIFORMS_BINDING },
+    { "ClusterData", utils::CLUSTER_UNIFORMS_BINDING },
+} };
+
+// Shared samplers get fixed units above the ones materials use, ShadersManager sets them after linking as well
+static constexpr GLuint GBUFFER_ALBEDO_SPECULAR_UNIT = 10;
+static constexpr GLuint GBUFFER_NORMAL_UNIT = 11;
+static constexpr GLuint GBUFFER_DEPTH_UNIT = 12;
+static constexpr GLuint CLUSTER_LIGHTS_UNIT = 13;
+static constexpr GLuint CLUSTER_RANGES_UNIT = 14;
+static constexpr GLuint CLUSTER_LIGHT_INDICES_UNIT = 15;
+
+struct UniformSamplerBinding
+{
+    const char* d_name;
+    GLuint d_unit;
+};
+
+static constexpr std::array<utils::UniformSamplerBinding, 6> UNIFORM_SAMPLERS = { {
+    { "gbufferAlbedoSpecular", utils::GBUFFER_ALBEDO_SPECULAR_UNIT },
+    { "gbufferNormal", utils::GBUFFER_NORMAL_UNIT },
+    { "gbufferDepth", utils::GBUFFER_DEPTH_UNIT },
+    { "clusterLights", utils::CLUSTER_LIGHTS_UNIT },
+    { "clusterRanges", utils::CLUSTER_RANGES_UNIT },
+    { "clusterLightIndices", utils::CLUSTER_LIGHT_INDICES_UNIT },
+} };
+
+// layout (std140) uniform FrameData
+struct FrameUniforms
+{
+    glm::mat4 d_view;
+    glm::mat4 d_projection;
+    glm::mat4 d_viewProjection;
+    glm::vec3 d_viewPos{ 0.0f };
+    float d_time = 0.0f;
+};
+
+static_assert(offsetof(utils::FrameUniforms, d_projection) == 64);
+static_assert(offsetof(utils::FrameUniforms, d_viewProjection) == 128);
+static_assert(offsetof(utils::FrameUniforms, d_viewPos) == 192);
+static_assert(offsetof(utils::FrameUniforms, d_time) == 204);
+static_assert(sizeof(utils::FrameUniforms) == 208);
+
+struct DirLightUniforms
+{
+    glm::vec3 d_direction{ 0.0f };
+    float d_padding0 = 0.0f;
+    glm::vec3 d_ambient{ 0.0f };
+    float d_padding1 = 0.0f;
+    glm::vec3 d_diffuse{ 0.0f };
+    float d_padding2 = 0.0f;
+    glm::vec3 d_specular{ 0.0f };
+    float d_padding3 = 0.0f;
+};
+
+static_assert(offsetof(utils::DirLightUniforms, d_ambient) == 16);
+static_assert(offsetof(utils::DirLightUniforms, d_diffuse) == 32);
+static_assert(offsetof(utils::DirLightUniforms, d_specular) == 48);
+static_assert(sizeof(utils::DirLightUniforms) == 64);
+
+struct PointLightUniforms
+{
+    glm::vec3 d_position{ 0.0f };
+    float d_constant = 1.0f;
+    glm::vec3 d_ambient{ 0.0f };
+    float d_linear = 0.0f;
+    glm::vec3 d_diffuse{ 0.0f };
+    float d_quadratic = 0.0f;
+    glm::vec3 d_specular{ 0.0f };
+    float d_padding = 0.0f;
+};
+
+static_assert(offsetof(utils::PointLightUniforms, d_constant) == 12);
+static_assert(offsetof(utils::PointLightUniforms, d_ambient) == 16);
+static_assert(offsetof(utils::PointLightUniforms, d_linear) == 28);
+static_assert(offsetof(utils::PointLightUniforms, d_diffuse) == 32);
+static_assert(offsetof(utils::PointLightUniforms, d_quadratic) == 44);
+static_assert(offsetof(utils::PointLightUniforms, d_specular) == 48);
+static_assert(sizeof(utils::PointLightUniforms) == 64);
+
+struct SpotLightUniforms
+{
+    glm::vec3 d_position{ 0.0f };
+    float d_cutOff = 0.0f;
+    glm::vec3 d_direction{ 0.0f };
+    float d_outerCutOff = 0.0f;
+    glm::vec3 d_ambient{ 0.0f };
+    float d_constant = 1.0f;
+    glm::vec3 d_diffuse{ 0.0f };
+    float d_linear = 0.0f;
+    glm::vec3 d_specular{ 0.0f };
+    float d_quadratic = 0.0f;
+};
+
+static_assert(offsetof(utils::SpotLightUniforms, d_cutOff) == 12);
+static_assert(offsetof(utils::SpotLightUniforms, d_direction) == 16);
+static_assert(offsetof(utils::SpotLightUniforms, d_outerCutOff) == 28);
+static_assert(offsetof(utils::SpotLightUniforms, d_ambient) == 32);
+static_assert(offsetof(utils::SpotLightUniforms, d_constant) == 44);
+static_assert(offsetof(utils::SpotLightUniforms, d_diffuse) == 48);
+static_assert(offsetof(utils::SpotLightUniforms, d_linear) == 60);
+static_assert(offsetof(utils::SpotLightUniforms, d_specular) == 64);
+static_assert(offsetof(utils::SpotLightUniforms, d_quadratic) == 76);
+static_assert(sizeof(utils::SpotLightUniforms) == 80);
+
+// POINT_LIGHTS_CNT in the shaders
+static constexpr std::size_t POINT_LIGHTS_COUNT = 4;
+
+// layout (std140) uniform LightData
+struct LightUniforms
+{
+    utils::DirLightUniforms d_dirLight;
+    std::array<utils::PointLightUniforms, utils::POINT_LIGHTS_COUNT> d_pointLights;
+    utils::SpotLightUniforms d_spotLight;
+};
+
+static_assert(offsetof(utils::LightUniforms, d_pointLights) == 64);
+static_assert(offsetof(utils::LightUniforms, d_spotLight) == 320);
+static_assert(sizeof(utils::LightUniforms) == 400);
+
+// layout (std140) uniform ClusterData, how a fragment finds its cluster, see LightClusters
+struct ClusterUniforms
+{
+    glm::uvec4 d_gridSize{ 0u };      // tiles along x and y, depth slices, w unused
+    glm::vec4 d_depthParams{ 0.0f };  // slice = log(view depth) * x + y, near and far planes
+    glm::vec4 d_screenParams{ 0.0f }; // tile = gl_FragCoord.xy * xy, viewport size
+};
+
+static_assert(offsetof(utils::ClusterUniforms, d_depthParams) == 16);
+static_assert(offsetof(utils::ClusterUniforms, d_screenParams) == 32);
+static_assert(sizeof(utils::ClusterUniforms) == 48);
+
+// Uniform buffer attached to a binding point for its whole lifetime, update() replaces its content
+class UniformBuffer
+{
+public:
+    UniformBuffer(GLuint i_binding, std::size_t i_size);
+
+    template <typename T>
+    void update(const T& i_data)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        upload(std::as_bytes(std::span<const T, 1>(&i_data, 1)));
+    }
+
+private:
+    void upload(std::span<const std::byte> i_bytes);
+
+    utils::BufferHandle d_buffer;
+    std::size_t d_size;
+};
+}
+
+#endif // __UNIFORM_BLOCKS_HPP__
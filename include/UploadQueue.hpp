@@ -0,0 +1,32 @@
+#ifndef __UPLOAD_QUEUE_HPP__
+#define __UPLOAD_QUEUE_HPP__
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace utils
+{
+// GL work produced by loader threads and executed on the context thread,
+// a few tasks per frame so streaming assets in doesn't show up as frame spikes
+class UploadQueue
+{
+public:
+    // thread-safe
+    void push(std::function<void()> i_task);
+
+    // runs queued tasks until the budget is spent, at least one task is run per call so the queue always drains;
+    // returns the number of tasks run
+    std::size_t process(std::chrono::microseconds i_budget);
+
+    bool isEmpty() const;
+
+private:
+    mutable std::mutex d_mutex;
+    std::deque<std::function<void()>> d_tasks;
+};
+}
+
+#endif // __UPLOAD_QUEUE_HPP__
@@ -6,7 +6,13 @@ namespace utils
 class ShadersManager;
 class Texture;
 struct Vertex;
+struct TextureRef;
+struct LodRange;
+struct MeshData;
+struct MeshView;
 class Mesh;
+class InstanceBuffer;
+class RenderQueue;
 }
 
 #endif // __UTILS_FORWARD_HPP
\ No newline at end of file
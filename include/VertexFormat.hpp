@@ -0,0 +1,60 @@
+#ifndef __VERTEX_FORMAT_HPP__
+#define __VERTEX_FORMAT_HPP__
+
+#include "UtilsFwd.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace utils
+{
+// GPU-side vertex layouts, the CPU side always works with utils::Vertex
+enum class VertexFormat
+{
+    Float,     // 32 bytes: vec3 position, vec3 normal, vec2 uv
+    Packed,    // 20 bytes: vec3 position, 10-10-10-2 snorm normal, half float uv
+    Quantized  // 16 bytes: unorm16 position dequantized by a per-mesh transform, 10-10-10-2 snorm normal, half float uv
+};
+
+struct PackedVertex
+{
+    glm::vec3 d_position;
+    std::uint32_t d_normal;
+    std::uint32_t d_texCoords;
+};
+static_assert(sizeof(PackedVertex) == 20);
+
+struct QuantizedVertex
+{
+    std::uint16_t d_position[4]; // w is padding, keeps the normal 4-byte aligned
+    std::uint32_t d_normal;
+    std::uint32_t d_texCoords;
+};
+static_assert(sizeof(QuantizedVertex) == 16);
+
+// position = d_offset + d_scale * attribute, identity for non-quantized formats
+struct PositionTransform
+{
+    glm::vec3 d_offset{ 0.0f };
+    glm::vec3 d_scale{ 1.0f };
+};
+
+std::size_t getVertexSize(utils::VertexFormat i_format);
+
+// converts the vertices into the given format, returns the bytes to upload
+std::vector<std::byte> packVertices(std::span<const utils::Vertex> i_vertices, utils::VertexFormat i_format, utils::PositionTransform& o_transform);
+
+// sets up attributes 0 (position), 1 (normal) and 2 (uv) for the bound VAO and GL_ARRAY_BUFFER
+void setVertexAttributes(utils::VertexFormat i_format);
+
+// 16-bit indices are enough when every vertex can be addressed by them
+GLenum getIndexType(std::size_t i_verticesCount);
+std::size_t getIndexSize(GLenum i_indexType);
+}
+
+#endif // __VERTEX_FORMAT_HPP__
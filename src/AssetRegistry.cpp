@@ -0,0 +1,178 @@
+#include "AssetRegistry.hpp"
+
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+#include "Mesh.hpp"
+#include "ShadersManager.hpp"
+#include "Texture.hpp"
+
+#include <algorithm>
+
+namespace
+{
+size_t getAssetBytes(const utils::Texture& i_texture)
+{
+    return i_texture.getGpuBytes();
+}
+
+size_t getAssetBytes(const utils::Mesh& i_mesh)
+{
+    return i_mesh.getGeometryBytes();
+}
+
+size_t getAssetBytes(const utils::ShadersManager&)
+{
+    return 0;
+}
+
+// the compressed variant of a file gets a key of its own
+std::uint64_t getTextureKey(std::uint64_t i_hash, bool i_isCompressed)
+{
+    return i_isCompressed ? utils::fnv1a("compressed", i_hash) : i_hash;
+}
+}
+
+utils::AssetRegistry& utils::AssetRegistry::getInstance()
+{
+    static AssetRegistry registry;
+    return registry;
+}
+
+std::string utils::AssetRegistry::normalizePath(std::string_view i_path)
+{
+    // "a/../b.png", "./b.png" and symlinks lead to the same entry, paths of missing files are only made lexically normal
+    std::error_code ec;
+    const auto canonicalPath = std::filesystem::weakly_canonical(std::filesystem::path(i_path), ec);
+    return ec ? std::filesystem::path(i_path).lexically_normal().generic_string() : canonicalPath.generic_string();
+}
+
+std::uint64_t utils::AssetRegistry::hashFile(const std::filesystem::path& i_path)
+{
+    const utils::MappedFile file(i_path);
+    return utils::fnv1a(file.getData(), file.getSize());
+}
+
+bool utils::AssetRegistry::hasTexture(std::string_view i_path, bool i_isCompressed, std::uint64_t i_contentHash /* = 0 */) const
+{
+    const auto path = i_contentHash ? std::string() : normalizePath(i_path);
+
+    std::lock_guard lock(d_mutex);
+    const auto key = i_contentHash ? getTextureKey(i_contentHash, i_isCompressed) : findTextureKey(path, i_isCompressed);
+    const auto it = d_textures.d_assets.find(key);
+    return it != d_textures.d_assets.end() && !it->second.expired();
+}
+
+std::shared_ptr<utils::Texture> utils::AssetRegistry::findTexture(std::string_view i_path, bool i_isCompressed,
+                                                                  std::uint64_t i_contentHash /* = 0 */)
+{
+    auto path = normalizePath(i_path);
+
+    std::lock_guard lock(d_mutex);
+    if (auto texture = find(d_textures, findTextureKey(path, i_isCompressed)))
+        return texture;
+
+    if (!i_contentHash)
+        return nullptr;
+
+    const auto key = getTextureKey(i_contentHash, i_isCompressed);
+    auto texture = find(d_textures, key);
+    if (texture)
+        d_texturePaths[i_isCompressed].insert_or_assign(std::move(path), key);
+    return texture;
+}
+
+std::shared_ptr<utils::Texture> utils::AssetRegistry::addTexture(std::string_view i_path, bool i_isCompressed, std::uint64_t i_contentHash,
+                                                                 std::shared_ptr<utils::Texture> i_texture)
+{
+    auto path = normalizePath(i_path);
+    // without the content only the path can match
+    const auto key = getTextureKey(i_contentHash ? i_contentHash : utils::fnv1a(path), i_isCompressed);
+
+    std::lock_guard lock(d_mutex);
+    auto texture = add(d_textures, key, std::move(i_texture));
+    d_texturePaths[i_isCompressed].insert_or_assign(std::move(path), key);
+    for (auto& paths : d_texturePaths)
+        std::erase_if(paths, [this](const auto& i_path) { return !d_textures.d_assets.contains(i_path.second); });
+    return texture;
+}
+
+std::shared_ptr<utils::Mesh> utils::AssetRegistry::findMesh(std::uint64_t i_key)
+{
+    std::lock_guard lock(d_mutex);
+    return find(d_meshes, i_key);
+}
+
+std::shared_ptr<utils::Mesh> utils::AssetRegistry::addMesh(std::uint64_t i_key, std::shared_ptr<utils::Mesh> i_mesh)
+{
+    std::lock_guard lock(d_mutex);
+    return add(d_meshes, i_key, std::move(i_mesh));
+}
+
+std::shared_ptr<utils::ShadersManager> utils::AssetRegistry::findProgram(std::uint64_t i_key)
+{
+    std::lock_guard lock(d_mutex);
+    return find(d_programs, i_key);
+}
+
+std::shared_ptr<utils::ShadersManager> utils::AssetRegistry::addProgram(std::uint64_t i_key, std::shared_ptr<utils::ShadersManager> i_program)
+{
+    std::lock_guard lock(d_mutex);
+    return add(d_programs, i_key, std::move(i_program));
+}
+
+utils::AssetRegistryStats utils::AssetRegistry::getStats() const
+{
+    std::lock_guard lock(d_mutex);
+    return { getStats(d_textures), getStats(d_meshes), getStats(d_programs) };
+}
+
+template <typename Asset>
+std::shared_ptr<Asset> utils::AssetRegistry::find(AssetTable<Asset>& io_table, std::uint64_t i_key)
+{
+    const auto it = io_table.d_assets.find(i_key);
+    if (it == io_table.d_assets.end())
+        return nullptr;
+
+    auto asset = it->second.lock();
+    if (asset)
+    {
+        ++io_table.d_stats.d_reusedCount;
+        io_table.d_stats.d_savedBytes += getAssetBytes(*asset);
+    }
+    return asset;
+}
+
+template <typename Asset>
+std::shared_ptr<Asset> utils::AssetRegistry::add(AssetTable<Asset>& io_table, std::uint64_t i_key, std::shared_ptr<Asset> i_asset)
+{
+    // the entries of freed assets go first, keys are reused when an asset is loaded again
+    std::erase_if(io_table.d_assets, [](const auto& i_entry) { return i_entry.second.expired(); });
+
+    auto [it, isInserted] = io_table.d_assets.try_emplace(i_key, i_asset);
+    if (isInserted)
+        return i_asset;
+
+    // created concurrently by another user, the first one registered wins
+    auto asset = it->second.lock();
+    ++io_table.d_stats.d_reusedCount;
+    io_table.d_stats.d_savedBytes += getAssetBytes(*asset);
+    return asset;
+}
+
+template <typename Asset>
+utils::AssetStats utils::AssetRegistry::getStats(const AssetTable<Asset>& i_table)
+{
+    auto stats = i_table.d_stats;
+    stats.d_liveCount = static_cast<size_t>(std::count_if(i_table.d_assets.begin(), i_table.d_assets.end(), [](const auto& i_entry)
+    {
+        return !i_entry.second.expired();
+    }));
+    return stats;
+}
+
+std::uint64_t utils::AssetRegistry::findTextureKey(const std::string& i_normalizedPath, bool i_isCompressed) const
+{
+    const auto& paths = d_texturePaths[i_isCompressed];
+    const auto it = paths.find(i_normalizedPath);
+    return it == paths.end() ? 0 : it->second;
+}
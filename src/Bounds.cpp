@@ -0,0 +1,56 @@
+#include "Bounds.hpp"
+
+#include "Mesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+utils::Bounds utils::computeBounds(std::span<const utils::Vertex> i_vertices)
+{
+    utils::Bounds bounds;
+    if (i_vertices.empty())
+        return bounds;
+
+    glm::vec3 minPos(std::numeric_limits<float>::max());
+    glm::vec3 maxPos(std::numeric_limits<float>::lowest());
+    for (const auto& vertex : i_vertices)
+    {
+        minPos = glm::min(minPos, vertex.d_position);
+        maxPos = glm::max(maxPos, vertex.d_position);
+    }
+
+    // centered on the box, not minimal but tight enough for culling and LOD selection
+    bounds.d_center = (minPos + maxPos) * 0.5f;
+    bounds.d_extents = (maxPos - minPos) * 0.5f;
+    float radiusSquared = 0.0f;
+    for (const auto& vertex : i_vertices)
+    {
+        const auto offset = vertex.d_position - bounds.d_center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+    bounds.d_radius = std::sqrt(radiusSquared);
+
+    return bounds;
+}
+
+utils::Bounds utils::transformBounds(const utils::Bounds& i_bounds, const glm::mat4& i_transform)
+{
+    utils::Bounds bounds;
+    bounds.d_center = glm::vec3(i_transform * glm::vec4(i_bounds.d_center, 1.0f));
+    bounds.d_radius = i_bounds.d_radius * utils::getMaxScale(i_transform);
+
+    // every axis of the result gets the absolute contributions of all source axes
+    for (int row = 0; row < 3; ++row)
+    {
+        bounds.d_extents[row] = std::abs(i_transform[0][row]) * i_bounds.d_extents.x + std::abs(i_transform[1][row]) * i_bounds.d_extents.y
+                              + std::abs(i_transform[2][row]) * i_bounds.d_extents.z;
+    }
+
+    return bounds;
+}
+
+float utils::getMaxScale(const glm::mat4& i_transform)
+{
+    return std::max({ glm::length(glm::vec3(i_transform[0])), glm::length(glm::vec3(i_transform[1])), glm::length(glm::vec3(i_transform[2])) });
+}
@@ -14,6 +14,8 @@ static constexpr float YAW = -90.0f;
 static constexpr float PITCH = 0.0f;
 static constexpr float SENSITIVITY = 0.1f;
 static constexpr float FOV = 45.0f;
+static constexpr float VIEWPORT_WIDTH = 800.0f;
+static constexpr float VIEWPORT_HEIGHT = 600.0f;
 
 // void printVec3(std::string_view i_vecName, const glm::vec3& i_vec)
 // {
@@ -107,7 +109,7 @@ glm::highp_mat4 Camera::getView() const
 
 glm::highp_mat4 Camera::getProjection() const
 {
-    return glm::perspective(glm::radians(d_fov), 800.f / 600.f, 0.1f, 100.f);
+    return glm::perspective(glm::radians(d_fov), VIEWPORT_WIDTH / VIEWPORT_HEIGHT, 0.1f, 100.f);
 }
 
 glm::vec3 Camera::getCameraPos() const
@@ -119,4 +121,14 @@ glm::vec3 Camera::getCameraFront() const
 {
     return d_front;
 }
+
+float Camera::getFov() const
+{
+    return d_fov;
+}
+
+float Camera::getViewportHeight() const
+{
+    return VIEWPORT_HEIGHT;
+}
 }
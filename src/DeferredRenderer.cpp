@@ -0,0 +1,104 @@
+#include "DeferredRenderer.hpp"
+
+#include "GLStateCache.hpp"
+#include "ShadersManager.hpp"
+#include "UniformBlocks.hpp"
+
+#include <array>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+void defineTexture(GLuint i_texture, GLenum i_internalFormat, GLenum i_format, GLenum i_type, GLsizei i_width, GLsizei i_height)
+{
+    // the lighting pass reads texels, nothing is filtered
+    utils::GLStateCache::getInstance().bindTexture(0, GL_TEXTURE_2D, i_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(i_internalFormat), i_width, i_height, 0, i_format, i_type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+}
+
+utils::DeferredRenderer::DeferredRenderer(std::string_view i_vertexShaderPath, std::string_view i_geometryShaderPath,
+                                          std::string_view i_fullscreenShaderPath, std::string_view i_lightingShaderPath)
+    : d_geometryShaders(i_vertexShaderPath, i_geometryShaderPath)
+    , d_lightingShaders(i_fullscreenShaderPath, i_lightingShaderPath)
+    , d_framebuffer(utils::FramebufferHandle::create())
+    , d_albedoSpecular(utils::TextureHandle::create())
+    , d_normal(utils::TextureHandle::create())
+    , d_depth(utils::TextureHandle::create())
+    , d_emptyVAO(utils::VertexArrayHandle::create())
+{
+}
+
+utils::ShaderVariants& utils::DeferredRenderer::getGeometryShaders()
+{
+    return d_geometryShaders;
+}
+
+utils::ShaderVariants& utils::DeferredRenderer::getLightingShaders()
+{
+    return d_lightingShaders;
+}
+
+void utils::DeferredRenderer::resize(GLsizei i_width, GLsizei i_height)
+{
+    defineTexture(d_albedoSpecular.get(), GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, i_width, i_height);
+    defineTexture(d_normal.get(), GL_RG16F, GL_RG, GL_FLOAT, i_width, i_height);
+    // the format of the default framebuffer's depth, glBlitFramebuffer only copies depth between matching formats
+    defineTexture(d_depth.get(), GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, i_width, i_height);
+
+    utils::GLStateCache::getInstance().bindFramebuffer(d_framebuffer.get());
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, d_albedoSpecular.get(), 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, d_normal.get(), 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, d_depth.get(), 0);
+    static constexpr std::array<GLenum, 2> DRAW_BUFFERS = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(static_cast<GLsizei>(DRAW_BUFFERS.size()), DRAW_BUFFERS.data());
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Incomplete G-buffer of " + std::to_string(i_width) + 'x' + std::to_string(i_height));
+
+    d_width = i_width;
+    d_height = i_height;
+}
+
+void utils::DeferredRenderer::beginGeometryPass(GLsizei i_width, GLsizei i_height)
+{
+    if (i_width != d_width || i_height != d_height)
+        resize(i_width, i_height);
+
+    auto& glState = utils::GLStateCache::getInstance();
+    glState.bindFramebuffer(d_framebuffer.get());
+    glState.setViewport(0, 0, d_width, d_height);
+    glState.setDepthTest(true);
+    glState.setDepthMask(true);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void utils::DeferredRenderer::drawLighting(utils::ShaderFeatures i_sceneFeatures, const glm::mat4& i_viewProjection)
+{
+    auto& glState = utils::GLStateCache::getInstance();
+    glState.bindFramebuffer(0);
+    glState.bindTexture(utils::GBUFFER_ALBEDO_SPECULAR_UNIT, GL_TEXTURE_2D, d_albedoSpecular.get());
+    glState.bindTexture(utils::GBUFFER_NORMAL_UNIT, GL_TEXTURE_2D, d_normal.get());
+    glState.bindTexture(utils::GBUFFER_DEPTH_UNIT, GL_TEXTURE_2D, d_depth.get());
+
+    const auto& shaders = d_lightingShaders.get(i_sceneFeatures | utils::SHADER_DEFERRED_LIGHTING);
+    shaders.render();
+    shaders.setMatrix4fv("inverseViewProjection", glm::inverse(i_viewProjection));
+
+    // every pixel once
+    glState.setDepthTest(false);
+    glState.bindVertexArray(d_emptyVAO.get());
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glState.setDepthTest(true);
+
+    // the scene's depth goes to the default framebuffer, so what is drawn forward afterwards is hidden by it like in the forward path
+    glState.bindReadFramebuffer(d_framebuffer.get());
+    glBlitFramebuffer(0, 0, d_width, d_height, 0, 0, d_width, d_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glState.bindReadFramebuffer(0);
+}
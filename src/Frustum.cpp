@@ -0,0 +1,269 @@
+#include "Frustum.hpp"
+
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define UTILS_CULL_SSE
+// the AVX kernel is compiled for AVX on its own and only called when the CPU has it, the rest of the build stays SSE2
+#if defined(__GNUC__) || defined(__clang__)
+#define UTILS_CULL_AVX
+#define UTILS_AVX_FUNCTION __attribute__((target("avx")))
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define UTILS_CULL_AVX
+#define UTILS_AVX_FUNCTION
+#endif
+#endif
+
+namespace
+{
+// center x, y, z and extent x, y, z of the boxes of an AabbBatch
+using BoxArrays = std::array<const float*, 6>;
+
+// the box is outside of the plane when even its corner furthest along the normal is behind it;
+// the sums are in the order the SIMD kernels add them, so all kernels round the same way
+bool isOutside(const glm::vec4& i_plane, float i_centerX, float i_centerY, float i_centerZ, float i_extentX, float i_extentY, float i_extentZ)
+{
+    float distance = i_plane.x * i_centerX + i_plane.w;
+    distance += i_plane.y * i_centerY;
+    distance += i_plane.z * i_centerZ;
+
+    float radius = std::abs(i_plane.x) * i_extentX;
+    radius += std::abs(i_plane.y) * i_extentY;
+    radius += std::abs(i_plane.z) * i_extentZ;
+
+    return !(distance + radius >= 0.0f);
+}
+
+void cullScalar(const utils::Frustum& i_frustum, const BoxArrays& i_boxes, std::size_t i_first, std::size_t i_count, std::uint8_t* o_visible)
+{
+    for (std::size_t i = i_first; i < i_count; ++i)
+    {
+        bool visible = true;
+        for (const auto& plane : i_frustum.d_planes)
+            visible = visible && !isOutside(plane, i_boxes[0][i], i_boxes[1][i], i_boxes[2][i], i_boxes[3][i], i_boxes[4][i], i_boxes[5][i]);
+        o_visible[i] = visible ? 1 : 0;
+    }
+}
+
+#if defined(UTILS_CULL_SSE)
+// the boxes in whole groups of 4, returns how many it tested
+std::size_t cullSse(const utils::Frustum& i_frustum, const BoxArrays& i_boxes, std::size_t i_count, std::uint8_t* o_visible)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    std::size_t i = 0;
+    for (; i + 4 <= i_count; i += 4)
+    {
+        const __m128 centerX = _mm_loadu_ps(i_boxes[0] + i);
+        const __m128 centerY = _mm_loadu_ps(i_boxes[1] + i);
+        const __m128 centerZ = _mm_loadu_ps(i_boxes[2] + i);
+        const __m128 extentX = _mm_loadu_ps(i_boxes[3] + i);
+        const __m128 extentY = _mm_loadu_ps(i_boxes[4] + i);
+        const __m128 extentZ = _mm_loadu_ps(i_boxes[5] + i);
+
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const auto& plane : i_frustum.d_planes)
+        {
+            const __m128 planeX = _mm_set1_ps(plane.x);
+            const __m128 planeY = _mm_set1_ps(plane.y);
+            const __m128 planeZ = _mm_set1_ps(plane.z);
+
+            __m128 distance = _mm_add_ps(_mm_mul_ps(planeX, centerX), _mm_set1_ps(plane.w));
+            distance = _mm_add_ps(distance, _mm_mul_ps(planeY, centerY));
+            distance = _mm_add_ps(distance, _mm_mul_ps(planeZ, centerZ));
+
+            __m128 radius = _mm_mul_ps(_mm_andnot_ps(signMask, planeX), extentX);
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, planeY), extentY));
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, planeZ), extentZ));
+
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        const int mask = _mm_movemask_ps(visible);
+        for (std::size_t j = 0; j < 4; ++j)
+            o_visible[i + j] = static_cast<std::uint8_t>((mask >> j) & 1);
+    }
+    return i;
+}
+#endif
+
+#if defined(UTILS_CULL_AVX)
+// the boxes in whole groups of 8, returns how many it tested
+UTILS_AVX_FUNCTION std::size_t cullAvx(const utils::Frustum& i_frustum, const BoxArrays& i_boxes, std::size_t i_count, std::uint8_t* o_visible)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    std::size_t i = 0;
+    for (; i + 8 <= i_count; i += 8)
+    {
+        const __m256 centerX = _mm256_loadu_ps(i_boxes[0] + i);
+        const __m256 centerY = _mm256_loadu_ps(i_boxes[1] + i);
+        const __m256 centerZ = _mm256_loadu_ps(i_boxes[2] + i);
+        const __m256 extentX = _mm256_loadu_ps(i_boxes[3] + i);
+        const __m256 extentY = _mm256_loadu_ps(i_boxes[4] + i);
+        const __m256 extentZ = _mm256_loadu_ps(i_boxes[5] + i);
+
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const auto& plane : i_frustum.d_planes)
+        {
+            const __m256 planeX = _mm256_set1_ps(plane.x);
+            const __m256 planeY = _mm256_set1_ps(plane.y);
+            const __m256 planeZ = _mm256_set1_ps(plane.z);
+
+            __m256 distance = _mm256_add_ps(_mm256_mul_ps(planeX, centerX), _mm256_set1_ps(plane.w));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(planeY, centerY));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(planeZ, centerZ));
+
+            __m256 radius = _mm256_mul_ps(_mm256_andnot_ps(signMask, planeX), extentX);
+            radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_andnot_ps(signMask, planeY), extentY));
+            radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_andnot_ps(signMask, planeZ), extentZ));
+
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+
+        const int mask = _mm256_movemask_ps(visible);
+        for (std::size_t j = 0; j < 8; ++j)
+            o_visible[i + j] = static_cast<std::uint8_t>((mask >> j) & 1);
+    }
+    return i;
+}
+
+bool hasAvx()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("avx");
+#else
+    // the CPU has AVX (CPUID.1:ECX bit 28) and the OS saves the YMM registers (OSXSAVE, bit 27, and XCR0 bits 1 and 2)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+#endif
+}
+#endif
+}
+
+bool utils::isCullKernelSupported(utils::CullKernel i_kernel)
+{
+    switch (i_kernel)
+    {
+    case utils::CullKernel::Scalar:
+        return true;
+    case utils::CullKernel::Sse:
+#if defined(UTILS_CULL_SSE)
+        return true;
+#else
+        return false;
+#endif
+    case utils::CullKernel::Avx:
+#if defined(UTILS_CULL_AVX)
+    {
+        static const bool isSupported = hasAvx();
+        return isSupported;
+    }
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+utils::CullKernel utils::getBestCullKernel()
+{
+    static const utils::CullKernel kernel = isCullKernelSupported(utils::CullKernel::Avx)   ? utils::CullKernel::Avx
+                                          : isCullKernelSupported(utils::CullKernel::Sse) ? utils::CullKernel::Sse
+                                                                                          : utils::CullKernel::Scalar;
+    return kernel;
+}
+
+utils::Frustum utils::extractFrustum(const glm::mat4& i_matrix)
+{
+    // Gribb/Hartmann: the clip space conditions -w <= x, y, z <= w as planes, built from the matrix rows
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+        rows[i] = glm::vec4(i_matrix[0][i], i_matrix[1][i], i_matrix[2][i], i_matrix[3][i]);
+
+    utils::Frustum frustum;
+    frustum.d_planes[0] = rows[3] + rows[0]; // left
+    frustum.d_planes[1] = rows[3] - rows[0]; // right
+    frustum.d_planes[2] = rows[3] + rows[1]; // bottom
+    frustum.d_planes[3] = rows[3] - rows[1]; // top
+    frustum.d_planes[4] = rows[3] + rows[2]; // near
+    frustum.d_planes[5] = rows[3] - rows[2]; // far
+
+    for (auto& plane : frustum.d_planes)
+    {
+        const float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f)
+            plane = plane / length;
+    }
+
+    return frustum;
+}
+
+bool utils::isVisible(const utils::Frustum& i_frustum, const utils::Bounds& i_bounds)
+{
+    for (const auto& plane : i_frustum.d_planes)
+    {
+        if (isOutside(plane, i_bounds.d_center.x, i_bounds.d_center.y, i_bounds.d_center.z, i_bounds.d_extents.x, i_bounds.d_extents.y, i_bounds.d_extents.z))
+            return false;
+    }
+    return true;
+}
+
+void utils::AabbBatch::add(const utils::Bounds& i_bounds)
+{
+    d_centerX.push_back(i_bounds.d_center.x);
+    d_centerY.push_back(i_bounds.d_center.y);
+    d_centerZ.push_back(i_bounds.d_center.z);
+    d_extentX.push_back(i_bounds.d_extents.x);
+    d_extentY.push_back(i_bounds.d_extents.y);
+    d_extentZ.push_back(i_bounds.d_extents.z);
+}
+
+void utils::AabbBatch::clear()
+{
+    d_centerX.clear();
+    d_centerY.clear();
+    d_centerZ.clear();
+    d_extentX.clear();
+    d_extentY.clear();
+    d_extentZ.clear();
+}
+
+std::size_t utils::AabbBatch::size() const
+{
+    return d_centerX.size();
+}
+
+void utils::AabbBatch::cull(const utils::Frustum& i_frustum, std::span<std::uint8_t> o_visible) const
+{
+    cull(i_frustum, o_visible, utils::getBestCullKernel());
+}
+
+void utils::AabbBatch::cull(const utils::Frustum& i_frustum, std::span<std::uint8_t> o_visible, utils::CullKernel i_kernel) const
+{
+    const std::size_t count = size();
+    if (o_visible.size() < count)
+        throw std::runtime_error("Culling result is smaller than the batch");
+    if (!utils::isCullKernelSupported(i_kernel))
+        throw std::runtime_error("Culling kernel " + std::to_string(static_cast<int>(i_kernel)) + " isn't supported");
+
+    const BoxArrays boxes = { d_centerX.data(), d_centerY.data(), d_centerZ.data(), d_extentX.data(), d_extentY.data(), d_extentZ.data() };
+    std::size_t culledCount = 0;
+#if defined(UTILS_CULL_AVX)
+    if (i_kernel == utils::CullKernel::Avx)
+        culledCount = cullAvx(i_frustum, boxes, count, o_visible.data());
+#endif
+#if defined(UTILS_CULL_SSE)
+    // SSE also takes the group of 4 AVX leaves
+    if (i_kernel != utils::CullKernel::Scalar)
+        culledCount += cullSse(i_frustum, { boxes[0] + culledCount, boxes[1] + culledCount, boxes[2] + culledCount, boxes[3] + culledCount,
+                                            boxes[4] + culledCount, boxes[5] + culledCount }, count - culledCount, o_visible.data() + culledCount);
+#endif
+
+    // the remainder, or everything without SIMD
+    cullScalar(i_frustum, boxes, culledCount, count, o_visible.data());
+}
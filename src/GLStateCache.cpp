@@ -0,0 +1,297 @@
+#include "GLStateCache.hpp"
+
+#include <algorithm>
+
+namespace
+{
+// index of the tracked buffer targets, BUFFER_TARGETS_COUNT for the untracked ones
+std::size_t getBufferTargetIndex(GLenum i_target)
+{
+    switch (i_target)
+    {
+    case GL_ARRAY_BUFFER:
+        return 0;
+    case GL_COPY_READ_BUFFER:
+        return 1;
+    case GL_COPY_WRITE_BUFFER:
+        return 2;
+    case GL_PIXEL_PACK_BUFFER:
+        return 3;
+    case GL_PIXEL_UNPACK_BUFFER:
+        return 4;
+    case GL_UNIFORM_BUFFER:
+        return 5;
+    case GL_TEXTURE_BUFFER:
+        return 6;
+    default:
+        return 7;
+    }
+}
+
+std::size_t getTextureTargetIndex(GLenum i_target)
+{
+    switch (i_target)
+    {
+    case GL_TEXTURE_2D:
+        return 0;
+    case GL_TEXTURE_2D_ARRAY:
+        return 1;
+    case GL_TEXTURE_CUBE_MAP:
+        return 2;
+    case GL_TEXTURE_BUFFER:
+        return 3;
+    default:
+        return 4;
+    }
+}
+
+std::int8_t toState(bool i_isEnabled)
+{
+    return i_isEnabled ? 1 : 0;
+}
+
+void setCapability(GLenum i_capability, bool i_isEnabled)
+{
+    if (i_isEnabled)
+        glEnable(i_capability);
+    else
+        glDisable(i_capability);
+}
+}
+
+utils::GLStateCache::GLStateCache()
+{
+    invalidate();
+}
+
+utils::GLStateCache& utils::GLStateCache::getInstance()
+{
+    static GLStateCache cache;
+    return cache;
+}
+
+bool utils::GLStateCache::isRedundant(bool i_isSame)
+{
+    if (i_isSame)
+        ++d_stats.d_skippedCalls;
+    else
+        ++d_stats.d_issuedCalls;
+    return i_isSame;
+}
+
+void utils::GLStateCache::useProgram(GLuint i_program)
+{
+    if (isRedundant(d_program == i_program))
+        return;
+
+    glUseProgram(i_program);
+    d_program = i_program;
+}
+
+void utils::GLStateCache::bindVertexArray(GLuint i_vertexArray)
+{
+    if (isRedundant(d_vertexArray == i_vertexArray))
+        return;
+
+    glBindVertexArray(i_vertexArray);
+    d_vertexArray = i_vertexArray;
+}
+
+void utils::GLStateCache::bindFramebuffer(GLuint i_framebuffer)
+{
+    if (isRedundant(d_drawFramebuffer == i_framebuffer && d_readFramebuffer == i_framebuffer))
+        return;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, i_framebuffer);
+    d_drawFramebuffer = i_framebuffer;
+    d_readFramebuffer = i_framebuffer;
+}
+
+void utils::GLStateCache::bindDrawFramebuffer(GLuint i_framebuffer)
+{
+    if (isRedundant(d_drawFramebuffer == i_framebuffer))
+        return;
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, i_framebuffer);
+    d_drawFramebuffer = i_framebuffer;
+}
+
+void utils::GLStateCache::bindReadFramebuffer(GLuint i_framebuffer)
+{
+    if (isRedundant(d_readFramebuffer == i_framebuffer))
+        return;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, i_framebuffer);
+    d_readFramebuffer = i_framebuffer;
+}
+
+void utils::GLStateCache::bindBuffer(GLenum i_target, GLuint i_buffer)
+{
+    const std::size_t target = getBufferTargetIndex(i_target);
+    if (target == BUFFER_TARGETS_COUNT)
+    {
+        ++d_stats.d_issuedCalls;
+        glBindBuffer(i_target, i_buffer);
+        return;
+    }
+
+    if (isRedundant(d_buffers[target] == i_buffer))
+        return;
+
+    glBindBuffer(i_target, i_buffer);
+    d_buffers[target] = i_buffer;
+}
+
+void utils::GLStateCache::bindBufferBase(GLenum i_target, GLuint i_index, GLuint i_buffer)
+{
+    ++d_stats.d_issuedCalls;
+    glBindBufferBase(i_target, i_index, i_buffer);
+
+    const std::size_t target = getBufferTargetIndex(i_target);
+    if (target != BUFFER_TARGETS_COUNT)
+        d_buffers[target] = i_buffer;
+}
+
+void utils::GLStateCache::bindTexture(GLuint i_unit, GLenum i_target, GLuint i_texture)
+{
+    const std::size_t target = getTextureTargetIndex(i_target);
+    if (i_unit >= TEXTURE_UNITS_COUNT || target == TEXTURE_TARGETS_COUNT)
+    {
+        activeTexture(i_unit);
+        ++d_stats.d_issuedCalls;
+        glBindTexture(i_target, i_texture);
+        return;
+    }
+
+    if (isRedundant(d_textures[i_unit][target] == i_texture))
+        return;
+
+    activeTexture(i_unit);
+    glBindTexture(i_target, i_texture);
+    d_textures[i_unit][target] = i_texture;
+}
+
+void utils::GLStateCache::activeTexture(GLuint i_unit)
+{
+    if (isRedundant(d_activeTextureUnit == i_unit))
+        return;
+
+    glActiveTexture(GL_TEXTURE0 + i_unit);
+    d_activeTextureUnit = i_unit;
+}
+
+void utils::GLStateCache::setDepthTest(bool i_isEnabled)
+{
+    if (isRedundant(d_isDepthTestEnabled == toState(i_isEnabled)))
+        return;
+
+    setCapability(GL_DEPTH_TEST, i_isEnabled);
+    d_isDepthTestEnabled = toState(i_isEnabled);
+}
+
+void utils::GLStateCache::setDepthMask(bool i_isEnabled)
+{
+    if (isRedundant(d_isDepthMaskEnabled == toState(i_isEnabled)))
+        return;
+
+    glDepthMask(i_isEnabled ? GL_TRUE : GL_FALSE);
+    d_isDepthMaskEnabled = toState(i_isEnabled);
+}
+
+void utils::GLStateCache::setDepthFunc(GLenum i_func)
+{
+    if (isRedundant(d_depthFunc == i_func))
+        return;
+
+    glDepthFunc(i_func);
+    d_depthFunc = i_func;
+}
+
+void utils::GLStateCache::setBlend(bool i_isEnabled)
+{
+    if (isRedundant(d_isBlendEnabled == toState(i_isEnabled)))
+        return;
+
+    setCapability(GL_BLEND, i_isEnabled);
+    d_isBlendEnabled = toState(i_isEnabled);
+}
+
+void utils::GLStateCache::setBlendFunc(GLenum i_source, GLenum i_destination)
+{
+    const std::array<GLenum, 2> blendFunc = { i_source, i_destination };
+    if (isRedundant(d_blendFunc == blendFunc))
+        return;
+
+    glBlendFunc(i_source, i_destination);
+    d_blendFunc = blendFunc;
+}
+
+void utils::GLStateCache::setViewport(GLint i_x, GLint i_y, GLsizei i_width, GLsizei i_height)
+{
+    const std::array<GLint, 4> viewport = { i_x, i_y, i_width, i_height };
+    if (isRedundant(d_viewport == viewport))
+        return;
+
+    glViewport(i_x, i_y, i_width, i_height);
+    d_viewport = viewport;
+}
+
+void utils::GLStateCache::onProgramDeleted(GLuint i_program)
+{
+    if (d_program == i_program)
+        d_program = UNKNOWN;
+}
+
+void utils::GLStateCache::onVertexArrayDeleted(GLuint i_vertexArray)
+{
+    if (d_vertexArray == i_vertexArray)
+        d_vertexArray = 0;
+}
+
+void utils::GLStateCache::onFramebufferDeleted(GLuint i_framebuffer)
+{
+    if (d_drawFramebuffer == i_framebuffer)
+        d_drawFramebuffer = 0;
+    if (d_readFramebuffer == i_framebuffer)
+        d_readFramebuffer = 0;
+}
+
+void utils::GLStateCache::onBufferDeleted(GLuint i_buffer)
+{
+    std::replace(d_buffers.begin(), d_buffers.end(), i_buffer, GLuint(0));
+}
+
+void utils::GLStateCache::onTextureDeleted(GLuint i_texture)
+{
+    for (auto& unit : d_textures)
+        std::replace(unit.begin(), unit.end(), i_texture, GLuint(0));
+}
+
+void utils::GLStateCache::invalidate()
+{
+    d_program = UNKNOWN;
+    d_vertexArray = UNKNOWN;
+    d_drawFramebuffer = UNKNOWN;
+    d_readFramebuffer = UNKNOWN;
+    d_buffers.fill(UNKNOWN);
+    for (auto& unit : d_textures)
+        unit.fill(UNKNOWN);
+    d_activeTextureUnit = UNKNOWN;
+
+    d_isDepthTestEnabled = -1;
+    d_isDepthMaskEnabled = -1;
+    d_isBlendEnabled = -1;
+    d_depthFunc = UNKNOWN;
+    d_blendFunc.fill(UNKNOWN);
+    d_viewport.fill(-1);
+}
+
+const utils::GLStateStats& utils::GLStateCache::getStats() const
+{
+    return d_stats;
+}
+
+void utils::GLStateCache::resetStats()
+{
+    d_stats = {};
+}
@@ -0,0 +1,104 @@
+#include "GeometryPool.hpp"
+
+#include "GLStateCache.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+size_t alignUp(size_t i_value, size_t i_alignment)
+{
+    return (i_value + i_alignment - 1) / i_alignment * i_alignment;
+}
+}
+
+utils::GeometryPool::GeometryPool(utils::VertexFormat i_vertexFormat, size_t i_vertexCapacity /* = 4 << 20 */, size_t i_indexCapacity /* = 1 << 20 */)
+    : d_vertexFormat(i_vertexFormat)
+    , d_VAO(utils::VertexArrayHandle::create())
+    , d_VBO(utils::BufferHandle::create())
+    , d_EBO(utils::BufferHandle::create())
+    , d_vertexCapacity(i_vertexCapacity)
+    , d_indexCapacity(i_indexCapacity)
+{
+    auto& glState = utils::GLStateCache::getInstance();
+    glState.bindVertexArray(d_VAO.get());
+    glState.bindBuffer(GL_ARRAY_BUFFER, d_VBO.get());
+    glBufferData(GL_ARRAY_BUFFER, d_vertexCapacity, nullptr, GL_STATIC_DRAW);
+    glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, d_EBO.get());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, d_indexCapacity, nullptr, GL_STATIC_DRAW);
+    utils::setVertexAttributes(d_vertexFormat);
+    glState.bindVertexArray(0);
+}
+
+utils::GeometryRange utils::GeometryPool::allocate(std::span<const std::byte> i_vertices, std::span<const std::byte> i_indices, GLenum i_indexType)
+{
+    const size_t vertexSize = utils::getVertexSize(d_vertexFormat);
+    if (i_vertices.size() % vertexSize != 0)
+        throw std::runtime_error("Vertex data doesn't match the pool's vertex format");
+
+    // base vertex addresses whole vertices, index offsets are kept 4-byte aligned for mixed index types
+    const size_t vertexOffset = alignUp(d_vertexBytesUsed, vertexSize);
+    const size_t indexOffset = alignUp(d_indexBytesUsed, sizeof(std::uint32_t));
+
+    auto& glState = utils::GLStateCache::getInstance();
+    glState.bindVertexArray(d_VAO.get());
+    if (vertexOffset + i_vertices.size() > d_vertexCapacity)
+        grow(d_VBO, GL_ARRAY_BUFFER, d_vertexCapacity, d_vertexBytesUsed, vertexOffset + i_vertices.size());
+    if (indexOffset + i_indices.size() > d_indexCapacity)
+        grow(d_EBO, GL_ELEMENT_ARRAY_BUFFER, d_indexCapacity, d_indexBytesUsed, indexOffset + i_indices.size());
+
+    glState.bindBuffer(GL_ARRAY_BUFFER, d_VBO.get());
+    glBufferSubData(GL_ARRAY_BUFFER, vertexOffset, i_vertices.size(), i_vertices.data());
+    glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, d_EBO.get());
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexOffset, i_indices.size(), i_indices.data());
+    glState.bindVertexArray(0);
+
+    d_vertexBytesUsed = vertexOffset + i_vertices.size();
+    d_indexBytesUsed = indexOffset + i_indices.size();
+
+    GeometryRange range;
+    range.d_VAO = d_VAO.get();
+    range.d_baseVertex = static_cast<GLint>(vertexOffset / vertexSize);
+    range.d_indexOffset = indexOffset;
+    range.d_indicesCount = static_cast<GLsizei>(i_indices.size() / utils::getIndexSize(i_indexType));
+    range.d_indexType = i_indexType;
+    return range;
+}
+
+GLuint utils::GeometryPool::getVAO() const
+{
+    return d_VAO.get();
+}
+
+utils::VertexFormat utils::GeometryPool::getVertexFormat() const
+{
+    return d_vertexFormat;
+}
+
+size_t utils::GeometryPool::getUsedBytes() const
+{
+    return d_vertexBytesUsed + d_indexBytesUsed;
+}
+
+void utils::GeometryPool::grow(utils::BufferHandle& io_buffer, GLenum i_target, size_t& io_capacity, size_t i_usedBytes, size_t i_requiredBytes)
+{
+    size_t capacity = std::max<size_t>(io_capacity, 1);
+    while (capacity < i_requiredBytes)
+        capacity *= 2;
+
+    auto& glState = utils::GLStateCache::getInstance();
+    auto buffer = utils::BufferHandle::create();
+    glState.bindBuffer(GL_COPY_WRITE_BUFFER, buffer.get());
+    glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STATIC_DRAW);
+
+    glState.bindBuffer(GL_COPY_READ_BUFFER, io_buffer.get());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, i_usedBytes);
+
+    // the pool's VAO is bound, attach the new buffer to it; the old one is deleted by the move
+    io_buffer = std::move(buffer);
+    io_capacity = capacity;
+    glState.bindBuffer(i_target, io_buffer.get());
+    if (i_target == GL_ARRAY_BUFFER)
+        utils::setVertexAttributes(d_vertexFormat);
+}
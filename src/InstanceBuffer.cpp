@@ -0,0 +1,79 @@
+#include "InstanceBuffer.hpp"
+
+#include "Bounds.hpp"
+#include "GLStateCache.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+utils::InstanceBuffer::InstanceBuffer() : d_buffer(utils::BufferHandle::create())
+{
+}
+
+void utils::InstanceBuffer::update(std::span<const glm::mat4> i_transforms, std::span<const glm::vec4> i_data /* = {} */)
+{
+    d_staging.resize(i_transforms.size());
+    d_positions.resize(i_transforms.size());
+    d_maxScale = 0.0f;
+    for (size_t i = 0; i < i_transforms.size(); ++i)
+    {
+        d_staging[i].d_transform = i_transforms[i];
+        d_staging[i].d_data = i < i_data.size() ? i_data[i] : glm::vec4(0.0f);
+        d_positions[i] = glm::vec3(i_transforms[i][3]);
+        d_maxScale = std::max(d_maxScale, utils::getMaxScale(i_transforms[i]));
+    }
+
+    const auto bytes = std::as_bytes(std::span<const utils::InstanceData>(d_staging));
+    utils::GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, d_buffer.get());
+    if (d_staging.size() > d_capacity)
+    {
+        d_capacity = std::max(d_staging.size(), d_capacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, d_capacity * sizeof(utils::InstanceData), nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes.size(), bytes.data());
+}
+
+void utils::InstanceBuffer::enableAttributes() const
+{
+    static constexpr GLsizei stride = sizeof(utils::InstanceData);
+
+    utils::GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, d_buffer.get());
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        const GLuint location = utils::INSTANCE_TRANSFORM_LOCATION + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<void*>(offsetof(utils::InstanceData, d_transform) + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+
+    glEnableVertexAttribArray(utils::INSTANCE_DATA_LOCATION);
+    glVertexAttribPointer(utils::INSTANCE_DATA_LOCATION, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(utils::InstanceData, d_data)));
+    glVertexAttribDivisor(utils::INSTANCE_DATA_LOCATION, 1);
+}
+
+void utils::InstanceBuffer::disableAttributes()
+{
+    // the VAO may be shared with non-instanced draws, they must not see the instance arrays
+    for (GLuint location = utils::INSTANCE_TRANSFORM_LOCATION; location <= utils::INSTANCE_DATA_LOCATION; ++location)
+    {
+        glVertexAttribDivisor(location, 0);
+        glDisableVertexAttribArray(location);
+    }
+}
+
+size_t utils::InstanceBuffer::getInstancesCount() const
+{
+    return d_staging.size();
+}
+
+std::span<const glm::vec3> utils::InstanceBuffer::getPositions() const
+{
+    return d_positions;
+}
+
+float utils::InstanceBuffer::getMaxScale() const
+{
+    return d_maxScale;
+}
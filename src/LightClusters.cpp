@@ -0,0 +1,314 @@
+#include "LightClusters.hpp"
+
+#include "GLStateCache.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+// a light is cut off where it adds less than this fraction of its brightest color channel
+static constexpr float LIGHT_CUTOFF = 1.0f / 256.0f;
+// lights are prepared in chunks, a task per light would cost more than the work
+static constexpr std::size_t LIGHTS_PER_TASK = 256;
+// texels of a packed light, see the CLUSTERED_LIGHTS part of fragment.fs
+static constexpr std::size_t LIGHT_TEXELS = 5;
+
+float getRange(float i_constant, float i_linear, float i_quadratic, const glm::vec3& i_diffuse, const glm::vec3& i_specular)
+{
+    // solves quadratic * d^2 + linear * d + constant = brightness / cutoff
+    const glm::vec3 color = glm::max(i_diffuse, i_specular);
+    const float attenuation = std::max({ color.x, color.y, color.z }) / LIGHT_CUTOFF;
+    if (attenuation <= i_constant)
+        return 0.0f;
+    if (i_quadratic > 0.0f)
+        return (-i_linear + std::sqrt(i_linear * i_linear + 4.0f * i_quadratic * (attenuation - i_constant))) / (2.0f * i_quadratic);
+    if (i_linear > 0.0f)
+        return (attenuation - i_constant) / i_linear;
+    return std::numeric_limits<float>::max();
+}
+
+// the smallest sphere around a cone of the given half angle and length, wide cones are bounded by their cap
+glm::vec4 getConeSphere(const glm::vec3& i_apex, const glm::vec3& i_direction, float i_cosHalfAngle, float i_length)
+{
+    if (i_cosHalfAngle <= 0.0f)
+        return glm::vec4(i_apex, i_length);
+    if (i_cosHalfAngle < std::sqrt(0.5f))
+        return glm::vec4(i_apex + i_direction * (i_cosHalfAngle * i_length), std::sqrt(1.0f - i_cosHalfAngle * i_cosHalfAngle) * i_length);
+
+    const float radius = i_length / (2.0f * i_cosHalfAngle);
+    return glm::vec4(i_apex + i_direction * radius, radius);
+}
+
+// ndc coordinate to the tile containing it
+std::uint32_t toTile(float i_ndc, std::uint32_t i_tilesCount)
+{
+    const float tile = (std::clamp(i_ndc, -1.0f, 1.0f) * 0.5f + 0.5f) * static_cast<float>(i_tilesCount);
+    return std::min(static_cast<std::uint32_t>(tile), i_tilesCount - 1);
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point i_start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - i_start).count();
+}
+}
+
+float utils::getLightRange(const utils::PointLightUniforms& i_light)
+{
+    return getRange(i_light.d_constant, i_light.d_linear, i_light.d_quadratic, i_light.d_diffuse, i_light.d_specular);
+}
+
+float utils::getLightRange(const utils::SpotLightUniforms& i_light)
+{
+    return getRange(i_light.d_constant, i_light.d_linear, i_light.d_quadratic, i_light.d_diffuse, i_light.d_specular);
+}
+
+utils::LightClusters::LightClusters(const glm::uvec3& i_gridSize /* = glm::uvec3(16, 9, 24) */, std::uint32_t i_maxClusterLights /* = 256 */)
+    : d_gridSize(i_gridSize), d_maxClusterLights(i_maxClusterLights)
+{
+    if (d_gridSize.x == 0 || d_gridSize.y == 0 || d_gridSize.z == 0)
+        throw std::runtime_error("Bad light cluster grid: " + std::to_string(d_gridSize.x) + 'x' + std::to_string(d_gridSize.y) + 'x'
+                                 + std::to_string(d_gridSize.z));
+
+    const std::size_t clustersCount = static_cast<std::size_t>(d_gridSize.x) * d_gridSize.y * d_gridSize.z;
+    d_clusterLights.resize(clustersCount);
+    d_clusters.resize(clustersCount);
+}
+
+void utils::LightClusters::build(const glm::mat4& i_view, const glm::mat4& i_projection, std::span<const utils::PointLightUniforms> i_pointLights,
+                                 std::span<const utils::SpotLightUniforms> i_spotLights)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+
+    // the frustum of a glm::perspective matrix
+    d_tanHalfFov = glm::vec2(1.0f / i_projection[0][0], 1.0f / i_projection[1][1]);
+    d_near = i_projection[3][2] / (i_projection[2][2] - 1.0f);
+    d_far = i_projection[3][2] / (i_projection[2][2] + 1.0f);
+    const float depthRatio = std::log(d_far / d_near);
+    d_sliceScale = static_cast<float>(d_gridSize.z) / depthRatio;
+    d_sliceBias = -static_cast<float>(d_gridSize.z) * std::log(d_near) / depthRatio;
+
+    d_sliceDepths.resize(d_gridSize.z + 1);
+    for (std::uint32_t slice = 0; slice <= d_gridSize.z; ++slice)
+        d_sliceDepths[slice] = d_near * std::pow(d_far / d_near, static_cast<float>(slice) / static_cast<float>(d_gridSize.z));
+
+    // view space bounds of every light, the ones outside the frustum get an empty slice range
+    const std::size_t lightsCount = i_pointLights.size() + i_spotLights.size();
+    d_lightSpheres.resize(lightsCount);
+    d_lightSlices.resize(lightsCount);
+    const glm::vec2 sidePlaneScale = 1.0f / glm::sqrt(1.0f + d_tanHalfFov * d_tanHalfFov);
+    auto& threadPool = utils::ThreadPool::getInstance();
+    threadPool.parallelFor((lightsCount + LIGHTS_PER_TASK - 1) / LIGHTS_PER_TASK, [&](std::size_t i_task)
+    {
+        const std::size_t end = std::min(lightsCount, (i_task + 1) * LIGHTS_PER_TASK);
+        for (std::size_t light = i_task * LIGHTS_PER_TASK; light < end; ++light)
+        {
+            glm::vec4 sphere;
+            if (light < i_pointLights.size())
+            {
+                const auto& pointLight = i_pointLights[light];
+                sphere = glm::vec4(pointLight.d_position, utils::getLightRange(pointLight));
+            }
+            else
+            {
+                const auto& spotLight = i_spotLights[light - i_pointLights.size()];
+                sphere = getConeSphere(spotLight.d_position, glm::normalize(spotLight.d_direction), spotLight.d_outerCutOff,
+                                       utils::getLightRange(spotLight));
+            }
+
+            const glm::vec3 center = glm::vec3(i_view * glm::vec4(glm::vec3(sphere), 1.0f));
+            const float radius = sphere.w;
+            d_lightSpheres[light] = glm::vec4(center, radius);
+
+            // the distances to the side planes, |x| <= depth * tan(half fov) inside
+            const float depth = -center.z;
+            const glm::vec2 sideDistances = (glm::abs(glm::vec2(center)) - depth * d_tanHalfFov) * sidePlaneScale;
+            const bool isVisible = radius > 0.0f && depth + radius >= d_near && depth - radius <= d_far && sideDistances.x <= radius
+                && sideDistances.y <= radius;
+            d_lightSlices[light] = isVisible ? glm::uvec2(getSlice(depth - radius), getSlice(depth + radius)) : glm::uvec2(1u, 0u);
+        }
+    });
+
+    // a slice only writes its own clusters
+    threadPool.parallelFor(d_gridSize.z, [this](std::size_t i_slice) { binSlice(static_cast<std::uint32_t>(i_slice)); });
+
+    d_stats = {};
+    d_stats.d_lightsCount = lightsCount;
+    d_stats.d_visibleLightsCount = static_cast<std::size_t>(std::count_if(d_lightSlices.begin(), d_lightSlices.end(), [](const glm::uvec2& i_slices)
+    {
+        return i_slices.x <= i_slices.y;
+    }));
+
+    d_lightIndices.clear();
+    for (std::size_t cluster = 0; cluster < d_clusters.size(); ++cluster)
+    {
+        const auto& lights = d_clusterLights[cluster];
+        const std::size_t count = std::min<std::size_t>(lights.size(), d_maxClusterLights);
+        d_clusters[cluster] = glm::uvec2(static_cast<std::uint32_t>(d_lightIndices.size()), static_cast<std::uint32_t>(count));
+        d_lightIndices.insert(d_lightIndices.end(), lights.begin(), lights.begin() + static_cast<std::ptrdiff_t>(count));
+
+        d_stats.d_maxClusterLights = std::max(d_stats.d_maxClusterLights, lights.size());
+        d_stats.d_droppedLights += lights.size() - count;
+    }
+    d_stats.d_lightIndicesCount = d_lightIndices.size();
+    d_stats.d_buildMilliseconds = millisecondsSince(startTime);
+}
+
+std::uint32_t utils::LightClusters::getSlice(float i_depth) const
+{
+    if (i_depth <= d_near)
+        return 0;
+    const float slice = std::log(i_depth) * d_sliceScale + d_sliceBias;
+    return std::min(static_cast<std::uint32_t>(std::max(slice, 0.0f)), d_gridSize.z - 1);
+}
+
+void utils::LightClusters::binSlice(std::uint32_t i_slice)
+{
+    const std::size_t sliceSize = static_cast<std::size_t>(d_gridSize.x) * d_gridSize.y;
+    const auto sliceLights = std::span(d_clusterLights).subspan(i_slice * sliceSize, sliceSize);
+    for (auto& lights : sliceLights)
+        lights.clear();
+
+    const float sliceNear = d_sliceDepths[i_slice];
+    const float sliceFar = d_sliceDepths[i_slice + 1];
+    for (std::size_t light = 0; light < d_lightSpheres.size(); ++light)
+    {
+        const auto& slices = d_lightSlices[light];
+        if (i_slice < slices.x || i_slice > slices.y)
+            continue;
+
+        // the sphere's bounding box between the planes of the slice it overlaps, projected to the near one and the far one
+        const glm::vec4& sphere = d_lightSpheres[light];
+        const float depth = -sphere.z;
+        const float nearDepth = std::max(sliceNear, depth - sphere.w);
+        const float farDepth = std::min(sliceFar, depth + sphere.w);
+        const glm::vec2 low = glm::vec2(sphere) - sphere.w;
+        const glm::vec2 high = glm::vec2(sphere) + sphere.w;
+        const glm::vec2 lowNdc = glm::min(low / nearDepth, low / farDepth) / d_tanHalfFov;
+        const glm::vec2 highNdc = glm::max(high / nearDepth, high / farDepth) / d_tanHalfFov;
+        if (highNdc.x < -1.0f || highNdc.y < -1.0f || lowNdc.x > 1.0f || lowNdc.y > 1.0f)
+            continue;
+
+        const std::uint32_t firstX = toTile(lowNdc.x, d_gridSize.x);
+        const std::uint32_t lastX = toTile(highNdc.x, d_gridSize.x);
+        const std::uint32_t firstY = toTile(lowNdc.y, d_gridSize.y);
+        const std::uint32_t lastY = toTile(highNdc.y, d_gridSize.y);
+        for (std::uint32_t y = firstY; y <= lastY; ++y)
+        {
+            for (std::uint32_t x = firstX; x <= lastX; ++x)
+                sliceLights[y * d_gridSize.x + x].push_back(static_cast<std::uint32_t>(light));
+        }
+    }
+}
+
+const glm::uvec3& utils::LightClusters::getGridSize() const
+{
+    return d_gridSize;
+}
+
+std::uint32_t utils::LightClusters::getMaxClusterLights() const
+{
+    return d_maxClusterLights;
+}
+
+std::span<const glm::uvec2> utils::LightClusters::getClusters() const
+{
+    return d_clusters;
+}
+
+std::span<const std::uint32_t> utils::LightClusters::getLightIndices() const
+{
+    return d_lightIndices;
+}
+
+utils::ClusterUniforms utils::LightClusters::getUniforms(const glm::vec2& i_viewportSize) const
+{
+    utils::ClusterUniforms uniforms;
+    uniforms.d_gridSize = glm::uvec4(d_gridSize, 0u);
+    uniforms.d_depthParams = glm::vec4(d_sliceScale, d_sliceBias, d_near, d_far);
+    uniforms.d_screenParams = glm::vec4(glm::vec2(d_gridSize) / i_viewportSize, i_viewportSize);
+    return uniforms;
+}
+
+const utils::LightClustersStats& utils::LightClusters::getStats() const
+{
+    return d_stats;
+}
+
+utils::LightClusterBuffers::LightClusterBuffers(const utils::LightClusters& i_clusters)
+    : d_lights(createTextureBuffer(utils::CLUSTER_LIGHTS_UNIT, GL_RGBA32F))
+    , d_ranges(createTextureBuffer(utils::CLUSTER_RANGES_UNIT, GL_RG32UI))
+    , d_lightIndices(createTextureBuffer(utils::CLUSTER_LIGHT_INDICES_UNIT, GL_R32UI))
+    , d_uniforms(utils::CLUSTER_UNIFORMS_BINDING, sizeof(utils::ClusterUniforms))
+{
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    const std::size_t maxLightIndices = i_clusters.getClusters().size() * i_clusters.getMaxClusterLights();
+    if (maxLightIndices > static_cast<std::size_t>(maxTexels))
+        throw std::runtime_error("Texture buffers of " + std::to_string(maxTexels) + " texels can't hold " + std::to_string(maxLightIndices)
+                                 + " light indices");
+    d_maxLightsCount = static_cast<std::size_t>(maxTexels) / LIGHT_TEXELS;
+}
+
+void utils::LightClusterBuffers::update(const utils::LightClusters& i_clusters, std::span<const utils::PointLightUniforms> i_pointLights,
+                                        std::span<const utils::SpotLightUniforms> i_spotLights, const glm::vec2& i_viewportSize)
+{
+    // texelFetch past the end of a texture buffer is undefined, the lights beyond it wouldn't be read
+    const std::size_t lightsCount = i_pointLights.size() + i_spotLights.size();
+    if (lightsCount > d_maxLightsCount)
+        throw std::runtime_error("Texture buffers of " + std::to_string(d_maxLightsCount * LIGHT_TEXELS) + " texels can't hold " + std::to_string(lightsCount)
+                                 + " lights");
+
+    // every light is shaded as a spot light, a point light's cone covers all directions
+    d_packedLights.clear();
+    d_packedLights.reserve(lightsCount * LIGHT_TEXELS);
+    for (const auto& light : i_pointLights)
+    {
+        d_packedLights.emplace_back(light.d_position, -1.0f);
+        d_packedLights.emplace_back(0.0f, 0.0f, -1.0f, -2.0f);
+        d_packedLights.emplace_back(light.d_ambient, light.d_constant);
+        d_packedLights.emplace_back(light.d_diffuse, light.d_linear);
+        d_packedLights.emplace_back(light.d_specular, light.d_quadratic);
+    }
+    for (const auto& light : i_spotLights)
+    {
+        d_packedLights.emplace_back(light.d_position, light.d_cutOff);
+        d_packedLights.emplace_back(light.d_direction, light.d_outerCutOff);
+        d_packedLights.emplace_back(light.d_ambient, light.d_constant);
+        d_packedLights.emplace_back(light.d_diffuse, light.d_linear);
+        d_packedLights.emplace_back(light.d_specular, light.d_quadratic);
+    }
+
+    upload(d_lights, std::as_bytes(std::span<const glm::vec4>(d_packedLights)));
+    upload(d_ranges, std::as_bytes(i_clusters.getClusters()));
+    upload(d_lightIndices, std::as_bytes(i_clusters.getLightIndices()));
+    d_uniforms.update(i_clusters.getUniforms(i_viewportSize));
+}
+
+std::size_t utils::LightClusterBuffers::getMaxLightsCount() const
+{
+    return d_maxLightsCount;
+}
+
+utils::LightClusterBuffers::TextureBuffer utils::LightClusterBuffers::createTextureBuffer(GLuint i_unit, GLenum i_format)
+{
+    TextureBuffer textureBuffer{ utils::BufferHandle::create(), utils::TextureHandle::create() };
+
+    auto& glState = utils::GLStateCache::getInstance();
+    glState.bindBuffer(GL_TEXTURE_BUFFER, textureBuffer.d_buffer.get());
+    glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+    glState.bindTexture(i_unit, GL_TEXTURE_BUFFER, textureBuffer.d_texture.get());
+    glTexBuffer(GL_TEXTURE_BUFFER, i_format, textureBuffer.d_buffer.get());
+    return textureBuffer;
+}
+
+void utils::LightClusterBuffers::upload(const TextureBuffer& i_textureBuffer, std::span<const std::byte> i_bytes)
+{
+    utils::GLStateCache::getInstance().bindBuffer(GL_TEXTURE_BUFFER, i_textureBuffer.d_buffer.get());
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(i_bytes.size()), i_bytes.data(), GL_STREAM_DRAW);
+}
@@ -0,0 +1,152 @@
+#include "MappedFile.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+utils::MappedFile::MappedFile(const std::filesystem::path& i_path)
+{
+#ifdef _WIN32
+    d_fileHandle = CreateFileW(i_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (d_fileHandle == INVALID_HANDLE_VALUE)
+    {
+        d_fileHandle = nullptr;
+        throw std::runtime_error("Failed to open: " + i_path.string());
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(d_fileHandle, &fileSize))
+    {
+        release();
+        throw std::runtime_error("Failed to get size of: " + i_path.string());
+    }
+    d_size = static_cast<std::size_t>(fileSize.QuadPart);
+    if (d_size == 0)
+        return;
+
+    d_mappingHandle = CreateFileMappingW(d_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!d_mappingHandle)
+    {
+        release();
+        throw std::runtime_error("Failed to map: " + i_path.string());
+    }
+
+    d_data = static_cast<const std::byte*>(MapViewOfFile(d_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!d_data)
+    {
+        release();
+        throw std::runtime_error("Failed to map: " + i_path.string());
+    }
+#else
+    const int fd = open(i_path.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw std::runtime_error("Failed to open: " + i_path.string());
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == -1)
+    {
+        close(fd);
+        throw std::runtime_error("Failed to get size of: " + i_path.string());
+    }
+
+    d_size = static_cast<std::size_t>(fileStat.st_size);
+    if (d_size > 0)
+    {
+        void* data = mmap(nullptr, d_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error("Failed to map: " + i_path.string());
+        }
+        d_data = static_cast<const std::byte*>(data);
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+#endif
+}
+
+utils::MappedFile::~MappedFile()
+{
+    release();
+}
+
+utils::MappedFile::MappedFile(MappedFile&& io_other) noexcept
+    : d_data(std::exchange(io_other.d_data, nullptr)), d_size(std::exchange(io_other.d_size, 0))
+#ifdef _WIN32
+    , d_fileHandle(std::exchange(io_other.d_fileHandle, nullptr))
+    , d_mappingHandle(std::exchange(io_other.d_mappingHandle, nullptr))
+#endif
+{
+}
+
+utils::MappedFile& utils::MappedFile::operator=(MappedFile&& io_other) noexcept
+{
+    if (this != &io_other)
+    {
+        release();
+        d_data = std::exchange(io_other.d_data, nullptr);
+        d_size = std::exchange(io_other.d_size, 0);
+#ifdef _WIN32
+        d_fileHandle = std::exchange(io_other.d_fileHandle, nullptr);
+        d_mappingHandle = std::exchange(io_other.d_mappingHandle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+const std::byte* utils::MappedFile::getData() const
+{
+    return d_data;
+}
+
+std::size_t utils::MappedFile::getSize() const
+{
+    return d_size;
+}
+
+void utils::MappedFile::release()
+{
+#ifdef _WIN32
+    if (d_data)
+        UnmapViewOfFile(d_data);
+    if (d_mappingHandle)
+        CloseHandle(d_mappingHandle);
+    if (d_fileHandle)
+        CloseHandle(d_fileHandle);
+    d_mappingHandle = nullptr;
+    d_fileHandle = nullptr;
+#else
+    if (d_data)
+        munmap(const_cast<std::byte*>(d_data), d_size);
+#endif
+    d_data = nullptr;
+    d_size = 0;
+}
+
+std::filesystem::path utils::getTemporaryPath(const std::filesystem::path& i_path)
+{
+#ifdef _WIN32
+    const auto processId = GetCurrentProcessId();
+#else
+    const auto processId = getpid();
+#endif
+    std::ostringstream suffix;
+    suffix << '.' << processId << '.' << std::this_thread::get_id() << ".tmp";
+    auto path = i_path;
+    path += suffix.str();
+    return path;
+}
@@ -1,50 +1,82 @@
 #include "Mesh.hpp"
 
+#include "GLStateCache.hpp"
+#include "Hash.hpp"
+#include "InstanceBuffer.hpp"
 #include "ShadersManager.hpp"
 #include "Texture.hpp"
+#include "TextureArray.hpp"
 
 #include <glad/glad.h>
 
-utils::Mesh::Mesh(const std::vector<utils::Vertex>& i_vertices, const std::vector<unsigned int>& i_indices, const std::vector<utils::Texture>& i_textures)
-	: d_vertices(i_vertices), d_indices(i_indices), d_textures(i_textures)
-{
-	glGenVertexArrays(1, &d_VAO);
-	glGenBuffers(1, &d_VBO);
-	glGenBuffers(1, &d_EBO);
+#include <algorithm>
 
-	glBindVertexArray(d_VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, d_VBO);
-	glBufferData(GL_ARRAY_BUFFER, d_vertices.size() * sizeof(Vertex), d_vertices.data(), GL_STATIC_DRAW);
+namespace
+{
+// meshes with the same textures in the same order can share the bindings, the layers are set per draw
+std::uint64_t hashMaterial(const utils::MeshMaterial& i_material)
+{
+	std::uint64_t hash = utils::fnv1a("");
+	for (const auto& texture : i_material.d_textures)
+	{
+		const GLuint textureId = texture->getId();
+		hash = utils::fnv1a(&textureId, sizeof(textureId), hash);
+	}
+	for (const auto& layer : i_material.d_layers)
+	{
+		const GLuint arrayId = layer.d_array->getId();
+		hash = utils::fnv1a(&arrayId, sizeof(arrayId), hash);
+	}
+	return hash;
+}
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, d_EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, d_indices.size() * sizeof(unsigned int), d_indices.data(), GL_STATIC_DRAW);
+// the textures first, then the layers, in the order they are bound
+std::vector<aiTextureType> getMaterialTypes(const utils::MeshMaterial& i_material)
+{
+	std::vector<aiTextureType> types;
+	for (const auto& texture : i_material.d_textures)
+		types.push_back(texture->getType());
+	for (const auto& layer : i_material.d_layers)
+		types.push_back(layer.d_type);
+	return types;
+}
 
-	// positions
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+// converts the geometry to what the GPU gets and hands the bytes over to i_upload
+template <typename Upload>
+void prepareGeometry(std::span<const utils::Vertex> i_vertices, std::span<const unsigned int> i_indices, utils::VertexFormat i_vertexFormat,
+					 GLenum i_indexType, utils::PositionTransform& o_transform, Upload&& i_upload)
+{
+	// float vertices are uploaded as is, the source may be a mapped cache file
+	std::vector<std::byte> packedVertices;
+	std::span<const std::byte> vertexBytes = std::as_bytes(i_vertices);
+	if (i_vertexFormat != utils::VertexFormat::Float)
+	{
+		packedVertices = utils::packVertices(i_vertices, i_vertexFormat, o_transform);
+		vertexBytes = packedVertices;
+	}
 
-	// normals
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(1 * sizeof(glm::vec3)));
-	
-	// texcoords
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(2 * sizeof(glm::vec3)));
+	std::vector<uint16_t> shortIndices;
+	std::span<const std::byte> indexBytes = std::as_bytes(i_indices);
+	if (i_indexType == GL_UNSIGNED_SHORT)
+	{
+		shortIndices.assign(i_indices.begin(), i_indices.end());
+		indexBytes = std::as_bytes(std::span<const uint16_t>(shortIndices));
+	}
 
-	glBindVertexArray(0);
+	i_upload(vertexBytes, indexBytes);
 }
 
-void utils::Mesh::Draw(const utils::ShadersManager& i_shaderManager)
+// sampler names follow the texture types, "texture_diffuse0", "texture_diffuse1", "texture_specular0"...
+std::vector<std::string> getSamplerNames(const std::vector<aiTextureType>& i_types)
 {
 	size_t diffuseCnt = 0;
 	size_t specularCnt = 0;
 
-	for (unsigned int i = 0; const auto& texture : d_textures)
+	std::vector<std::string> names;
+	for (const auto type : i_types)
 	{
-		texture.activate(GL_TEXTURE0 + i);
-
 		size_t texNumber = 0;
-		switch (texture.getType())
+		switch (type)
 		{
 		case aiTextureType::aiTextureType_DIFFUSE:
 			texNumber = diffuseCnt++;
@@ -56,20 +88,221 @@ void utils::Mesh::Draw(const utils::ShadersManager& i_shaderManager)
 			break;
 		}
 
-		const auto textureName = "texture_" + texture.getTypeAsString() + std::to_string(texNumber);
-		i_shaderManager.setFloat(textureName, static_cast<float>(i++));
+		names.push_back("texture_" + utils::Texture::getTypeAsString(type) + std::to_string(texNumber));
+	}
+	return names;
+}
+
+std::vector<utils::UniformId> getSamplerUniforms(const utils::MeshMaterial& i_material)
+{
+	std::vector<utils::UniformId> uniforms;
+	for (const auto& name : getSamplerNames(getMaterialTypes(i_material)))
+		uniforms.push_back(utils::UniformId::fromName(name));
+	return uniforms;
+}
+
+// the layer a sampler array reads is "<sampler>_layer", e.g. "texture_diffuse0_layer"
+std::vector<utils::UniformId> getLayerUniforms(const utils::MeshMaterial& i_material)
+{
+	const auto names = getSamplerNames(getMaterialTypes(i_material));
+
+	std::vector<utils::UniformId> uniforms;
+	for (size_t i = i_material.d_textures.size(); i < names.size(); ++i)
+		uniforms.push_back(utils::UniformId::fromName(names[i] + "_layer"));
+	return uniforms;
+}
+
+utils::ShaderFeatures getMaterialShaderFeatures(const utils::MeshMaterial& i_material)
+{
+	const auto types = getMaterialTypes(i_material);
+	const bool hasSpecularMap = std::find(types.begin(), types.end(), aiTextureType::aiTextureType_SPECULAR) != types.end();
+
+	utils::ShaderFeatures features = hasSpecularMap ? utils::SHADER_SPECULAR_MAP : 0;
+	if (!i_material.d_layers.empty())
+		features |= utils::SHADER_TEXTURE_ARRAY;
+	return features;
+}
+}
+
+utils::Mesh::Mesh(const utils::MeshView& i_mesh, utils::MeshMaterial i_material,
+				  utils::VertexFormat i_vertexFormat /* = utils::VertexFormat::Float */, bool i_keepCpuGeometry /* = true */)
+	: d_material(std::move(i_material))
+	, d_materialHash(hashMaterial(d_material))
+	, d_samplerUniforms(getSamplerUniforms(d_material))
+	, d_layerUniforms(getLayerUniforms(d_material))
+	, d_shaderFeatures(getMaterialShaderFeatures(d_material))
+	, d_lods(i_mesh.d_lods.begin(), i_mesh.d_lods.end())
+	, d_bounds(i_mesh.d_bounds)
+	, d_VAO(utils::VertexArrayHandle::create())
+	, d_VBO(utils::BufferHandle::create())
+	, d_EBO(utils::BufferHandle::create())
+{
+	if (d_lods.empty())
+		d_lods.push_back({ 0, static_cast<std::uint32_t>(i_mesh.d_indices.size()), 0.0f });
+
+	if (i_keepCpuGeometry)
+	{
+		d_vertices.assign(i_mesh.d_vertices.begin(), i_mesh.d_vertices.end());
+		d_indices.assign(i_mesh.d_indices.begin(), i_mesh.d_indices.end());
+	}
+
+	const GLenum indexType = utils::getIndexType(i_mesh.d_vertices.size());
+	prepareGeometry(i_mesh.d_vertices, i_mesh.d_indices, i_vertexFormat, indexType, d_positionTransform,
+		[&](std::span<const std::byte> i_vertexBytes, std::span<const std::byte> i_indexBytes)
+	{
+		auto& glState = utils::GLStateCache::getInstance();
+		glState.bindVertexArray(d_VAO.get());
+		glState.bindBuffer(GL_ARRAY_BUFFER, d_VBO.get());
+		glBufferData(GL_ARRAY_BUFFER, i_vertexBytes.size(), i_vertexBytes.data(), GL_STATIC_DRAW);
+
+		glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, d_EBO.get());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, i_indexBytes.size(), i_indexBytes.data(), GL_STATIC_DRAW);
+
+		utils::setVertexAttributes(i_vertexFormat);
+
+		d_geometryBytes = i_vertexBytes.size() + i_indexBytes.size();
+	});
+
+	d_geometry.d_VAO = d_VAO.get();
+	d_geometry.d_indicesCount = static_cast<GLsizei>(i_mesh.d_indices.size());
+	d_geometry.d_indexType = indexType;
+}
+
+utils::Mesh::Mesh(const utils::MeshView& i_mesh, utils::MeshMaterial i_material,
+				  utils::GeometryPool& io_geometryPool, bool i_keepCpuGeometry /* = true */)
+	: d_material(std::move(i_material))
+	, d_materialHash(hashMaterial(d_material))
+	, d_samplerUniforms(getSamplerUniforms(d_material))
+	, d_layerUniforms(getLayerUniforms(d_material))
+	, d_shaderFeatures(getMaterialShaderFeatures(d_material))
+	, d_lods(i_mesh.d_lods.begin(), i_mesh.d_lods.end())
+	, d_bounds(i_mesh.d_bounds)
+{
+	if (d_lods.empty())
+		d_lods.push_back({ 0, static_cast<std::uint32_t>(i_mesh.d_indices.size()), 0.0f });
+
+	if (i_keepCpuGeometry)
+	{
+		d_vertices.assign(i_mesh.d_vertices.begin(), i_mesh.d_vertices.end());
+		d_indices.assign(i_mesh.d_indices.begin(), i_mesh.d_indices.end());
 	}
 
-	glBindVertexArray(d_VAO);
-	glDrawElements(GL_TRIANGLES, d_indices.size(), GL_UNSIGNED_INT, nullptr);
-	glBindVertexArray(0);
+	const GLenum indexType = utils::getIndexType(i_mesh.d_vertices.size());
+	prepareGeometry(i_mesh.d_vertices, i_mesh.d_indices, io_geometryPool.getVertexFormat(), indexType, d_positionTransform,
+		[&](std::span<const std::byte> i_vertexBytes, std::span<const std::byte> i_indexBytes)
+	{
+		d_geometry = io_geometryPool.allocate(i_vertexBytes, i_indexBytes, indexType);
+		d_geometryBytes = i_vertexBytes.size() + i_indexBytes.size();
+	});
+}
 
-	glActiveTexture(GL_TEXTURE0);
+void utils::Mesh::Draw(const utils::ShadersManager& i_shaderManager, size_t i_lod /* = 0 */)
+{
+	bindMaterial(i_shaderManager);
+
+	utils::GLStateCache::getInstance().bindVertexArray(d_geometry.d_VAO);
+	drawElements(i_shaderManager, i_lod);
+}
+
+void utils::Mesh::DrawInstanced(const utils::ShadersManager& i_shaderManager, const utils::InstanceBuffer& i_instances, size_t i_lod /* = 0 */)
+{
+	if (i_instances.getInstancesCount() == 0)
+		return;
+
+	bindMaterial(i_shaderManager);
+	setPositionTransform(i_shaderManager);
+	setTextureLayers(i_shaderManager);
+
+	const auto& lod = d_lods[std::min(i_lod, d_lods.size() - 1)];
+	const size_t indexOffset = d_geometry.d_indexOffset + lod.d_indexOffset * utils::getIndexSize(d_geometry.d_indexType);
+
+	utils::GLStateCache::getInstance().bindVertexArray(d_geometry.d_VAO);
+	i_instances.enableAttributes();
+	glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(lod.d_indicesCount), d_geometry.d_indexType,
+									  reinterpret_cast<void*>(indexOffset), static_cast<GLsizei>(i_instances.getInstancesCount()), d_geometry.d_baseVertex);
+	utils::InstanceBuffer::disableAttributes();
+}
+
+void utils::Mesh::drawElements(const utils::ShadersManager& i_shaderManager, size_t i_lod) const
+{
+	setPositionTransform(i_shaderManager);
+	setTextureLayers(i_shaderManager);
+
+	const auto& lod = d_lods[std::min(i_lod, d_lods.size() - 1)];
+	const size_t indexOffset = d_geometry.d_indexOffset + lod.d_indexOffset * utils::getIndexSize(d_geometry.d_indexType);
+
+	glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(lod.d_indicesCount), d_geometry.d_indexType,
+							 reinterpret_cast<void*>(indexOffset), d_geometry.d_baseVertex);
+}
+
+void utils::Mesh::setPositionTransform(const utils::ShadersManager& i_shaderManager) const
+{
+	// setVec3 throws on missing uniforms, programs without the quantized positions (or that never read them) don't have these
+	if (i_shaderManager.getUniformLocation("positionOffset") != -1)
+		i_shaderManager.setVec3("positionOffset", d_positionTransform.d_offset);
+	if (i_shaderManager.getUniformLocation("positionScale") != -1)
+		i_shaderManager.setVec3("positionScale", d_positionTransform.d_scale);
+}
+
+void utils::Mesh::setTextureLayers(const utils::ShadersManager& i_shaderManager) const
+{
+	// meshes sharing the arrays keep the bindings, only the layers change between their draws
+	for (size_t i = 0; i < d_material.d_layers.size(); ++i)
+		i_shaderManager.setFloat(d_layerUniforms[i], static_cast<float>(d_material.d_layers[i].d_layer));
+}
+
+void utils::Mesh::bindMaterial(const utils::ShadersManager& i_shaderManager) const
+{
+	const auto& textures = d_material.d_textures;
+	for (size_t i = 0; i < textures.size(); ++i)
+	{
+		textures[i]->activate(GL_TEXTURE0 + static_cast<GLenum>(i));
+		i_shaderManager.setInt(d_samplerUniforms[i], static_cast<int>(i));
+	}
+	for (size_t i = 0; i < d_material.d_layers.size(); ++i)
+	{
+		const size_t unit = textures.size() + i;
+		d_material.d_layers[i].d_array->activate(GL_TEXTURE0 + static_cast<GLenum>(unit));
+		i_shaderManager.setInt(d_samplerUniforms[unit], static_cast<int>(unit));
+	}
+}
+
+size_t utils::Mesh::getLodsCount() const
+{
+	return d_lods.size();
+}
+
+const utils::LodRange& utils::Mesh::getLod(size_t i_lod) const
+{
+	return d_lods[i_lod];
+}
+
+const utils::Bounds& utils::Mesh::getBounds() const
+{
+	return d_bounds;
+}
+
+GLuint utils::Mesh::getVAO() const
+{
+	return d_geometry.d_VAO;
+}
+
+std::uint64_t utils::Mesh::getMaterialHash() const
+{
+	return d_materialHash;
+}
+
+utils::ShaderFeatures utils::Mesh::getShaderFeatures() const
+{
+	return d_shaderFeatures;
+}
+
+size_t utils::Mesh::getGeometryBytes() const
+{
+	return d_geometryBytes;
 }
 
-utils::Mesh::~Mesh()
+size_t utils::Mesh::getCpuGeometryBytes() const
 {
-	/*glDeleteVertexArrays(1, &d_VAO);
-	glDeleteBuffers(1, &d_EBO);
-	glDeleteBuffers(1, &d_VBO);*/
+	return d_vertices.size() * sizeof(utils::Vertex) + d_indices.size() * sizeof(unsigned int);
 }
@@ -0,0 +1,274 @@
+#include "MeshCache.hpp"
+
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+static constexpr std::string_view CACHE_DIR = "cache/meshes";
+static constexpr char CACHE_MAGIC[8] = { 'L', 'O', 'G', 'L', 'M', 'E', 'S', 'H' };
+static constexpr std::uint32_t CACHE_VERSION = 5; // 2: meshes are stored optimized, 3: LODs and bounds, 4: bounding boxes, 5: node hierarchy
+
+// File layout (all records are 4-byte aligned, so the mapped data can be used in place):
+//   CacheHeader
+//   TransformNode * nodeCount
+//   per mesh: MeshRecord, TextureRecord + path (padded) * textureCount, Bounds, LodRange * lodCount, vertices, indices
+struct CacheHeader
+{
+    char d_magic[8];
+    std::uint32_t d_version;
+    std::uint32_t d_importFlags;
+    std::uint64_t d_settingsHash;
+    std::int64_t d_sourceTime;
+    std::uint64_t d_sourcePathHash;
+    std::uint32_t d_vertexSize;
+    std::uint32_t d_meshCount;
+    std::uint32_t d_nodeCount;
+    std::uint32_t d_reserved;
+};
+
+struct MeshRecord
+{
+    std::uint32_t d_vertexCount;
+    std::uint32_t d_indexCount;
+    std::uint32_t d_textureCount;
+    std::uint32_t d_lodCount;
+    std::uint32_t d_node;
+};
+
+struct TextureRecord
+{
+    std::uint32_t d_type;
+    std::uint32_t d_pathLength;
+};
+
+std::size_t alignTo4(std::size_t i_size)
+{
+    return (i_size + 3) & ~std::size_t(3);
+}
+
+std::int64_t getSourceTime(const std::filesystem::path& i_sourcePath)
+{
+    std::error_code ec;
+    const auto time = std::filesystem::last_write_time(i_sourcePath, ec);
+    return ec ? 0 : static_cast<std::int64_t>(time.time_since_epoch().count());
+}
+
+class Reader
+{
+public:
+    Reader(const std::byte* i_data, std::size_t i_size) : d_data(i_data), d_size(i_size)
+    {
+    }
+
+    template <typename T>
+    const T* read(std::size_t i_count = 1)
+    {
+        const std::size_t bytes = sizeof(T) * i_count;
+        if (bytes > d_size - d_offset)
+            throw std::runtime_error("Truncated mesh cache");
+
+        const auto* result = reinterpret_cast<const T*>(d_data + d_offset);
+        d_offset += alignTo4(bytes);
+        d_offset = std::min(d_offset, d_size);
+        return result;
+    }
+
+    bool isAtEnd() const
+    {
+        return d_offset == d_size;
+    }
+
+private:
+    const std::byte* d_data;
+    std::size_t d_size;
+    std::size_t d_offset = 0;
+};
+
+template <typename T>
+void write(std::ostream& io_stream, const T* i_data, std::size_t i_count = 1)
+{
+    const std::size_t bytes = sizeof(T) * i_count;
+    io_stream.write(reinterpret_cast<const char*>(i_data), bytes);
+
+    static constexpr char padding[4] = {};
+    io_stream.write(padding, alignTo4(bytes) - bytes);
+}
+}
+
+utils::MeshCache::MeshCache(const std::filesystem::path& i_sourcePath, unsigned int i_importFlags, std::uint64_t i_settingsHash /* = 0 */)
+    : d_sourcePath(std::filesystem::weakly_canonical(i_sourcePath)), d_importFlags(i_importFlags), d_settingsHash(i_settingsHash),
+      d_sourceTime(getSourceTime(i_sourcePath))
+{
+    std::ostringstream fileName;
+    fileName << std::hex << std::setw(16) << std::setfill('0') << utils::fnv1a(d_sourcePath.generic_string()) << ".bin";
+    d_cachePath = std::filesystem::path(CACHE_DIR) / fileName.str();
+}
+
+bool utils::MeshCache::load()
+{
+    d_meshes.clear();
+    d_nodes = {};
+    d_file.reset();
+
+    std::error_code ec;
+    if (!std::filesystem::exists(d_cachePath, ec))
+        return false;
+
+    try
+    {
+        d_file.emplace(d_cachePath);
+        Reader reader(d_file->getData(), d_file->getSize());
+
+        const auto* header = reader.read<CacheHeader>();
+        if (std::memcmp(header->d_magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+            header->d_version != CACHE_VERSION ||
+            header->d_importFlags != d_importFlags ||
+            header->d_settingsHash != d_settingsHash ||
+            header->d_sourceTime != d_sourceTime ||
+            header->d_sourcePathHash != utils::fnv1a(d_sourcePath.generic_string()) ||
+            header->d_vertexSize != sizeof(utils::Vertex))
+        {
+            d_file.reset();
+            return false;
+        }
+
+        d_nodes = { reader.read<utils::TransformNode>(header->d_nodeCount), header->d_nodeCount };
+        for (std::uint32_t i = 0; i < header->d_nodeCount; ++i)
+        {
+            if (d_nodes[i].d_parent != utils::NO_PARENT_NODE && d_nodes[i].d_parent >= i)
+                throw std::runtime_error("Invalid node hierarchy");
+        }
+
+        d_meshes.reserve(header->d_meshCount);
+        for (std::uint32_t i = 0; i < header->d_meshCount; ++i)
+        {
+            const auto* record = reader.read<MeshRecord>();
+            auto& mesh = d_meshes.emplace_back();
+            if (record->d_node >= header->d_nodeCount)
+                throw std::runtime_error("Invalid mesh node");
+            mesh.d_node = record->d_node;
+
+            for (std::uint32_t j = 0; j < record->d_textureCount; ++j)
+            {
+                const auto* texture = reader.read<TextureRecord>();
+                const auto* path = reader.read<char>(texture->d_pathLength);
+                mesh.d_textures.push_back({ static_cast<aiTextureType>(texture->d_type), std::string(path, texture->d_pathLength) });
+            }
+
+            mesh.d_bounds = *reader.read<utils::Bounds>();
+            mesh.d_lods = { reader.read<utils::LodRange>(record->d_lodCount), record->d_lodCount };
+
+            mesh.d_vertices = { reader.read<utils::Vertex>(record->d_vertexCount), record->d_vertexCount };
+            mesh.d_indices = { reader.read<unsigned int>(record->d_indexCount), record->d_indexCount };
+        }
+
+        if (!reader.isAtEnd())
+            throw std::runtime_error("Trailing data in mesh cache");
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Ignoring mesh cache " << d_cachePath << ": " << e.what() << '\n';
+        d_meshes.clear();
+        d_nodes = {};
+        d_file.reset();
+        return false;
+    }
+
+    return true;
+}
+
+const std::vector<utils::MeshView>& utils::MeshCache::getMeshes() const
+{
+    return d_meshes;
+}
+
+std::span<const utils::TransformNode> utils::MeshCache::getNodes() const
+{
+    return d_nodes;
+}
+
+void utils::MeshCache::store(std::span<const utils::MeshData> i_meshes, std::span<const utils::TransformNode> i_nodes) const
+{
+    std::error_code ec;
+    std::filesystem::create_directories(d_cachePath.parent_path(), ec);
+    if (ec)
+    {
+        std::cout << "Failed to create mesh cache directory: " << ec.message() << '\n';
+        return;
+    }
+
+    // write to a temporary file first, so a crash never leaves a half-written cache behind;
+    // its name is unique, two loads of the same model may store it at the same time
+    const auto tmpPath = utils::getTemporaryPath(d_cachePath);
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            std::cout << "Failed to write mesh cache: " << tmpPath << '\n';
+            return;
+        }
+
+        CacheHeader header{};
+        std::memcpy(header.d_magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.d_version = CACHE_VERSION;
+        header.d_importFlags = d_importFlags;
+        header.d_settingsHash = d_settingsHash;
+        header.d_sourceTime = d_sourceTime;
+        header.d_sourcePathHash = utils::fnv1a(d_sourcePath.generic_string());
+        header.d_vertexSize = sizeof(utils::Vertex);
+        header.d_meshCount = static_cast<std::uint32_t>(i_meshes.size());
+        header.d_nodeCount = static_cast<std::uint32_t>(i_nodes.size());
+        write(file, &header);
+        write(file, i_nodes.data(), i_nodes.size());
+
+        for (const auto& mesh : i_meshes)
+        {
+            const MeshRecord record{ static_cast<std::uint32_t>(mesh.d_vertices.size()), static_cast<std::uint32_t>(mesh.d_indices.size()),
+                                     static_cast<std::uint32_t>(mesh.d_textures.size()), static_cast<std::uint32_t>(mesh.d_lods.size()), mesh.d_node };
+            write(file, &record);
+
+            for (const auto& texture : mesh.d_textures)
+            {
+                const TextureRecord textureRecord{ static_cast<std::uint32_t>(texture.d_type), static_cast<std::uint32_t>(texture.d_path.size()) };
+                write(file, &textureRecord);
+                write(file, texture.d_path.data(), texture.d_path.size());
+            }
+
+            write(file, &mesh.d_bounds);
+            write(file, mesh.d_lods.data(), mesh.d_lods.size());
+
+            write(file, mesh.d_vertices.data(), mesh.d_vertices.size());
+            write(file, mesh.d_indices.data(), mesh.d_indices.size());
+        }
+
+        if (!file)
+        {
+            std::cout << "Failed to write mesh cache: " << tmpPath << '\n';
+            return;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, d_cachePath, ec);
+    if (ec)
+        std::cout << "Failed to write mesh cache: " << ec.message() << '\n';
+}
+
+void utils::MeshCache::invalidate()
+{
+    d_meshes.clear();
+    d_nodes = {};
+    d_file.reset();
+
+    std::error_code ec;
+    std::filesystem::remove(d_cachePath, ec);
+}
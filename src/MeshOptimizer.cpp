@@ -0,0 +1,359 @@
+#include "MeshOptimizer.hpp"
+
+#include "Hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace
+{
+// Forsyth's scoring constants, see "Linear-Speed Vertex Cache Optimisation"
+static constexpr std::size_t LRU_CACHE_SIZE = 32;
+static constexpr float CACHE_DECAY_POWER = 1.5f;
+static constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+static constexpr float VALENCE_BOOST_SCALE = 2.0f;
+static constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+float vertexScore(int i_cachePosition, unsigned int i_remainingTriangles)
+{
+    if (i_remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (i_cachePosition >= 0)
+    {
+        // the vertices of the last triangle get a fixed score, so the next one doesn't just reuse them in a strip
+        if (i_cachePosition < 3)
+            score = LAST_TRIANGLE_SCORE;
+        else
+        {
+            const float scaler = 1.0f / static_cast<float>(LRU_CACHE_SIZE - 3);
+            score = std::pow(1.0f - static_cast<float>(i_cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+
+    // bonus for vertices with few triangles left, to finish them off and avoid leaving lone triangles behind
+    score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i_remainingTriangles), -VALENCE_BOOST_POWER);
+    return score;
+}
+
+struct VertexHash
+{
+    std::size_t operator()(const utils::Vertex& i_vertex) const
+    {
+        return static_cast<std::size_t>(utils::fnv1a(&i_vertex, sizeof(utils::Vertex)));
+    }
+};
+
+struct VertexEqual
+{
+    bool operator()(const utils::Vertex& i_lhs, const utils::Vertex& i_rhs) const
+    {
+        return std::memcmp(&i_lhs, &i_rhs, sizeof(utils::Vertex)) == 0;
+    }
+};
+
+glm::vec3 triangleNormal(const glm::vec3& i_a, const glm::vec3& i_b, const glm::vec3& i_c)
+{
+    // not normalized, its length is twice the triangle area which weights the cluster normal
+    return glm::cross(i_b - i_a, i_c - i_a);
+}
+}
+
+float utils::VertexCacheStats::getAcmr() const
+{
+    return d_trianglesCount ? static_cast<float>(d_transformedCount) / static_cast<float>(d_trianglesCount) : 0.0f;
+}
+
+float utils::VertexCacheStats::getAtvr() const
+{
+    return d_verticesCount ? static_cast<float>(d_transformedCount) / static_cast<float>(d_verticesCount) : 0.0f;
+}
+
+utils::VertexCacheStats& utils::VertexCacheStats::operator+=(const VertexCacheStats& i_other)
+{
+    d_transformedCount += i_other.d_transformedCount;
+    d_trianglesCount += i_other.d_trianglesCount;
+    d_verticesCount += i_other.d_verticesCount;
+    return *this;
+}
+
+utils::VertexCacheStats utils::analyzeVertexCache(std::span<const unsigned int> i_indices, std::size_t i_verticesCount, std::size_t i_cacheSize /* = 16 */)
+{
+    VertexCacheStats stats;
+    stats.d_trianglesCount = i_indices.size() / 3;
+    stats.d_verticesCount = i_verticesCount;
+
+    // a vertex is in the FIFO if it was pushed less than i_cacheSize misses ago
+    std::vector<std::size_t> insertTime(i_verticesCount, 0);
+    std::size_t time = i_cacheSize + 1;
+    for (const auto index : i_indices)
+    {
+        if (time - insertTime[index] > i_cacheSize)
+        {
+            insertTime[index] = time++;
+            ++stats.d_transformedCount;
+        }
+    }
+
+    return stats;
+}
+
+void utils::weldVertices(utils::MeshData& io_mesh)
+{
+    std::unordered_map<utils::Vertex, unsigned int, VertexHash, VertexEqual> uniqueVertices;
+    uniqueVertices.reserve(io_mesh.d_vertices.size());
+
+    std::vector<utils::Vertex> vertices;
+    std::vector<unsigned int> remap(io_mesh.d_vertices.size());
+    for (std::size_t i = 0; i < io_mesh.d_vertices.size(); ++i)
+    {
+        const auto [it, isInserted] = uniqueVertices.try_emplace(io_mesh.d_vertices[i], static_cast<unsigned int>(vertices.size()));
+        if (isInserted)
+            vertices.push_back(io_mesh.d_vertices[i]);
+        remap[i] = it->second;
+    }
+
+    for (auto& index : io_mesh.d_indices)
+        index = remap[index];
+    io_mesh.d_vertices = std::move(vertices);
+}
+
+std::vector<unsigned int> utils::optimizeVertexCache(std::span<const unsigned int> i_indices, std::size_t i_verticesCount)
+{
+    const std::size_t trianglesCount = i_indices.size() / 3;
+    std::vector<unsigned int> result;
+    result.reserve(trianglesCount * 3);
+    if (trianglesCount == 0)
+        return result;
+
+    // per vertex list of triangles using it, the live ones are kept at the front of every list
+    std::vector<unsigned int> remainingTriangles(i_verticesCount, 0);
+    for (std::size_t i = 0; i < trianglesCount * 3; ++i)
+        ++remainingTriangles[i_indices[i]];
+
+    std::vector<unsigned int> adjacencyOffsets(i_verticesCount + 1, 0);
+    std::inclusive_scan(remainingTriangles.begin(), remainingTriangles.end(), adjacencyOffsets.begin() + 1);
+
+    std::vector<unsigned int> adjacency(trianglesCount * 3);
+    std::vector<unsigned int> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (std::size_t i = 0; i < trianglesCount * 3; ++i)
+        adjacency[fillOffsets[i_indices[i]]++] = static_cast<unsigned int>(i / 3);
+
+    std::vector<int> cachePositions(i_verticesCount, -1);
+    std::vector<float> vertexScores(i_verticesCount);
+    for (std::size_t i = 0; i < i_verticesCount; ++i)
+        vertexScores[i] = vertexScore(-1, remainingTriangles[i]);
+
+    std::vector<float> triangleScores(trianglesCount);
+    std::vector<bool> isEmitted(trianglesCount, false);
+    for (std::size_t i = 0; i < trianglesCount; ++i)
+        triangleScores[i] = vertexScores[i_indices[i * 3]] + vertexScores[i_indices[i * 3 + 1]] + vertexScores[i_indices[i * 3 + 2]];
+
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> newCache;
+    cache.reserve(LRU_CACHE_SIZE + 3);
+    newCache.reserve(LRU_CACHE_SIZE + 3);
+
+    std::size_t bestTriangle = static_cast<std::size_t>(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+    std::size_t scanCursor = 0;
+    while (true)
+    {
+        const unsigned int* triangle = &i_indices[bestTriangle * 3];
+        result.insert(result.end(), triangle, triangle + 3);
+        isEmitted[bestTriangle] = true;
+
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            const auto vertex = triangle[i];
+            auto* first = &adjacency[adjacencyOffsets[vertex]];
+            auto* last = first + remainingTriangles[vertex];
+            auto* it = std::find(first, last, static_cast<unsigned int>(bestTriangle));
+            if (it != last)
+            {
+                std::swap(*it, *(last - 1));
+                --remainingTriangles[vertex];
+            }
+        }
+
+        // the emitted triangle moves to the front of the LRU cache
+        newCache.clear();
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            if (std::find(newCache.begin(), newCache.end(), triangle[i]) == newCache.end())
+                newCache.push_back(triangle[i]);
+        }
+        for (const auto vertex : cache)
+        {
+            if (std::find(triangle, triangle + 3, vertex) == triangle + 3)
+                newCache.push_back(vertex);
+        }
+
+        for (std::size_t i = 0; i < newCache.size(); ++i)
+        {
+            const auto vertex = newCache[i];
+            cachePositions[vertex] = i < LRU_CACHE_SIZE ? static_cast<int>(i) : -1;
+            vertexScores[vertex] = vertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+        }
+
+        // only triangles around the touched vertices changed score, the best next one is among them
+        float bestScore = -1.0f;
+        bool isFound = false;
+        for (const auto vertex : newCache)
+        {
+            const auto* first = &adjacency[adjacencyOffsets[vertex]];
+            for (const auto* it = first; it != first + remainingTriangles[vertex]; ++it)
+            {
+                const auto* candidate = &i_indices[*it * 3];
+                const float score = vertexScores[candidate[0]] + vertexScores[candidate[1]] + vertexScores[candidate[2]];
+                triangleScores[*it] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestTriangle = *it;
+                    isFound = true;
+                }
+            }
+        }
+
+        newCache.resize(std::min(newCache.size(), LRU_CACHE_SIZE));
+        std::swap(cache, newCache);
+
+        if (!isFound)
+        {
+            // nothing left around the cache, continue with the next unprocessed triangle
+            while (scanCursor < trianglesCount && isEmitted[scanCursor])
+                ++scanCursor;
+            if (scanCursor == trianglesCount)
+                break;
+            bestTriangle = scanCursor;
+        }
+    }
+
+    return result;
+}
+
+std::vector<unsigned int> utils::optimizeOverdraw(std::span<const unsigned int> i_indices, std::span<const utils::Vertex> i_vertices, float i_threshold /* = 1.05f */)
+{
+    const std::size_t trianglesCount = i_indices.size() / 3;
+    std::vector<unsigned int> result(i_indices.begin(), i_indices.end());
+    if (trianglesCount < 2)
+        return result;
+
+    // split the cache-optimized sequence where the cache is cold again (all three vertices miss),
+    // reordering whole clusters keeps most of the cache locality inside them
+    static constexpr std::size_t CACHE_SIZE = 16;
+    std::vector<std::size_t> clusterStarts;
+    {
+        std::vector<std::size_t> insertTime(i_vertices.size(), 0);
+        std::size_t time = CACHE_SIZE + 1;
+        for (std::size_t i = 0; i < trianglesCount; ++i)
+        {
+            std::size_t misses = 0;
+            for (std::size_t j = 0; j < 3; ++j)
+            {
+                const auto index = i_indices[i * 3 + j];
+                if (time - insertTime[index] > CACHE_SIZE)
+                {
+                    insertTime[index] = time++;
+                    ++misses;
+                }
+            }
+
+            if (i == 0 || misses == 3)
+                clusterStarts.push_back(i);
+        }
+    }
+    clusterStarts.push_back(trianglesCount);
+
+    const std::size_t clustersCount = clusterStarts.size() - 1;
+    if (clustersCount < 2)
+        return result;
+
+    glm::vec3 meshCentroid(0.0f);
+    for (const auto& vertex : i_vertices)
+        meshCentroid += vertex.d_position;
+    meshCentroid /= static_cast<float>(std::max<std::size_t>(i_vertices.size(), 1));
+
+    // clusters facing away from the mesh center are likely to occlude the rest, so they go first
+    std::vector<float> sortKeys(clustersCount);
+    for (std::size_t cluster = 0; cluster < clustersCount; ++cluster)
+    {
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+        for (std::size_t i = clusterStarts[cluster]; i < clusterStarts[cluster + 1]; ++i)
+        {
+            const auto& a = i_vertices[i_indices[i * 3]].d_position;
+            const auto& b = i_vertices[i_indices[i * 3 + 1]].d_position;
+            const auto& c = i_vertices[i_indices[i * 3 + 2]].d_position;
+
+            const auto faceNormal = triangleNormal(a, b, c);
+            const float faceArea = glm::length(faceNormal);
+            centroid += (a + b + c) * (faceArea / 3.0f);
+            normal += faceNormal;
+            area += faceArea;
+        }
+
+        const float normalLength = glm::length(normal);
+        if (area > 0.0f && normalLength > 0.0f)
+            sortKeys[cluster] = glm::dot(centroid / area - meshCentroid, normal / normalLength);
+        else
+            sortKeys[cluster] = 0.0f;
+    }
+
+    std::vector<std::size_t> clusterOrder(clustersCount);
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](std::size_t i_lhs, std::size_t i_rhs) {
+        return sortKeys[i_lhs] > sortKeys[i_rhs];
+    });
+
+    result.clear();
+    for (const auto cluster : clusterOrder)
+        result.insert(result.end(), i_indices.begin() + clusterStarts[cluster] * 3, i_indices.begin() + clusterStarts[cluster + 1] * 3);
+
+    const float acmrBefore = utils::analyzeVertexCache(i_indices, i_vertices.size()).getAcmr();
+    const float acmrAfter = utils::analyzeVertexCache(result, i_vertices.size()).getAcmr();
+    if (acmrAfter > acmrBefore * i_threshold)
+        result.assign(i_indices.begin(), i_indices.end());
+
+    return result;
+}
+
+void utils::optimizeVertexFetch(utils::MeshData& io_mesh)
+{
+    static constexpr unsigned int UNUSED = ~0u;
+
+    std::vector<unsigned int> remap(io_mesh.d_vertices.size(), UNUSED);
+    std::vector<utils::Vertex> vertices;
+    vertices.reserve(io_mesh.d_vertices.size());
+
+    for (auto& index : io_mesh.d_indices)
+    {
+        if (remap[index] == UNUSED)
+        {
+            remap[index] = static_cast<unsigned int>(vertices.size());
+            vertices.push_back(io_mesh.d_vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    io_mesh.d_vertices = std::move(vertices);
+}
+
+utils::MeshOptimizationStats utils::optimizeMesh(utils::MeshData& io_mesh)
+{
+    MeshOptimizationStats stats;
+    stats.d_before = utils::analyzeVertexCache(io_mesh.d_indices, io_mesh.d_vertices.size());
+
+    utils::weldVertices(io_mesh);
+    io_mesh.d_indices = utils::optimizeVertexCache(io_mesh.d_indices, io_mesh.d_vertices.size());
+    io_mesh.d_indices = utils::optimizeOverdraw(io_mesh.d_indices, io_mesh.d_vertices);
+    utils::optimizeVertexFetch(io_mesh);
+
+    stats.d_after = utils::analyzeVertexCache(io_mesh.d_indices, io_mesh.d_vertices.size());
+    return stats;
+}
@@ -0,0 +1,308 @@
+#include "MeshSimplifier.hpp"
+
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace
+{
+// symmetric 4x4 matrix of the sum of squared distances to a set of planes
+struct Quadric
+{
+    double d_a2 = 0, d_ab = 0, d_ac = 0, d_ad = 0;
+    double d_b2 = 0, d_bc = 0, d_bd = 0;
+    double d_c2 = 0, d_cd = 0;
+    double d_d2 = 0;
+
+    static Quadric fromPlane(double i_a, double i_b, double i_c, double i_d)
+    {
+        Quadric q;
+        q.d_a2 = i_a * i_a; q.d_ab = i_a * i_b; q.d_ac = i_a * i_c; q.d_ad = i_a * i_d;
+        q.d_b2 = i_b * i_b; q.d_bc = i_b * i_c; q.d_bd = i_b * i_d;
+        q.d_c2 = i_c * i_c; q.d_cd = i_c * i_d;
+        q.d_d2 = i_d * i_d;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& i_other)
+    {
+        d_a2 += i_other.d_a2; d_ab += i_other.d_ab; d_ac += i_other.d_ac; d_ad += i_other.d_ad;
+        d_b2 += i_other.d_b2; d_bc += i_other.d_bc; d_bd += i_other.d_bd;
+        d_c2 += i_other.d_c2; d_cd += i_other.d_cd;
+        d_d2 += i_other.d_d2;
+        return *this;
+    }
+
+    double evaluate(const glm::vec3& i_point) const
+    {
+        const double x = i_point.x;
+        const double y = i_point.y;
+        const double z = i_point.z;
+        const double error = d_a2 * x * x + 2 * d_ab * x * y + 2 * d_ac * x * z + 2 * d_ad * x
+                           + d_b2 * y * y + 2 * d_bc * y * z + 2 * d_bd * y
+                           + d_c2 * z * z + 2 * d_cd * z
+                           + d_d2;
+        return std::max(error, 0.0);
+    }
+};
+
+struct Collapse
+{
+    unsigned int d_from;
+    unsigned int d_to;
+    double d_cost;
+};
+
+glm::vec3 faceNormal(const glm::vec3& i_a, const glm::vec3& i_b, const glm::vec3& i_c)
+{
+    return glm::cross(i_b - i_a, i_c - i_a);
+}
+
+float computeExtent(std::span<const utils::Vertex> i_vertices)
+{
+    glm::vec3 minPos(std::numeric_limits<float>::max());
+    glm::vec3 maxPos(std::numeric_limits<float>::lowest());
+    for (const auto& vertex : i_vertices)
+    {
+        minPos = glm::min(minPos, vertex.d_position);
+        maxPos = glm::max(maxPos, vertex.d_position);
+    }
+
+    const auto size = maxPos - minPos;
+    return i_vertices.empty() ? 0.0f : std::max({ size.x, size.y, size.z });
+}
+
+// vertex to triangles adjacency in CSR form
+struct Adjacency
+{
+    std::vector<unsigned int> d_offsets;
+    std::vector<unsigned int> d_triangles;
+
+    Adjacency(std::span<const unsigned int> i_indices, std::size_t i_verticesCount) : d_offsets(i_verticesCount + 1, 0), d_triangles(i_indices.size())
+    {
+        for (const auto index : i_indices)
+            ++d_offsets[index + 1];
+        std::partial_sum(d_offsets.begin(), d_offsets.end(), d_offsets.begin());
+
+        std::vector<unsigned int> cursor(d_offsets.begin(), d_offsets.end() - 1);
+        for (std::size_t i = 0; i < i_indices.size(); ++i)
+            d_triangles[cursor[i_indices[i]]++] = static_cast<unsigned int>(i / 3);
+    }
+
+    std::span<const unsigned int> getTriangles(unsigned int i_vertex) const
+    {
+        return { d_triangles.data() + d_offsets[i_vertex], d_triangles.data() + d_offsets[i_vertex + 1] };
+    }
+};
+
+// a collapse must not turn any remaining triangle around i_from upside down
+bool isFlipping(const Collapse& i_collapse, std::span<const utils::Vertex> i_vertices, std::span<const unsigned int> i_indices, const Adjacency& i_adjacency)
+{
+    const auto& target = i_vertices[i_collapse.d_to].d_position;
+    for (const auto triangle : i_adjacency.getTriangles(i_collapse.d_from))
+    {
+        std::array<unsigned int, 3> corners = { i_indices[triangle * 3], i_indices[triangle * 3 + 1], i_indices[triangle * 3 + 2] };
+        if (std::find(corners.begin(), corners.end(), i_collapse.d_to) != corners.end())
+            continue; // collapses into a degenerate triangle and goes away
+
+        std::array<glm::vec3, 3> positions;
+        for (std::size_t i = 0; i < 3; ++i)
+            positions[i] = i_vertices[corners[i]].d_position;
+        const auto before = faceNormal(positions[0], positions[1], positions[2]);
+
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            if (corners[i] == i_collapse.d_from)
+                positions[i] = target;
+        }
+        const auto after = faceNormal(positions[0], positions[1], positions[2]);
+
+        if (glm::dot(before, after) <= 0.0f)
+            return true;
+    }
+    return false;
+}
+}
+
+std::vector<unsigned int> utils::simplifyMesh(std::span<const utils::Vertex> i_vertices, std::span<const unsigned int> i_indices,
+                                              std::size_t i_targetIndicesCount, float i_targetError, float* o_resultError /* = nullptr */)
+{
+    std::vector<unsigned int> indices(i_indices.begin(), i_indices.begin() + i_indices.size() / 3 * 3);
+    const std::size_t verticesCount = i_vertices.size();
+
+    const double extent = computeExtent(i_vertices);
+    const double maxCost = std::pow(static_cast<double>(i_targetError) * extent, 2.0);
+    double resultCost = 0.0;
+
+    // every vertex starts with the planes of its triangles
+    std::vector<Quadric> quadrics(verticesCount);
+    for (std::size_t i = 0; i < indices.size(); i += 3)
+    {
+        const auto& a = i_vertices[indices[i]].d_position;
+        const auto normal = faceNormal(a, i_vertices[indices[i + 1]].d_position, i_vertices[indices[i + 2]].d_position);
+        const float length = glm::length(normal);
+        if (length == 0.0f)
+            continue;
+
+        const auto n = normal / length;
+        const auto plane = Quadric::fromPlane(n.x, n.y, n.z, -glm::dot(n, a));
+        for (std::size_t j = 0; j < 3; ++j)
+            quadrics[indices[i + j]] += plane;
+    }
+
+    // vertices on edges used by a single triangle are open borders or attribute seams, moving them would tear the mesh
+    std::vector<bool> isLocked(verticesCount, false);
+    {
+        std::vector<std::pair<unsigned int, unsigned int>> edges;
+        edges.reserve(indices.size());
+        for (std::size_t i = 0; i < indices.size(); i += 3)
+        {
+            for (std::size_t j = 0; j < 3; ++j)
+            {
+                const auto a = indices[i + j];
+                const auto b = indices[i + (j + 1) % 3];
+                edges.emplace_back(std::min(a, b), std::max(a, b));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        for (std::size_t i = 0; i < edges.size();)
+        {
+            std::size_t j = i;
+            while (j < edges.size() && edges[j] == edges[i])
+                ++j;
+            if (j - i == 1)
+            {
+                isLocked[edges[i].first] = true;
+                isLocked[edges[i].second] = true;
+            }
+            i = j;
+        }
+    }
+
+    std::vector<unsigned int> remap(verticesCount);
+    std::vector<bool> isTouched(verticesCount);
+    std::vector<Collapse> collapses;
+
+    while (indices.size() > i_targetIndicesCount)
+    {
+        const Adjacency adjacency(indices, verticesCount);
+
+        collapses.clear();
+        for (std::size_t i = 0; i < indices.size(); i += 3)
+        {
+            for (std::size_t j = 0; j < 3; ++j)
+            {
+                const auto a = indices[i + j];
+                const auto b = indices[i + (j + 1) % 3];
+                if (a > b || a == b)
+                    continue; // every edge once, interior edges are seen from both triangles anyway
+
+                Quadric quadric = quadrics[a];
+                quadric += quadrics[b];
+
+                const double costToB = isLocked[a] ? std::numeric_limits<double>::max() : quadric.evaluate(i_vertices[b].d_position);
+                const double costToA = isLocked[b] ? std::numeric_limits<double>::max() : quadric.evaluate(i_vertices[a].d_position);
+                if (isLocked[a] && isLocked[b])
+                    continue;
+
+                if (costToB <= costToA)
+                    collapses.push_back({ a, b, costToB });
+                else
+                    collapses.push_back({ b, a, costToA });
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& i_lhs, const Collapse& i_rhs) { return i_lhs.d_cost < i_rhs.d_cost; });
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(isTouched.begin(), isTouched.end(), false);
+
+        // collapses in one pass must not overlap, their one-rings are locked for the rest of the pass
+        const std::size_t trianglesToRemove = (indices.size() - i_targetIndicesCount) / 3;
+        std::size_t removedTriangles = 0;
+        std::size_t appliedCollapses = 0;
+        for (const auto& collapse : collapses)
+        {
+            if (collapse.d_cost > maxCost || removedTriangles >= trianglesToRemove)
+                break;
+            if (isTouched[collapse.d_from] || isTouched[collapse.d_to])
+                continue;
+            if (isFlipping(collapse, i_vertices, indices, adjacency))
+                continue;
+
+            for (const auto triangle : adjacency.getTriangles(collapse.d_from))
+            {
+                bool hasTarget = false;
+                for (std::size_t i = 0; i < 3; ++i)
+                {
+                    const auto vertex = indices[triangle * 3 + i];
+                    isTouched[vertex] = true;
+                    hasTarget = hasTarget || vertex == collapse.d_to;
+                }
+                removedTriangles += hasTarget ? 1 : 0;
+            }
+
+            remap[collapse.d_from] = collapse.d_to;
+            quadrics[collapse.d_to] += quadrics[collapse.d_from];
+            resultCost = std::max(resultCost, collapse.d_cost);
+            ++appliedCollapses;
+        }
+
+        if (appliedCollapses == 0)
+            break;
+
+        std::size_t writeIndex = 0;
+        for (std::size_t i = 0; i < indices.size(); i += 3)
+        {
+            const auto a = remap[indices[i]];
+            const auto b = remap[indices[i + 1]];
+            const auto c = remap[indices[i + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+
+            indices[writeIndex++] = a;
+            indices[writeIndex++] = b;
+            indices[writeIndex++] = c;
+        }
+        indices.resize(writeIndex);
+    }
+
+    if (o_resultError)
+        *o_resultError = static_cast<float>(std::sqrt(resultCost));
+
+    return indices;
+}
+
+void utils::generateLods(utils::MeshData& io_mesh, std::size_t i_lodsCount, float i_reduction /* = 0.5f */, float i_maxError /* = 0.05f */)
+{
+    const auto lod0IndicesCount = static_cast<unsigned int>(io_mesh.d_indices.size());
+    io_mesh.d_lods = { { 0, lod0IndicesCount, 0.0f } };
+
+    std::vector<unsigned int> previousLod = io_mesh.d_indices;
+    float previousError = 0.0f;
+    for (std::size_t lod = 1; lod < i_lodsCount; ++lod)
+    {
+        const auto targetIndicesCount = static_cast<std::size_t>(previousLod.size() * i_reduction) / 3 * 3;
+
+        float error = 0.0f;
+        auto lodIndices = utils::simplifyMesh(io_mesh.d_vertices, previousLod, targetIndicesCount, i_maxError, &error);
+
+        // not worth a LOD level when the simplifier got stuck on borders or the error limit
+        if (lodIndices.empty() || lodIndices.size() > previousLod.size() * 9 / 10)
+            break;
+
+        lodIndices = utils::optimizeVertexCache(lodIndices, io_mesh.d_vertices.size());
+
+        // errors of chained LODs add up
+        previousError += error;
+        io_mesh.d_lods.push_back({ static_cast<unsigned int>(io_mesh.d_indices.size()), static_cast<unsigned int>(lodIndices.size()), previousError });
+        io_mesh.d_indices.insert(io_mesh.d_indices.end(), lodIndices.begin(), lodIndices.end());
+        previousLod = std::move(lodIndices);
+    }
+}
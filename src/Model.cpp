@@ -1,38 +1,635 @@
 #include "Model.hpp"
 
+#include "AssetRegistry.hpp"
+#include "CameraManager.hpp"
+#include "Frustum.hpp"
+#include "GeometryPool.hpp"
+#include "GLStateCache.hpp"
+#include "Hash.hpp"
+#include "InstanceBuffer.hpp"
 #include "Mesh.hpp"
+#include "MeshCache.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "RenderQueue.hpp"
 #include "Texture.hpp"
+#include "TextureArray.hpp"
+#include "TextureResidency.hpp"
+#include "TextureStreamer.hpp"
 #include "ShadersManager.hpp"
+#include "ThreadPool.hpp"
+#include "UploadQueue.hpp"
 
+#include <glad/glad.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <string_view>
 #include <exception>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <unordered_set>
 #include <vector>
 
-utils::Model::Model(std::string_view i_path) : d_directory(std::filesystem::path(i_path).parent_path())
+namespace
 {
-	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(i_path.data(), aiProcess_Triangulate | aiProcess_FlipUVs);
-	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+static constexpr unsigned int IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs;
+
+double millisecondsSince(std::chrono::steady_clock::time_point i_start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - i_start).count();
+}
+
+// a world space length at distance 1 covers this many pixels
+float getPixelsPerUnit(const utils::Camera& i_camera)
+{
+	return i_camera.getViewportHeight() * 0.5f / std::tan(glm::radians(i_camera.getFov()) * 0.5f);
+}
+
+// the cached meshes depend on the LOD settings as well
+std::uint64_t hashLodSettings(const utils::ModelOptions& i_options)
+{
+	const auto lodsCount = static_cast<std::uint64_t>(i_options.d_lodsCount);
+	auto hash = utils::fnv1a(&lodsCount, sizeof(lodsCount));
+	hash = utils::fnv1a(&i_options.d_lodReduction, sizeof(i_options.d_lodReduction), hash);
+	return utils::fnv1a(&i_options.d_lodMaxError, sizeof(i_options.d_lodMaxError), hash);
+}
+
+// geometry and material, the node is left out so repeated parts share one mesh
+std::uint64_t hashMesh(const utils::MeshView& i_mesh)
+{
+	auto hash = utils::fnv1a(i_mesh.d_vertices.data(), i_mesh.d_vertices.size_bytes());
+	hash = utils::fnv1a(i_mesh.d_indices.data(), i_mesh.d_indices.size_bytes(), hash);
+	hash = utils::fnv1a(i_mesh.d_lods.data(), i_mesh.d_lods.size_bytes(), hash);
+	for (const auto& texture : i_mesh.d_textures)
+	{
+		hash = utils::fnv1a(&texture.d_type, sizeof(texture.d_type), hash);
+		hash = utils::fnv1a(utils::AssetRegistry::normalizePath(texture.d_path), hash);
+	}
+	return hash;
+}
+
+// a texture used by the imported meshes, without an image if the registry already had it when decoding
+struct ImportedTexture
+{
+	aiTextureType d_type = aiTextureType_NONE;
+	std::uint64_t d_contentHash = 0; // 0 if it was found by path
+	std::optional<utils::TextureImage> d_image;
+};
+
+// textures shared with other models are tracked by each model's residency manager, the first one keeps it
+std::shared_ptr<utils::Texture> trackResidency(const utils::ModelOptions& i_options, const std::string& i_path, std::shared_ptr<utils::Texture> i_texture)
+{
+	if (i_options.d_textureResidency)
+		i_options.d_textureResidency->track(i_texture, i_path, i_options.d_compressTextures);
+	return i_texture;
+}
+
+// the registered texture with the same path or content, otherwise one created from the image and registered;
+// compressed images are streamed if the options have a streamer, the image is moved out of io_texture then.
+// Without an image the file is decoded here, the texture it was skipped for has been freed in the meantime
+std::shared_ptr<utils::Texture> acquireTexture(const utils::ModelOptions& i_options, const std::string& i_path, ImportedTexture& io_texture)
+{
+	auto& registry = utils::AssetRegistry::getInstance();
+	if (auto texture = registry.findTexture(i_path, i_options.d_compressTextures, io_texture.d_contentHash))
+		return trackResidency(i_options, i_path, std::move(texture));
+
+	if (!io_texture.d_image)
+	{
+		if (!io_texture.d_contentHash)
+		{
+			io_texture.d_contentHash = utils::AssetRegistry::hashFile(i_path);
+			if (auto texture = registry.findTexture(i_path, i_options.d_compressTextures, io_texture.d_contentHash))
+				return trackResidency(i_options, i_path, std::move(texture));
+		}
+		io_texture.d_image = utils::loadTextureImage(i_path, i_options.d_compressTextures);
+	}
+
+	std::shared_ptr<utils::Texture> texture;
+	auto* compressed = std::get_if<utils::CompressedImage>(&*io_texture.d_image);
+	if (i_options.d_textureStreamer && compressed)
+		texture = i_options.d_textureStreamer->create(std::make_shared<const utils::CompressedImage>(std::move(*compressed)), io_texture.d_type);
+	else
+		texture = std::make_shared<utils::Texture>(*io_texture.d_image, io_texture.d_type);
+	io_texture.d_image.reset();
+
+	return trackResidency(i_options, i_path, registry.addTexture(i_path, i_options.d_compressTextures, io_texture.d_contentHash, std::move(texture)));
+}
+}
+
+struct utils::Model::ImportedScene
+{
+	std::optional<utils::MeshCache> d_cache;
+	bool d_isCacheHit = false;
+	std::vector<utils::MeshData> d_meshesData;
+	std::vector<utils::MeshView> d_meshes;
+	std::vector<utils::TransformNode> d_nodesData;
+	std::span<const utils::TransformNode> d_nodes;
+	std::vector<std::uint64_t> d_meshHashes; // see hashMesh()
+	std::unordered_map<std::string, ImportedTexture> d_textures;
+};
+
+utils::Model::Model(std::string_view i_path, const utils::ModelOptions& i_options /* = {} */)
+	: d_options(i_options), d_directory(std::filesystem::path(i_path).parent_path())
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	const auto scene = importScene(i_path);
+	// the decoded textures first, the ones skipped as duplicates of them find them registered
+	if (d_options.d_packTextures)
+		packTextures(i_path, *scene);
+	for (const bool isDecoded : { true, false })
 	{
-		throw std::runtime_error("ERROR::Assimp: " + std::string(importer.GetErrorString()));
+		for (auto& [texturePath, texture] : scene->d_textures)
+		{
+			if (!d_options.d_packTextures && texture.d_image.has_value() == isDecoded && !d_loadedTextures.contains(texturePath))
+				d_loadedTextures.try_emplace(texturePath, acquireTexture(d_options, texturePath, texture));
+		}
 	}
 
-	processNode(*scene->mRootNode, *scene);
+	d_transforms = utils::TransformGraph(scene->d_nodes);
+	for (size_t i = 0; i < scene->d_meshes.size(); ++i)
+	{
+		d_meshes.push_back(createMesh(scene->d_meshes[i], scene->d_meshHashes[i]));
+		d_meshNodes.push_back(scene->d_meshes[i].d_node);
+	}
+	d_isMeshCacheHit = scene->d_isCacheHit;
+	d_isResident = true;
+
+	std::cout << "Model " << i_path << ": " << d_meshes.size() << " meshes loaded in " << millisecondsSince(startTime) << " ms (mesh cache "
+			  << (d_isMeshCacheHit ? "hit" : "miss") << "), " << getGeometryBytes() / 1024 << " KB of geometry, " << getCpuGeometryBytes() / 1024
+			  << " KB kept in RAM\n";
+}
+
+utils::Model::Model(const std::filesystem::path& i_directory, const utils::ModelOptions& i_options)
+	: d_options(i_options), d_directory(i_directory)
+{
 }
 
-void utils::Model::Draw(const utils::ShadersManager& i_shaders)
+utils::Model::~Model()
 {
-	for (auto& mesh : d_meshes)
-		mesh.Draw(i_shaders);
+	// the background import uses this model and the upload queue, both have to outlive it
+	d_isCancelled = true;
+	if (d_loadingTask.valid())
+		d_loadingTask.wait();
 }
 
-void utils::Model::processNode(aiNode& i_node, const aiScene& i_scene)
+std::shared_ptr<utils::Model> utils::Model::loadAsync(std::string_view i_path, utils::UploadQueue& io_uploadQueue, const utils::ModelOptions& i_options /* = {} */)
 {
+	std::shared_ptr<Model> model(new Model(std::filesystem::path(i_path).parent_path(), i_options));
+
+	// the queued uploads only hold weak references, dropping the handle cancels them;
+	// the background task itself can use the raw pointer as the destructor waits for it
+	std::weak_ptr<Model> weakModel = model;
+	Model* loadingModel = model.get();
+	model->d_loadingTask = utils::ThreadPool::getInstance().submit([weakModel, loadingModel, path = std::string(i_path), &io_uploadQueue]()
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+
+		std::shared_ptr<ImportedScene> scene;
+		try
+		{
+			scene = loadingModel->importScene(path);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "Failed to load model " << path << ": " << e.what() << '\n';
+			return;
+		}
+
+		if (loadingModel->d_isCancelled)
+			return;
+
+		loadingModel->d_isMeshCacheHit = scene->d_isCacheHit;
+		std::cout << "Model " << path << ": imported in background in " << millisecondsSince(startTime) << " ms (mesh cache "
+				  << (scene->d_isCacheHit ? "hit" : "miss") << ")\n";
+
+		// textures first, so every mesh upload only has to create its buffers;
+		// the decoded ones before those skipped as their duplicates, which find them registered
+		if (loadingModel->d_options.d_packTextures)
+		{
+			io_uploadQueue.push([weakModel, scene, path]()
+			{
+				if (auto model = weakModel.lock())
+					model->packTextures(path, *scene);
+			});
+		}
+		for (const bool isDecoded : { true, false })
+		{
+			for (auto& [texturePath, texture] : scene->d_textures)
+			{
+				if (loadingModel->d_options.d_packTextures || texture.d_image.has_value() != isDecoded)
+					continue;
+
+				io_uploadQueue.push([weakModel, scene, &texturePath, &texture]()
+				{
+					if (auto model = weakModel.lock())
+						model->d_loadedTextures.try_emplace(texturePath, acquireTexture(model->d_options, texturePath, texture));
+				});
+			}
+		}
+
+		// the queue runs in order, so the hierarchy is there before any mesh
+		io_uploadQueue.push([weakModel, scene]()
+		{
+			if (auto model = weakModel.lock())
+				model->d_transforms = utils::TransformGraph(scene->d_nodes);
+		});
+
+		for (size_t i = 0; i < scene->d_meshes.size(); ++i)
+		{
+			io_uploadQueue.push([weakModel, scene, i, path]()
+			{
+				auto model = weakModel.lock();
+				if (!model)
+					return;
+
+				model->d_meshes.push_back(model->createMesh(scene->d_meshes[i], scene->d_meshHashes[i]));
+				model->d_meshNodes.push_back(scene->d_meshes[i].d_node);
+				if (model->d_meshes.size() == scene->d_meshes.size())
+				{
+					model->d_isResident = true;
+					std::cout << "Model " << path << ": resident, " << model->getGeometryBytes() / 1024 << " KB of geometry, "
+							  << model->getCpuGeometryBytes() / 1024 << " KB kept in RAM\n";
+				}
+			});
+		}
+
+		if (scene->d_meshes.empty())
+			loadingModel->d_isResident = true;
+	});
+
+	return model;
+}
+
+void utils::Model::invalidateMeshCache(std::string_view i_path)
+{
+	// the entry's file only depends on the path, the other settings are checked when it is loaded
+	utils::MeshCache(i_path, IMPORT_FLAGS).invalidate();
+}
+
+std::unique_ptr<utils::Model::ImportedScene> utils::Model::importScene(std::string_view i_path) const
+{
+	auto scene = std::make_unique<ImportedScene>();
+
+	auto& cache = scene->d_cache.emplace(i_path, IMPORT_FLAGS, hashLodSettings(d_options));
+	scene->d_isCacheHit = cache.load();
+	if (scene->d_isCacheHit)
+	{
+		scene->d_meshes = cache.getMeshes();
+		scene->d_nodes = cache.getNodes();
+		std::cout << "Model " << i_path << ": " << scene->d_meshes.size() << " meshes mapped from cache\n";
+	}
+	else
+	{
+		Assimp::Importer importer;
+		const aiScene* assimpScene = importer.ReadFile(i_path.data(), IMPORT_FLAGS);
+		if (!assimpScene || assimpScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !assimpScene->mRootNode)
+		{
+			throw std::runtime_error("ERROR::Assimp: " + std::string(importer.GetErrorString()));
+		}
+
+		// meshes are independent of each other, so only the GL upload has to stay on the context thread
+		std::vector<std::pair<aiMesh*, std::uint32_t>> sceneMeshes;
+		processNode(*assimpScene->mRootNode, *assimpScene, utils::NO_PARENT_NODE, scene->d_nodesData, sceneMeshes);
+		scene->d_nodes = scene->d_nodesData;
+
+		const auto extractionStartTime = std::chrono::steady_clock::now();
+		auto& threadPool = utils::ThreadPool::getInstance();
+		auto& meshes = scene->d_meshesData;
+		meshes.resize(sceneMeshes.size());
+		std::vector<utils::MeshOptimizationStats> optimizationStats(sceneMeshes.size());
+		std::vector<double> lodMilliseconds(sceneMeshes.size());
+		threadPool.parallelFor(sceneMeshes.size(), [&](size_t i)
+		{
+			meshes[i] = processMesh(*sceneMeshes[i].first, *assimpScene);
+			meshes[i].d_node = sceneMeshes[i].second;
+			optimizationStats[i] = utils::optimizeMesh(meshes[i]);
+
+			const auto lodStartTime = std::chrono::steady_clock::now();
+			utils::generateLods(meshes[i], d_options.d_lodsCount, d_options.d_lodReduction, d_options.d_lodMaxError);
+			lodMilliseconds[i] = millisecondsSince(lodStartTime);
+		});
+		std::cout << "Model " << i_path << ": extracted " << meshes.size() << " meshes in " << millisecondsSince(extractionStartTime)
+				  << " ms on " << threadPool.getWorkersCount() + 1 << " threads\n";
+
+		size_t lodsCount = 0;
+		size_t lodIndicesCount = 0;
+		for (const auto& mesh : meshes)
+		{
+			lodsCount += mesh.d_lods.size();
+			lodIndicesCount += mesh.d_indices.size() - mesh.d_lods.front().d_indicesCount;
+		}
+		double lodTotalMilliseconds = 0.0;
+		for (const auto milliseconds : lodMilliseconds)
+			lodTotalMilliseconds += milliseconds;
+		std::cout << "Model " << i_path << ": " << lodsCount << " LODs generated in " << lodTotalMilliseconds << " ms of CPU time, "
+				  << lodIndicesCount * sizeof(unsigned int) / 1024 << " KB of extra indices\n";
+
+		utils::MeshOptimizationStats totalStats;
+		for (const auto& stats : optimizationStats)
+		{
+			totalStats.d_before += stats.d_before;
+			totalStats.d_after += stats.d_after;
+		}
+		std::cout << "Model " << i_path << ": ACMR " << totalStats.d_before.getAcmr() << " -> " << totalStats.d_after.getAcmr()
+				  << ", ATVR " << totalStats.d_before.getAtvr() << " -> " << totalStats.d_after.getAtvr()
+				  << ", vertices " << totalStats.d_before.d_verticesCount << " -> " << totalStats.d_after.d_verticesCount << '\n';
+
+		cache.store(meshes, scene->d_nodes);
+		for (const auto& mesh : meshes)
+			scene->d_meshes.push_back({ mesh.d_vertices, mesh.d_indices, mesh.d_textures, mesh.d_lods, mesh.d_bounds, mesh.d_node });
+	}
+
+	// identical meshes of other models, or of this one, are shared, see createMesh()
+	scene->d_meshHashes.resize(scene->d_meshes.size());
+	utils::ThreadPool::getInstance().parallelFor(scene->d_meshes.size(), [&scene](size_t i)
+	{
+		scene->d_meshHashes[i] = hashMesh(scene->d_meshes[i]);
+	});
+
+	if (!d_isCancelled)
+		decodeTextures(i_path, *scene);
+
+	return scene;
+}
+
+void utils::Model::decodeTextures(std::string_view i_path, ImportedScene& io_scene) const
+{
+	// unique paths first, textures are shared between meshes
+	std::vector<const utils::TextureRef*> textures;
+	for (const auto& mesh : io_scene.d_meshes)
+	{
+		for (const auto& texture : mesh.d_textures)
+		{
+			if (io_scene.d_textures.try_emplace(texture.d_path).second)
+				textures.push_back(&texture);
+		}
+	}
+
+	if (textures.empty())
+		return;
+
+	const auto startTime = std::chrono::steady_clock::now();
+	auto& threadPool = utils::ThreadPool::getInstance();
+	auto& registry = utils::AssetRegistry::getInstance();
+
+	// textures other models use are not decoded again, found by path without reading the file, by content otherwise;
+	// packed textures are the model's own, every one of them is decoded
+	const bool isShared = !d_options.d_packTextures;
+	std::vector<ImportedTexture*> imported(textures.size());
+	for (size_t i = 0; i < textures.size(); ++i)
+	{
+		imported[i] = &io_scene.d_textures[textures[i]->d_path];
+		imported[i]->d_type = textures[i]->d_type;
+	}
+	threadPool.parallelFor(textures.size(), [&](size_t i)
+	{
+		if (!d_isCancelled && !(isShared && registry.hasTexture(textures[i]->d_path, d_options.d_compressTextures)))
+			imported[i]->d_contentHash = utils::AssetRegistry::hashFile(textures[i]->d_path);
+	});
+
+	// and identical images under different paths of this model are decoded once
+	std::unordered_set<std::uint64_t> decodedHashes;
+	std::vector<size_t> decoded;
+	for (size_t i = 0; i < textures.size(); ++i)
+	{
+		const auto contentHash = imported[i]->d_contentHash;
+		if (contentHash && !(isShared && registry.hasTexture(textures[i]->d_path, d_options.d_compressTextures, contentHash)) && decodedHashes.insert(contentHash).second)
+			decoded.push_back(i);
+	}
+
+	threadPool.parallelFor(decoded.size(), [&](size_t i)
+	{
+		if (!d_isCancelled)
+			imported[decoded[i]]->d_image = utils::loadTextureImage(textures[decoded[i]]->d_path, d_options.d_compressTextures);
+	});
+
+	size_t compressedCount = 0;
+	for (const auto i : decoded)
+		compressedCount += imported[i]->d_image && std::holds_alternative<utils::CompressedImage>(*imported[i]->d_image) ? 1 : 0;
+	std::cout << "Model " << i_path << ": decoded " << decoded.size() << " textures (" << compressedCount << " block compressed), "
+			  << textures.size() - decoded.size() << " shared, in " << millisecondsSince(startTime) << " ms on " << threadPool.getWorkersCount() + 1
+			  << " threads\n";
+}
+
+void utils::Model::packTextures(std::string_view i_path, ImportedScene& io_scene)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	// only images of the same size and format can be layers of one array, the GL limits the layers of each
+	std::unordered_map<std::uint64_t, std::vector<std::pair<const std::string*, ImportedTexture*>>> groups;
+	for (auto& [texturePath, texture] : io_scene.d_textures)
+	{
+		if (texture.d_image)
+			groups[utils::getTextureArrayKey(*texture.d_image)].emplace_back(&texturePath, &texture);
+	}
+
+	const size_t maxLayersCount = utils::TextureArray::getMaxLayersCount();
+	std::unordered_map<std::uint64_t, utils::TextureLayer> contentLayers;
+	size_t arraysCount = 0;
+	size_t gpuBytes = 0;
+	for (auto& [key, group] : groups)
+	{
+		for (size_t first = 0; first < group.size(); first += maxLayersCount)
+		{
+			const size_t layersCount = std::min(maxLayersCount, group.size() - first);
+			std::vector<const utils::TextureImage*> images;
+			for (size_t i = first; i < first + layersCount; ++i)
+				images.push_back(&*group[i].second->d_image);
+
+			const auto array = std::make_shared<utils::TextureArray>(images);
+			++arraysCount;
+			gpuBytes += array->getGpuBytes();
+			for (size_t i = 0; i < layersCount; ++i)
+			{
+				auto& [texturePath, texture] = group[first + i];
+				const utils::TextureLayer layer{ array, static_cast<int>(i), texture->d_type };
+				d_textureLayers.try_emplace(*texturePath, layer);
+				contentLayers.try_emplace(texture->d_contentHash, layer);
+				texture->d_image.reset();
+			}
+		}
+	}
+
+	// the paths skipped as duplicates sample the layer of the image they duplicate
+	for (const auto& [texturePath, texture] : io_scene.d_textures)
+	{
+		const auto it = contentLayers.find(texture.d_contentHash);
+		if (texture.d_contentHash && it != contentLayers.end())
+			d_textureLayers.try_emplace(texturePath, it->second);
+	}
+
+	std::cout << "Model " << i_path << ": packed " << d_textureLayers.size() << " textures into " << arraysCount << " texture arrays, "
+			  << gpuBytes / 1024 << " KB, in " << millisecondsSince(startTime) << " ms\n";
+}
+
+void utils::Model::Draw(const utils::ShadersManager& i_shaders, const utils::Camera& i_camera, const glm::mat4& i_modelMatrix)
+{
+	forEachVisibleMesh(i_camera, i_modelMatrix, [&](const utils::Mesh& i_mesh, const glm::mat4& i_meshMatrix, size_t i_lod, float)
+	{
+		i_shaders.setMatrix4fv("model", i_meshMatrix);
+		i_mesh.bindMaterial(i_shaders);
+		utils::GLStateCache::getInstance().bindVertexArray(i_mesh.getVAO());
+		i_mesh.drawElements(i_shaders, i_lod);
+	});
+}
+
+void utils::Model::Draw(utils::RenderQueue& io_queue, const utils::ShadersManager& i_shaders, const utils::Camera& i_camera, const glm::mat4& i_modelMatrix)
+{
+	forEachVisibleMesh(i_camera, i_modelMatrix, [&](const utils::Mesh& i_mesh, const glm::mat4& i_meshMatrix, size_t i_lod, float i_distance)
+	{
+		io_queue.push(i_shaders, i_mesh, i_lod, i_meshMatrix, i_distance);
+	});
+}
+
+void utils::Model::Draw(utils::RenderQueue& io_queue, utils::ShaderVariants& io_variants, utils::ShaderFeatures i_sceneFeatures,
+						const utils::Camera& i_camera, const glm::mat4& i_modelMatrix)
+{
+	forEachVisibleMesh(i_camera, i_modelMatrix, [&](const utils::Mesh& i_mesh, const glm::mat4& i_meshMatrix, size_t i_lod, float i_distance)
+	{
+		io_queue.push(io_variants.get(i_sceneFeatures | i_mesh.getShaderFeatures()), i_mesh, i_lod, i_meshMatrix, i_distance);
+	});
+}
+
+template <typename DrawFunc>
+void utils::Model::forEachVisibleMesh(const utils::Camera& i_camera, const glm::mat4& i_modelMatrix, DrawFunc&& i_draw)
+{
+	if (!d_isResident)
+		return;
+
+	// the batch holds the bounds in model space, it is refilled on the first draw and whenever a part moved
+	updateTransforms();
+	if (d_meshBounds.size() != d_meshes.size())
+	{
+		d_meshBounds.clear();
+		for (size_t i = 0; i < d_meshes.size(); ++i)
+			d_meshBounds.add(utils::transformBounds(d_meshes[i]->getBounds(), d_transforms.getWorldTransform(d_meshNodes[i])));
+		d_meshVisibility.resize(d_meshes.size());
+	}
+
+	// planes in model space, so the local bounds can be tested as they are
+	const auto frustum = utils::extractFrustum(i_camera.getProjection() * i_camera.getView() * i_modelMatrix);
+	d_meshBounds.cull(frustum, d_meshVisibility);
+
+	const float pixelsPerUnit = getPixelsPerUnit(i_camera);
+	const auto cameraPos = i_camera.getCameraPos();
+
+	for (size_t i = 0; i < d_meshes.size(); ++i)
+	{
+		if (!d_meshVisibility[i])
+			continue;
+
+		const auto meshMatrix = i_modelMatrix * d_transforms.getWorldTransform(d_meshNodes[i]);
+		const auto bounds = utils::transformBounds(d_meshes[i]->getBounds(), meshMatrix);
+		const float distance = glm::length(bounds.d_center - cameraPos) - bounds.d_radius;
+
+		i_draw(*d_meshes[i], meshMatrix, selectLod(*d_meshes[i], distance, utils::getMaxScale(meshMatrix), pixelsPerUnit), distance);
+	}
+}
+
+void utils::Model::DrawInstanced(const utils::ShadersManager& i_shaders, const utils::Camera& i_camera, const utils::InstanceBuffer& i_instances)
+{
+	if (!d_isResident || i_instances.getInstancesCount() == 0)
+		return;
+
+	updateTransforms();
+
+	const auto cameraPos = i_camera.getCameraPos();
+	float closestInstanceDistance = std::numeric_limits<float>::max();
+	for (const auto& position : i_instances.getPositions())
+		closestInstanceDistance = std::min(closestInstanceDistance, glm::length(position - cameraPos));
+
+	const float pixelsPerUnit = getPixelsPerUnit(i_camera);
+	const float instanceScale = i_instances.getMaxScale();
+
+	for (size_t i = 0; i < d_meshes.size(); ++i)
+	{
+		// the shader applies the instance transform on top of the node's one
+		const auto& nodeMatrix = d_transforms.getWorldTransform(d_meshNodes[i]);
+		const auto bounds = utils::transformBounds(d_meshes[i]->getBounds(), nodeMatrix);
+		const float distance = closestInstanceDistance - (glm::length(bounds.d_center) + bounds.d_radius) * instanceScale;
+
+		i_shaders.setMatrix4fv("model", nodeMatrix);
+		d_meshes[i]->DrawInstanced(i_shaders, i_instances, selectLod(*d_meshes[i], distance, utils::getMaxScale(nodeMatrix) * instanceScale, pixelsPerUnit));
+	}
+}
+
+void utils::Model::DrawInstanced(const utils::ShadersManager& i_shaders, const utils::Camera& i_camera, std::span<const glm::mat4> i_transforms,
+								 std::span<const glm::vec4> i_instanceData /* = {} */)
+{
+	if (!d_instanceBuffer)
+		d_instanceBuffer = std::make_unique<utils::InstanceBuffer>();
+
+	d_instanceBuffer->update(i_transforms, i_instanceData);
+	DrawInstanced(i_shaders, i_camera, *d_instanceBuffer);
+}
+
+void utils::Model::updateTransforms()
+{
+	// the culling bounds are in model space and have to follow moved parts
+	if (d_transforms.update() > 0)
+		d_meshBounds.clear();
+}
+
+utils::TransformGraph& utils::Model::getTransforms()
+{
+	return d_transforms;
+}
+
+size_t utils::Model::selectLod(const utils::Mesh& i_mesh, float i_distance, float i_scale, float i_pixelsPerUnit) const
+{
+	// LOD 0 when the camera is inside of the bounding sphere
+	if (i_distance <= 0.0f || i_scale <= 0.0f)
+		return 0;
+
+	const float maxError = d_options.d_lodPixelError * i_distance / (i_pixelsPerUnit * i_scale);
+
+	size_t lod = 0;
+	while (lod + 1 < i_mesh.getLodsCount() && i_mesh.getLod(lod + 1).d_error <= maxError)
+		++lod;
+	return lod;
+}
+
+bool utils::Model::isResident() const
+{
+	return d_isResident;
+}
+
+bool utils::Model::isMeshCacheHit() const
+{
+	return d_isMeshCacheHit;
+}
+
+size_t utils::Model::getGeometryBytes() const
+{
+	size_t geometryBytes = 0;
+	for (const auto& mesh : d_meshes)
+		geometryBytes += mesh->getGeometryBytes();
+	return geometryBytes;
+}
+
+size_t utils::Model::getCpuGeometryBytes() const
+{
+	size_t geometryBytes = 0;
+	for (const auto& mesh : d_meshes)
+		geometryBytes += mesh->getCpuGeometryBytes();
+	return geometryBytes;
+}
+
+void utils::Model::processNode(aiNode& i_node, const aiScene& i_scene, std::uint32_t i_parent, std::vector<utils::TransformNode>& o_nodes,
+							   std::vector<std::pair<aiMesh*, std::uint32_t>>& o_meshes) const
+{
+	// assimp matrices are row-major
+	const auto nodeIndex = static_cast<std::uint32_t>(o_nodes.size());
+	o_nodes.push_back({ i_parent, glm::transpose(glm::make_mat4(&i_node.mTransformation.a1)) });
+
 	for (unsigned int i = 0; i < i_node.mNumMeshes; ++i)
 	{
 		aiMesh* mesh = i_scene.mMeshes[i_node.mMeshes[i]];
@@ -42,7 +639,7 @@ void utils::Model::processNode(aiNode& i_node, const aiScene& i_scene)
 			continue;
 		}
 
-		d_meshes.push_back(processMesh(*mesh, i_scene));
+		o_meshes.emplace_back(mesh, nodeIndex);
 	}
 
 	for (unsigned int i = 0; i < i_node.mNumChildren; ++i)
@@ -54,15 +651,16 @@ void utils::Model::processNode(aiNode& i_node, const aiScene& i_scene)
 			continue;
 		}
 
-		processNode(*node, i_scene);
+		processNode(*node, i_scene, nodeIndex, o_nodes, o_meshes);
 	}
 }
 
-utils::Mesh utils::Model::processMesh(aiMesh& i_mesh, const aiScene& i_scene)
+utils::MeshData utils::Model::processMesh(aiMesh& i_mesh, const aiScene& i_scene) const
 {
-	std::vector<utils::Vertex> vertices;
-	std::vector<unsigned int> indices;
-	std::vector<utils::Texture> textures;
+	utils::MeshData meshData;
+	auto& vertices = meshData.d_vertices;
+	auto& indices = meshData.d_indices;
+	auto& textures = meshData.d_textures;
 
 	for (unsigned int i = 0; i < i_mesh.mNumVertices; ++i)
 	{
@@ -73,7 +671,7 @@ utils::Mesh utils::Model::processMesh(aiMesh& i_mesh, const aiScene& i_scene)
 		if (!i_mesh.HasNormals())
 		{
 			std::cout << "Null meshNormal\n";
-			return utils::Mesh(vertices, indices, textures);
+			return meshData;
 		}
 		const glm::vec3 normal{ meshNormal.x, meshNormal.y, meshNormal.z };
 
@@ -95,28 +693,30 @@ utils::Mesh utils::Model::processMesh(aiMesh& i_mesh, const aiScene& i_scene)
 			indices.push_back(face.mIndices[j]);
 	}
 
-	if (i_mesh.mMaterialIndex >= 0)
+	meshData.d_bounds = utils::computeBounds(vertices);
+
+	if (i_mesh.mMaterialIndex < i_scene.mNumMaterials)
 	{
 		auto* material = i_scene.mMaterials[i_mesh.mMaterialIndex];
 		if (!material)
 		{
 			std::cout << "Null material\n";
-			return utils::Mesh(vertices, indices, textures);
+			return meshData;
 		}
 
-		std::vector<utils::Texture> diffuseMaps = loadMaterialTextures(*material, aiTextureType_DIFFUSE);
+		std::vector<utils::TextureRef> diffuseMaps = loadMaterialTextures(*material, aiTextureType_DIFFUSE);
 		textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
 
-		std::vector<utils::Texture> specularMaps = loadMaterialTextures(*material, aiTextureType_SPECULAR);
+		std::vector<utils::TextureRef> specularMaps = loadMaterialTextures(*material, aiTextureType_SPECULAR);
 		textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
 	}
 
-	return utils::Mesh(vertices, indices, textures);
+	return meshData;
 }
 
-std::vector<utils::Texture> utils::Model::loadMaterialTextures(aiMaterial& i_material, aiTextureType i_textureType)
+std::vector<utils::TextureRef> utils::Model::loadMaterialTextures(aiMaterial& i_material, aiTextureType i_textureType) const
 {
-	std::vector<utils::Texture> textures;
+	std::vector<utils::TextureRef> textures;
 
 	for (unsigned int i = 0; i < i_material.GetTextureCount(i_textureType); ++i)
 	{
@@ -124,17 +724,78 @@ std::vector<utils::Texture> utils::Model::loadMaterialTextures(aiMaterial& i_mat
 		i_material.GetTexture(i_textureType, i, &texPath);
 
 		const auto path = d_directory / texPath.C_Str();
-		auto it = d_loadedTextures.find(path.string());
+		textures.push_back({ i_textureType, path.string() });
+	}
+
+	return textures;
+}
+
+std::shared_ptr<utils::Mesh> utils::Model::createMesh(const utils::MeshView& i_mesh, std::uint64_t i_meshHash)
+{
+	// meshes are shared when uploaded the same way; not from the model's own pool though, it goes away with the model
+	const bool isShareable = !d_options.d_useGeometryPool || (d_options.d_geometryPool && !d_ownGeometryPool);
+	const bool keepCpuGeometry = !d_options.d_releaseCpuGeometry;
+	const auto* geometryPool = d_options.d_useGeometryPool ? d_options.d_geometryPool : nullptr;
+	auto key = utils::fnv1a(&d_options.d_vertexFormat, sizeof(d_options.d_vertexFormat), i_meshHash);
+	key = utils::fnv1a(&geometryPool, sizeof(geometryPool), key);
+	key = utils::fnv1a(&keepCpuGeometry, sizeof(keepCpuGeometry), key);
+	// the material's textures are the variant acquireTexture() picks, streamed and tracked by the model's streamer and residency
+	key = utils::fnv1a(&d_options.d_compressTextures, sizeof(d_options.d_compressTextures), key);
+	key = utils::fnv1a(&d_options.d_textureStreamer, sizeof(d_options.d_textureStreamer), key);
+	key = utils::fnv1a(&d_options.d_textureResidency, sizeof(d_options.d_textureResidency), key);
+	// packed meshes sample layers, the others 2D textures
+	const bool isPacked = !i_mesh.d_textures.empty() && std::all_of(i_mesh.d_textures.begin(), i_mesh.d_textures.end(), [this](const auto& i_texture)
+	{
+		return d_textureLayers.contains(i_texture.d_path);
+	});
+	key = utils::fnv1a(&isPacked, sizeof(isPacked), key);
+
+	auto& registry = utils::AssetRegistry::getInstance();
+	if (isShareable)
+	{
+		if (auto mesh = registry.findMesh(key))
+			return mesh;
+	}
+
+	utils::MeshMaterial material;
+
+	for (const auto& textureRef : i_mesh.d_textures)
+	{
+		if (isPacked)
+		{
+			// an image can be a diffuse map of one mesh and a specular one of another
+			auto layer = d_textureLayers.at(textureRef.d_path);
+			layer.d_type = textureRef.d_type;
+			material.d_layers.push_back(std::move(layer));
+			continue;
+		}
+
+		auto it = d_loadedTextures.find(textureRef.d_path);
 		if (it == d_loadedTextures.end())
 		{
-			const auto& texture = textures.emplace_back(path.string(), i_textureType);
-			d_loadedTextures.insert({ path.string(), texture });
+			ImportedTexture texture;
+			texture.d_type = textureRef.d_type;
+			it = d_loadedTextures.emplace(textureRef.d_path, acquireTexture(d_options, textureRef.d_path, texture)).first;
 		}
-		else
+
+		material.d_textures.push_back(it->second);
+	}
+
+	std::shared_ptr<utils::Mesh> mesh;
+	if (!d_options.d_useGeometryPool)
+	{
+		mesh = std::make_shared<utils::Mesh>(i_mesh, std::move(material), d_options.d_vertexFormat, keepCpuGeometry);
+	}
+	else
+	{
+		// created on first use, so it happens on the context thread for async loads too
+		if (!d_options.d_geometryPool)
 		{
-			textures.push_back(it->second);
+			d_ownGeometryPool = std::make_unique<utils::GeometryPool>(d_options.d_vertexFormat);
+			d_options.d_geometryPool = d_ownGeometryPool.get();
 		}
+		mesh = std::make_shared<utils::Mesh>(i_mesh, std::move(material), *d_options.d_geometryPool, keepCpuGeometry);
 	}
 
-	return textures;
+	return isShareable ? registry.addMesh(key, std::move(mesh)) : mesh;
 }
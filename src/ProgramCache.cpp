@@ -0,0 +1,186 @@
+#include "ProgramCache.hpp"
+
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+static constexpr std::string_view CACHE_DIR = "cache/programs";
+static constexpr char CACHE_MAGIC[8] = { 'L', 'O', 'G', 'L', 'P', 'R', 'O', 'G' };
+static constexpr std::uint32_t CACHE_VERSION = 1;
+
+// File layout: CacheHeader, binary of d_binarySize bytes
+struct CacheHeader
+{
+    char d_magic[8];
+    std::uint32_t d_version;
+    std::uint32_t d_binaryFormat;
+    std::uint64_t d_key;
+    std::uint64_t d_binarySize;
+    double d_buildMilliseconds;
+};
+
+// binaries are only valid for the driver that produced them
+std::uint64_t hashDriver(std::uint64_t i_seed)
+{
+    std::uint64_t hash = i_seed;
+    for (const GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+    {
+        const auto* value = reinterpret_cast<const char*>(glGetString(name));
+        hash = utils::fnv1a(value ? std::string_view(value) : std::string_view(), hash);
+        hash = utils::fnv1a("\n", hash);
+    }
+    return hash;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point i_start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - i_start).count();
+}
+}
+
+utils::ProgramCache::ProgramCache(std::uint64_t i_sourcesHash) : d_key(hashDriver(i_sourcesHash))
+{
+    std::ostringstream fileName;
+    fileName << std::hex << std::setw(16) << std::setfill('0') << d_key << ".bin";
+    d_cachePath = std::filesystem::path(CACHE_DIR) / fileName.str();
+}
+
+bool utils::ProgramCache::isSupported()
+{
+    static const bool isSupported = []
+    {
+        if (!GLAD_GL_ARB_get_program_binary)
+            return false;
+
+        GLint formatsCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatsCount);
+        return formatsCount > 0;
+    }();
+    return isSupported;
+}
+
+bool utils::ProgramCache::load(GLuint i_program)
+{
+    d_savedMilliseconds = 0.0;
+    d_isRejected = false;
+    if (!isSupported())
+        return false;
+
+    const auto startTime = std::chrono::steady_clock::now();
+    std::ifstream file(d_cachePath, std::ios::binary);
+    if (!file)
+        return false;
+
+    CacheHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file ||
+        std::memcmp(header.d_magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.d_version != CACHE_VERSION ||
+        header.d_key != d_key)
+    {
+        return false;
+    }
+
+    // a truncated or corrupted entry is a miss, the size is checked before allocating it
+    std::error_code ec;
+    const auto fileSize = std::filesystem::file_size(d_cachePath, ec);
+    if (ec || header.d_binarySize != fileSize - sizeof(header) ||
+        header.d_binarySize > static_cast<std::uint64_t>(std::numeric_limits<GLsizei>::max()))
+    {
+        return false;
+    }
+
+    std::vector<char> binary(header.d_binarySize);
+    file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+    if (!file)
+        return false;
+
+    glProgramBinary(i_program, header.d_binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // a rejected binary leaves the program unlinked, it can still be built from source
+    GLint success = 0;
+    glGetProgramiv(i_program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        d_isRejected = true;
+        return false;
+    }
+
+    d_savedMilliseconds = header.d_buildMilliseconds - millisecondsSince(startTime);
+    return true;
+}
+
+void utils::ProgramCache::store(GLuint i_program, double i_buildMilliseconds) const
+{
+    if (!isSupported())
+        return;
+
+    GLint binarySize = 0;
+    glGetProgramiv(i_program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    if (binarySize <= 0)
+        return;
+
+    std::vector<char> binary(static_cast<size_t>(binarySize));
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(i_program, binarySize, &binarySize, &binaryFormat, binary.data());
+    binary.resize(static_cast<size_t>(binarySize));
+
+    std::error_code ec;
+    std::filesystem::create_directories(d_cachePath.parent_path(), ec);
+    if (ec)
+    {
+        std::cout << "Failed to create program cache directory: " << ec.message() << '\n';
+        return;
+    }
+
+    // write to a temporary file first, so a crash never leaves a half-written cache behind;
+    // its name is unique, two instances of the application may build the same program at the same time
+    const auto tmpPath = utils::getTemporaryPath(d_cachePath);
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+
+        CacheHeader header{};
+        std::memcpy(header.d_magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.d_version = CACHE_VERSION;
+        header.d_binaryFormat = binaryFormat;
+        header.d_key = d_key;
+        header.d_binarySize = binary.size();
+        header.d_buildMilliseconds = i_buildMilliseconds;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+
+        if (!file)
+        {
+            std::cout << "Failed to write program cache: " << tmpPath << '\n';
+            return;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, d_cachePath, ec);
+}
+
+double utils::ProgramCache::getSavedMilliseconds() const
+{
+    return d_savedMilliseconds;
+}
+
+bool utils::ProgramCache::isRejected() const
+{
+    return d_isRejected;
+}
+
+const std::filesystem::path& utils::ProgramCache::getCachePath() const
+{
+    return d_cachePath;
+}
@@ -0,0 +1,162 @@
+#include "RenderQueue.hpp"
+
+#include "GLStateCache.hpp"
+#include "Mesh.hpp"
+#include "ShadersManager.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <bit>
+#include <numeric>
+
+namespace
+{
+static constexpr int PROGRAM_SHIFT = 56;
+static constexpr int MATERIAL_SHIFT = 40;
+static constexpr int VERTEX_ARRAY_SHIFT = 24;
+static constexpr std::uint64_t DEPTH_MASK = (std::uint64_t(1) << 24) - 1;
+
+// bit patterns of non-negative floats sort like their values, the top 24 bits keep about 16 of mantissa
+std::uint64_t quantizeDepth(float i_depth)
+{
+    const float depth = i_depth > 0.0f ? i_depth : 0.0f;
+    return (std::bit_cast<std::uint32_t>(depth) >> 7) & DEPTH_MASK;
+}
+}
+
+void utils::RenderQueue::push(const utils::ShadersManager& i_shaders, const utils::Mesh& i_mesh, size_t i_lod, const glm::mat4& i_transform, float i_depth)
+{
+    d_keys.push_back(makeKey(i_shaders, i_mesh, i_depth));
+    d_items.push_back({ &i_shaders, &i_mesh, i_transform, i_lod });
+}
+
+std::uint64_t utils::RenderQueue::makeKey(const utils::ShadersManager& i_shaders, const utils::Mesh& i_mesh, float i_depth)
+{
+    // ids past the field sizes wrap, that only costs grouping, not correctness
+    const auto programId = d_programIds.try_emplace(&i_shaders, static_cast<std::uint32_t>(d_programIds.size())).first->second;
+    const auto materialId = d_materialIds.try_emplace(i_mesh.getMaterialHash(), static_cast<std::uint32_t>(d_materialIds.size())).first->second;
+
+    return (std::uint64_t(programId & 0xff) << PROGRAM_SHIFT)
+         | (std::uint64_t(materialId & 0xffff) << MATERIAL_SHIFT)
+         | (std::uint64_t(i_mesh.getVAO() & 0xffff) << VERTEX_ARRAY_SHIFT)
+         | quantizeDepth(i_depth);
+}
+
+void utils::RenderQueue::sortKeys()
+{
+    // LSD radix sort of the item indices by 8-bit digits, digits equal for every key are skipped
+    const size_t count = d_keys.size();
+    d_order.resize(count);
+    d_scratch.resize(count);
+    std::iota(d_order.begin(), d_order.end(), 0);
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        std::array<std::uint32_t, 256> histogram{};
+        for (const auto key : d_keys)
+            ++histogram[(key >> shift) & 0xff];
+
+        if (histogram[(d_keys.front() >> shift) & 0xff] == count)
+            continue;
+
+        std::uint32_t offset = 0;
+        for (auto& bucket : histogram)
+        {
+            const auto bucketSize = bucket;
+            bucket = offset;
+            offset += bucketSize;
+        }
+
+        for (const auto index : d_order)
+            d_scratch[histogram[(d_keys[index] >> shift) & 0xff]++] = index;
+        d_order.swap(d_scratch);
+    }
+}
+
+utils::RenderQueueStats utils::RenderQueue::countStateChanges(const std::vector<std::uint32_t>& i_order) const
+{
+    utils::RenderQueueStats stats;
+    stats.d_drawsCount = i_order.size();
+
+    const utils::ShadersManager* shaders = nullptr;
+    std::uint64_t material = 0;
+    GLuint vertexArray = 0;
+    for (size_t i = 0; i < i_order.size(); ++i)
+    {
+        const auto& item = d_items[i_order[i]];
+        const bool isProgramChanged = i == 0 || item.d_shaders != shaders;
+        const bool isMaterialChanged = isProgramChanged || item.d_mesh->getMaterialHash() != material;
+
+        stats.d_programChanges += isProgramChanged ? 1 : 0;
+        stats.d_materialChanges += isMaterialChanged ? 1 : 0;
+        stats.d_vertexArrayChanges += i == 0 || item.d_mesh->getVAO() != vertexArray ? 1 : 0;
+
+        shaders = item.d_shaders;
+        material = item.d_mesh->getMaterialHash();
+        vertexArray = item.d_mesh->getVAO();
+    }
+
+    return stats;
+}
+
+void utils::RenderQueue::submit()
+{
+    if (d_items.empty())
+    {
+        d_unsortedStats = {};
+        d_sortedStats = {};
+        return;
+    }
+
+    d_order.resize(d_items.size());
+    std::iota(d_order.begin(), d_order.end(), 0);
+    d_unsortedStats = countStateChanges(d_order);
+
+    sortKeys();
+    d_sortedStats = countStateChanges(d_order);
+
+    const utils::ShadersManager* shaders = nullptr;
+    std::uint64_t material = 0;
+    GLuint vertexArray = 0;
+    for (size_t i = 0; i < d_order.size(); ++i)
+    {
+        const auto& item = d_items[d_order[i]];
+
+        // sampler uniforms are per program, a new program needs the material again
+        const bool isProgramChanged = i == 0 || item.d_shaders != shaders;
+        if (isProgramChanged)
+        {
+            shaders = item.d_shaders;
+            shaders->render();
+        }
+
+        if (isProgramChanged || item.d_mesh->getMaterialHash() != material)
+        {
+            material = item.d_mesh->getMaterialHash();
+            item.d_mesh->bindMaterial(*shaders);
+        }
+
+        if (i == 0 || item.d_mesh->getVAO() != vertexArray)
+        {
+            vertexArray = item.d_mesh->getVAO();
+            utils::GLStateCache::getInstance().bindVertexArray(vertexArray);
+        }
+
+        shaders->setMatrix4fv("model", item.d_transform);
+        item.d_mesh->drawElements(*shaders, item.d_lod);
+    }
+
+    d_items.clear();
+    d_keys.clear();
+}
+
+const utils::RenderQueueStats& utils::RenderQueue::getUnsortedStats() const
+{
+    return d_unsortedStats;
+}
+
+const utils::RenderQueueStats& utils::RenderQueue::getSortedStats() const
+{
+    return d_sortedStats;
+}
@@ -0,0 +1,78 @@
+#include "ShaderVariants.hpp"
+
+#include "AssetRegistry.hpp"
+#include "Hash.hpp"
+#include "ShadersManager.hpp"
+#include "UniformBlocks.hpp"
+
+#include <algorithm>
+
+utils::ShaderFeatures utils::makePointLightsFeature(size_t i_pointLightsCount)
+{
+    const size_t count = std::min(i_pointLightsCount, utils::POINT_LIGHTS_COUNT);
+    return (static_cast<utils::ShaderFeatures>(count) << utils::SHADER_POINT_LIGHTS_SHIFT) & utils::SHADER_POINT_LIGHTS_MASK;
+}
+
+size_t utils::getPointLightsCount(utils::ShaderFeatures i_features)
+{
+    return (i_features & utils::SHADER_POINT_LIGHTS_MASK) >> utils::SHADER_POINT_LIGHTS_SHIFT;
+}
+
+utils::ShaderVariants::ShaderVariants(std::string_view i_vertexShaderPath, std::string_view i_fragmentShaderPath)
+    : d_vertexShaderPath(i_vertexShaderPath), d_fragmentShaderPath(i_fragmentShaderPath)
+{
+}
+
+utils::ShaderVariants::~ShaderVariants() = default;
+
+const utils::ShadersManager& utils::ShaderVariants::get(utils::ShaderFeatures i_features)
+{
+    auto& variant = d_variants[i_features];
+    if (variant)
+        return *variant;
+
+    // other sets built from the same sources share their programs
+    const auto defines = getDefines(i_features);
+    auto key = utils::fnv1a(utils::AssetRegistry::normalizePath(d_vertexShaderPath));
+    key = utils::fnv1a(utils::AssetRegistry::normalizePath(d_fragmentShaderPath), key);
+    for (const auto& define : defines)
+        key = utils::fnv1a(define, key);
+
+    auto& registry = utils::AssetRegistry::getInstance();
+    variant = registry.findProgram(key);
+    if (!variant)
+        variant = registry.addProgram(key, std::make_shared<utils::ShadersManager>(d_vertexShaderPath, d_fragmentShaderPath, defines));
+    return *variant;
+}
+
+void utils::ShaderVariants::prewarm(std::span<const utils::ShaderFeatures> i_features)
+{
+    for (const auto features : i_features)
+        get(features);
+}
+
+size_t utils::ShaderVariants::getVariantsCount() const
+{
+    return d_variants.size();
+}
+
+std::vector<std::string> utils::ShaderVariants::getDefines(utils::ShaderFeatures i_features)
+{
+    std::vector<std::string> defines;
+    if (i_features & utils::SHADER_DIR_LIGHT)
+        defines.push_back("DIR_LIGHT");
+    if (i_features & utils::SHADER_SPOT_LIGHT)
+        defines.push_back("SPOT_LIGHT");
+    if (i_features & utils::SHADER_SPECULAR_MAP)
+        defines.push_back("SPECULAR_MAP");
+    if (i_features & utils::SHADER_INSTANCED)
+        defines.push_back("INSTANCED");
+    if (i_features & utils::SHADER_TEXTURE_ARRAY)
+        defines.push_back("TEXTURE_ARRAY");
+    if (i_features & utils::SHADER_CLUSTERED_LIGHTS)
+        defines.push_back("CLUSTERED_LIGHTS");
+    if (i_features & utils::SHADER_DEFERRED_LIGHTING)
+        defines.push_back("DEFERRED_LIGHTING");
+    defines.push_back("POINT_LIGHTS_CNT " + std::to_string(utils::getPointLightsCount(i_features)));
+    return defines;
+}
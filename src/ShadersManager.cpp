@@ -1,9 +1,17 @@
 #include "ShadersManager.hpp"
 
+#include "GLStateCache.hpp"
+#include "Hash.hpp"
+#include "ProgramCache.hpp"
+#include "UniformBlocks.hpp"
+
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 
 namespace
@@ -20,7 +28,7 @@ void checkShaderCompilation(GLuint i_shader, std::string_view i_shaderName)
     }
 }
 
-GLuint prepareShader(std::string_view i_shaderPath, GLenum i_shaderType)
+std::string readShader(std::string_view i_shaderPath)
 {
     std::ifstream shaderFile(i_shaderPath.data());
     if (!shaderFile)
@@ -32,85 +40,227 @@ GLuint prepareShader(std::string_view i_shaderPath, GLenum i_shaderType)
     {
         shader += line + '\n';
     }
+    return shader;
+}
 
+GLuint prepareShader(const std::string& i_shader, std::string_view i_shaderPath, GLenum i_shaderType)
+{
     unsigned int shaderId = glCreateShader(i_shaderType);
-    const auto shaderCStr = shader.c_str();
+    const auto shaderCStr = i_shader.c_str();
     glShaderSource(shaderId, 1, &shaderCStr, nullptr);
     glCompileShader(shaderId);
     checkShaderCompilation(shaderId, i_shaderPath);
 
     return shaderId;
 }
-}
 
-utils::ShadersManager::ShadersManager(std::string_view i_vertexShaderPath, std::string_view i_fragmentShaderPath)
+void buildProgram(GLuint i_program, const std::string& i_vertexShader, std::string_view i_vertexShaderPath,
+                  const std::string& i_fragmentShader, std::string_view i_fragmentShaderPath)
 {
-    const auto vertexId = prepareShader(i_vertexShaderPath, GL_VERTEX_SHADER);
-    const auto fragmentId = prepareShader(i_fragmentShaderPath, GL_FRAGMENT_SHADER);
+    const auto vertexId = prepareShader(i_vertexShader, i_vertexShaderPath, GL_VERTEX_SHADER);
+    const auto fragmentId = prepareShader(i_fragmentShader, i_fragmentShaderPath, GL_FRAGMENT_SHADER);
 
-    d_programId = glCreateProgram();
-    glAttachShader(d_programId, vertexId);
-    glAttachShader(d_programId, fragmentId);
-    glLinkProgram(d_programId);
+    glAttachShader(i_program, vertexId);
+    glAttachShader(i_program, fragmentId);
+    if (utils::ProgramCache::isSupported())
+        glProgramParameteri(i_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(i_program);
 
     GLint success = 0;
     char infoLog[512];
-    glGetProgramiv(d_programId, GL_LINK_STATUS, &success);
+    glGetProgramiv(i_program, GL_LINK_STATUS, &success);
     if(!success)
     {
-        glGetProgramInfoLog(d_programId, 512, nullptr, infoLog);
+        glGetProgramInfoLog(i_program, 512, nullptr, infoLog);
         throw std::runtime_error("Shaider linking failed" + std::string(infoLog));
     }
 
+    glDetachShader(i_program, vertexId);
+    glDetachShader(i_program, fragmentId);
     glDeleteShader(vertexId);
     glDeleteShader(fragmentId);
 }
 
+// the defines go right after the #version line, which has to stay first
+std::string addDefines(const std::string& i_shader, std::span<const std::string> i_defines)
+{
+    if (i_defines.empty())
+        return i_shader;
+
+    const size_t versionEnd = i_shader.starts_with("#version") ? i_shader.find('\n') + 1 : 0;
+    std::string shader = i_shader.substr(0, versionEnd);
+    for (const auto& define : i_defines)
+        shader += "#define " + define + '\n';
+    shader.append(i_shader, versionEnd);
+    return shader;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point i_start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - i_start).count();
+}
+}
+
+utils::ShadersManager::ShadersManager(std::string_view i_vertexShaderPath, std::string_view i_fragmentShaderPath,
+                                      std::span<const std::string> i_defines /* = {} */)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    const std::string vertexShader = addDefines(readShader(i_vertexShaderPath), i_defines);
+    const std::string fragmentShader = addDefines(readShader(i_fragmentShaderPath), i_defines);
+
+    d_program = utils::ProgramHandle::create();
+    const GLuint programId = d_program.get();
+
+    // the defines are part of the sources; the length separates them, so moving code from one stage to the other changes the key
+    std::uint64_t sourcesHash = utils::fnv1a(vertexShader);
+    sourcesHash = utils::fnv1a(std::to_string(vertexShader.size()), sourcesHash);
+    sourcesHash = utils::fnv1a(fragmentShader, sourcesHash);
+
+    utils::ProgramCache cache(sourcesHash);
+    std::cout << "Program " << i_vertexShaderPath << " + " << i_fragmentShaderPath;
+    for (const auto& define : i_defines)
+        std::cout << ' ' << define;
+    std::cout << ": ";
+    if (cache.load(programId))
+    {
+        std::cout << "binary cache hit, loaded in " << millisecondsSince(startTime) << " ms, saved "
+                  << cache.getSavedMilliseconds() << " ms\n";
+    }
+    else
+    {
+        buildProgram(programId, vertexShader, i_vertexShaderPath, fragmentShader, i_fragmentShaderPath);
+        const double buildMilliseconds = millisecondsSince(startTime);
+        cache.store(programId, buildMilliseconds);
+        // a rejected binary is a miss too, reported on the same line
+        std::cout << (!utils::ProgramCache::isSupported() ? "no program binary support"
+                      : cache.isRejected()                ? "binary cache miss, cached binary rejected by the driver"
+                                                          : "binary cache miss")
+                  << ", built in " << buildMilliseconds << " ms\n";
+    }
+
+    reflectUniforms();
+
+    // GLSL 330 has no binding layout qualifier, the shared blocks get their binding points here
+    for (const auto& block : utils::UNIFORM_BLOCKS)
+    {
+        const GLuint blockIndex = glGetUniformBlockIndex(programId, block.d_name);
+        if (blockIndex != GL_INVALID_INDEX)
+            glUniformBlockBinding(programId, blockIndex, block.d_binding);
+    }
+
+    // no binding qualifier for samplers either, setting their units needs the program in use
+    for (const auto& sampler : utils::UNIFORM_SAMPLERS)
+    {
+        const GLint location = getUniformLocation(utils::UniformId::fromName(sampler.d_name));
+        if (location == -1)
+            continue;
+
+        utils::GLStateCache::getInstance().useProgram(programId);
+        glUniform1i(location, static_cast<GLint>(sampler.d_unit));
+    }
+}
+
+void utils::ShadersManager::reflectUniforms()
+{
+    const GLuint programId = d_program.get();
+
+    GLint uniformsCount = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(programId, GL_ACTIVE_UNIFORMS, &uniformsCount);
+    glGetProgramiv(programId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    size_t capacity = 1;
+    while (capacity < 2 * static_cast<size_t>(uniformsCount) + 1)
+        capacity *= 2;
+    d_uniforms.assign(capacity, {});
+
+    const auto insert = [this](std::string_view i_name, GLint i_location)
+    {
+        const std::uint64_t hash = utils::fnv1a(i_name);
+        for (size_t slot = hash & (d_uniforms.size() - 1);; slot = (slot + 1) & (d_uniforms.size() - 1))
+        {
+            auto& uniform = d_uniforms[slot];
+            if (uniform.d_location == -1)
+            {
+                uniform = { hash, i_location };
+                return;
+            }
+            if (uniform.d_hash == hash)
+                throw std::runtime_error("Uniform name hash collision: " + std::string(i_name));
+        }
+    };
+
+    std::string name(std::max(maxNameLength, 1), '\0');
+    for (GLint i = 0; i < uniformsCount; ++i)
+    {
+        GLsizei nameLength = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(programId, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &nameLength, &size, &type, name.data());
+
+        // uniform block members have no location, they are set through their buffer
+        const std::string_view uniformName(name.data(), nameLength);
+        const GLint location = glGetUniformLocation(programId, name.c_str());
+        if (location == -1)
+            continue;
+
+        // arrays are reported as "name[0]", they are set through their plain name
+        if (uniformName.ends_with("[0]"))
+            insert(uniformName.substr(0, uniformName.size() - 3), location);
+        else
+            insert(uniformName, location);
+    }
+}
+
 void utils::ShadersManager::render() const
 {
-    glUseProgram(d_programId);
+    utils::GLStateCache::getInstance().useProgram(d_program.get());
 }
 
 GLuint utils::ShadersManager::getId() const
 {
-    return d_programId;
+    return d_program.get();
 }
 
-void utils::ShadersManager::setBool(const std::string& i_name, bool i_value) const
+GLint utils::ShadersManager::getUniformLocation(utils::UniformId i_uniform) const
 {
-    setInt(i_name, static_cast<int>(i_value));
+    for (size_t slot = i_uniform.d_hash & (d_uniforms.size() - 1);; slot = (slot + 1) & (d_uniforms.size() - 1))
+    {
+        const auto& uniform = d_uniforms[slot];
+        if (uniform.d_location == -1 || uniform.d_hash == i_uniform.d_hash)
+            return uniform.d_location;
+    }
 }
 
-void utils::ShadersManager::setInt(const std::string& i_name, int i_value) const
+void utils::ShadersManager::setBool(utils::UniformId i_uniform, bool i_value) const
 {
-    glUniform1i(glGetUniformLocation(d_programId, i_name.c_str()), i_value);
+    setInt(i_uniform, static_cast<int>(i_value));
 }
 
-void utils::ShadersManager::setFloat(const std::string& i_name, float i_value) const
+void utils::ShadersManager::setInt(utils::UniformId i_uniform, int i_value) const
 {
-    const auto valueLocation = glGetUniformLocation(d_programId, i_name.c_str());
-    /*if (valueLocation == -1)
-    {
-        std::cout << "Bad uniform float: " << i_name << '\n';
-        throw std::runtime_error("Bad uniform float: " + i_name);
-    }*/
-    glUniform1f(valueLocation, i_value);
+    glUniform1i(getUniformLocation(i_uniform), i_value);
+}
+
+void utils::ShadersManager::setFloat(utils::UniformId i_uniform, float i_value) const
+{
+    glUniform1f(getUniformLocation(i_uniform), i_value);
 }
 
-void utils::ShadersManager::setVec3(const std::string& i_name, const glm::vec3& i_vec) const
+void utils::ShadersManager::setVec3(utils::UniformId i_uniform, const glm::vec3& i_vec) const
 {
-    const int vecLoc = glGetUniformLocation(d_programId, i_name.c_str());
+    const GLint vecLoc = getUniformLocation(i_uniform);
     if (vecLoc == -1)
     {
-        std::cout << "Bad uniform vec3: " << i_name << '\n';
-        throw std::runtime_error("Bad uniform vec3: " + i_name);
+        const std::string name = i_uniform.d_name ? i_uniform.d_name : "<runtime name>";
+        std::cout << "Bad uniform vec3: " << name << '\n';
+        throw std::runtime_error("Bad uniform vec3: " + name);
     }
 
     glUniform3fv(vecLoc, 1, glm::value_ptr(i_vec));
 }
 
-void utils::ShadersManager::setMatrix4fv(const std::string& i_name, const glm::mat4& i_matrix) const
+void utils::ShadersManager::setMatrix4fv(utils::UniformId i_uniform, const glm::mat4& i_matrix) const
 {
-    const int matrixLoc = glGetUniformLocation(d_programId, i_name.c_str());
-    glUniformMatrix4fv(matrixLoc, 1, GL_FALSE, glm::value_ptr(i_matrix));
+    glUniformMatrix4fv(getUniformLocation(i_uniform), 1, GL_FALSE, glm::value_ptr(i_matrix));
 }
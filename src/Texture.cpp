@@ -1,7 +1,16 @@
 #include "Texture.hpp"
 
+#include "GLStateCache.hpp"
+#include "TextureCache.hpp"
+
+// the decoder is compiled into the library, so the tests link it without the application
+#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
 #include <stdexcept>
 #include <unordered_map>
 
@@ -21,30 +30,209 @@ GLenum channelsToFormat(int i_channelsNum)
         return GL_RED;
     }
 }
+
+// what activate() records as the last use of a texture, advanced by TextureResidency
+std::uint64_t currentFrame = 0;
+
+// a texture always has a level, the resident range and dropLevels() clamp to the last one
+const utils::CompressedImage& checkMips(const utils::CompressedImage& i_image)
+{
+    if (i_image.d_mips.empty())
+        throw std::runtime_error("Compressed image without mip levels");
+    return i_image;
+}
+}
+
+void utils::ImageData::Deleter::operator()(unsigned char* i_pixels) const
+{
+    stbi_image_free(i_pixels);
+}
+
+utils::ImageData utils::loadImage(const std::string& i_imagePath)
+{
+    ImageData image;
+    image.d_pixels.reset(stbi_load(i_imagePath.c_str(), &image.d_width, &image.d_height, &image.d_channels, 0));
+    if (!image.d_pixels)
+        throw std::runtime_error("Failed to load texture: " + i_imagePath);
+
+    return image;
+}
+
+GLenum utils::getImageFormat(const ImageData& i_image)
+{
+    return channelsToFormat(i_image.d_channels);
 }
 
-utils::Texture::Texture(const std::string& i_texturePath, aiTextureType i_textureType, GLenum i_wrapParam /* = GL_REPEAT */) : d_texId(0), d_textureType(i_textureType)
+utils::TextureImage utils::loadTextureImage(const std::string& i_imagePath, bool i_compress)
 {
-    int texWidth = 0;
-    int texHeight = 0;
-    int texNrChannels = 0;
-    unsigned char* texData = stbi_load(i_texturePath.c_str(), &texWidth, &texHeight, &texNrChannels, 0);
-    if (!texData)
-        throw std::runtime_error("Failed to load texture: " + i_texturePath);
+    if (!i_compress)
+        return utils::loadImage(i_imagePath);
+
+    const utils::TextureCache cache(i_imagePath);
+    if (auto compressed = cache.load(); compressed && utils::isBlockFormatSupported(compressed->d_format))
+        return std::move(*compressed);
+
+    auto image = utils::loadImage(i_imagePath);
+    const auto format = utils::chooseBlockFormat(image);
+    if (!utils::isBlockFormatSupported(format))
+        return image;
 
-    glGenTextures(1, &d_texId);
-    glBindTexture(GL_TEXTURE_2D, d_texId);
+    const auto startTime = std::chrono::steady_clock::now();
+    auto compressed = utils::compressImage(image, format);
+    const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    cache.store(compressed);
+
+    // the encoder benchmark, pixels of the source level per second
+    const size_t rawBytes = static_cast<size_t>(image.d_width) * image.d_height * image.d_channels;
+    std::cout << "Texture " << i_imagePath << ": " << image.d_width << 'x' << image.d_height << " compressed to "
+              << utils::getBlockFormatName(format) << " in " << milliseconds << " ms, "
+              << static_cast<double>(image.d_width) * image.d_height / (milliseconds * 1e3) << " MPixels/s, "
+              << rawBytes / 1024 << " KB -> " << compressed.d_data.size() / 1024 << " KB with mips\n";
+    return compressed;
+}
+
+utils::Texture::Texture(const std::string& i_texturePath, aiTextureType i_textureType, GLenum i_wrapParam /* = GL_REPEAT */)
+    : Texture(utils::loadImage(i_texturePath), i_textureType, i_wrapParam)
+{
+
+}
+
+utils::Texture::Texture(const ImageData& i_image, aiTextureType i_textureType, GLenum i_wrapParam /* = GL_REPEAT */)
+    : d_texId(utils::TextureHandle::create()), d_textureType(i_textureType)
+{
+    prepare(i_wrapParam);
+    upload(i_image);
+}
+
+utils::Texture::Texture(const CompressedImage& i_image, aiTextureType i_textureType, GLenum i_wrapParam /* = GL_REPEAT */)
+    : d_texId(utils::TextureHandle::create()), d_textureType(i_textureType)
+{
+    prepare(i_wrapParam);
+    upload(i_image);
+}
+
+utils::Texture::Texture(const TextureImage& i_image, aiTextureType i_textureType, GLenum i_wrapParam /* = GL_REPEAT */)
+    : d_texId(utils::TextureHandle::create()), d_textureType(i_textureType)
+{
+    prepare(i_wrapParam);
+    std::visit([this](const auto& i_data) { upload(i_data); }, i_image);
+}
+
+utils::Texture::Texture(const CompressedImage& i_image, size_t i_firstResidentLevel, aiTextureType i_textureType, GLenum i_wrapParam /* = GL_REPEAT */)
+    : d_texId(utils::TextureHandle::create()), d_textureType(i_textureType), d_residentLevel(std::min(i_firstResidentLevel, checkMips(i_image).d_mips.size() - 1))
+{
+    prepare(i_wrapParam);
+
+    // the finer levels stay undefined until they are streamed in, sampling never reaches them
+    d_internalFormat = utils::getCompressedGLFormat(i_image.d_format);
+    d_isCompressed = true;
+    d_levelBytes.assign(i_image.d_mips.size(), 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(d_residentLevel));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(i_image.d_mips.size()) - 1);
+    for (size_t level = d_residentLevel; level < i_image.d_mips.size(); ++level)
+    {
+        const auto& mip = i_image.d_mips[level];
+        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), d_internalFormat, mip.d_width, mip.d_height, 0, static_cast<GLsizei>(mip.d_size),
+                               i_image.d_data.data() + mip.d_offset);
+        d_levelBytes[level] = mip.d_size;
+    }
+}
+
+void utils::Texture::uploadStreamedLevel(const CompressedImage& i_image, size_t i_level)
+{
+    if (i_level + 1 != d_residentLevel)
+        throw std::runtime_error("Texture mips have to be streamed in from the smallest to the largest");
+
+    const auto& mip = i_image.d_mips[i_level];
+    utils::GLStateCache::getInstance().bindTexture(0, GL_TEXTURE_2D, d_texId.get());
+    glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i_level), d_internalFormat, mip.d_width, mip.d_height, 0, static_cast<GLsizei>(mip.d_size),
+                           nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(i_level));
+    d_levelBytes[i_level] = mip.d_size;
+    d_residentLevel = i_level;
+}
+
+void utils::Texture::dropLevels(size_t i_firstKeptLevel)
+{
+    const size_t firstKeptLevel = std::min(i_firstKeptLevel, d_levelBytes.size() - 1);
+    if (firstKeptLevel <= d_residentLevel)
+        return;
+
+    auto& glState = utils::GLStateCache::getInstance();
+    glState.bindTexture(0, GL_TEXTURE_2D, d_texId.get());
+    glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // sampling moves to the kept levels, then the dropped ones are redefined as empty images, which frees their storage
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(firstKeptLevel));
+    for (size_t level = d_residentLevel; level < firstKeptLevel; ++level)
+    {
+        if (d_isCompressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), d_internalFormat, 0, 0, 0, 0, nullptr);
+        else
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), static_cast<GLint>(d_internalFormat), 0, 0, 0, d_internalFormat, GL_UNSIGNED_BYTE, nullptr);
+        d_levelBytes[level] = 0;
+    }
+    d_residentLevel = firstKeptLevel;
+}
+
+void utils::Texture::reload(const TextureImage& i_image)
+{
+    auto& glState = utils::GLStateCache::getInstance();
+    glState.bindTexture(0, GL_TEXTURE_2D, d_texId.get());
+    glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    d_residentLevel = 0;
+    std::visit([this](const auto& i_data) { upload(i_data); }, i_image);
+}
+
+void utils::Texture::prepare(GLenum i_wrapParam)
+{
+    // uploads go through unit 0, the cache knows it changed; pixels come from client memory
+    auto& glState = utils::GLStateCache::getInstance();
+    glState.bindTexture(0, GL_TEXTURE_2D, d_texId.get());
+    glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, i_wrapParam);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, i_wrapParam);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
 
-    const auto imageFormat = channelsToFormat(texNrChannels);
-    glTexImage2D(GL_TEXTURE_2D, 0, imageFormat, texWidth, texHeight, 0, imageFormat, GL_UNSIGNED_BYTE, texData);
+void utils::Texture::upload(const ImageData& i_image)
+{
+    d_internalFormat = channelsToFormat(i_image.d_channels);
+    d_isCompressed = false;
+    glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(d_internalFormat), i_image.d_width, i_image.d_height, 0, d_internalFormat, GL_UNSIGNED_BYTE,
+                 i_image.d_pixels.get());
     glGenerateMipmap(GL_TEXTURE_2D);
 
-    stbi_image_free(texData);
+    // drivers usually pad RGB to four bytes per texel
+    const size_t texelBytes = i_image.d_channels == 3 ? 4 : static_cast<size_t>(i_image.d_channels);
+    d_levelBytes.clear();
+    for (int width = i_image.d_width, height = i_image.d_height;; width = std::max(1, width / 2), height = std::max(1, height / 2))
+    {
+        d_levelBytes.push_back(static_cast<size_t>(width) * height * texelBytes);
+        if (width == 1 && height == 1)
+            break;
+    }
+}
+
+void utils::Texture::upload(const CompressedImage& i_image)
+{
+    // the mips come precomputed, the chain may stop before 1x1 in files written by other tools
+    checkMips(i_image);
+    d_internalFormat = utils::getCompressedGLFormat(i_image.d_format);
+    d_isCompressed = true;
+    d_levelBytes.clear();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(i_image.d_mips.size()) - 1);
+    for (size_t level = 0; level < i_image.d_mips.size(); ++level)
+    {
+        const auto& mip = i_image.d_mips[level];
+        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), d_internalFormat, mip.d_width, mip.d_height, 0, static_cast<GLsizei>(mip.d_size),
+                               i_image.d_data.data() + mip.d_offset);
+        d_levelBytes.push_back(mip.d_size);
+    }
 }
 
 utils::Texture::Texture(const std::string& i_texturePath, GLenum i_wrapParam /* = GL_REPEAT */) : Texture(i_texturePath, aiTextureType::aiTextureType_UNKNOWN, i_wrapParam)
@@ -54,13 +242,13 @@ utils::Texture::Texture(const std::string& i_texturePath, GLenum i_wrapParam /*
 
 void utils::Texture::activate(GLenum i_texUnit) const
 {
-    glActiveTexture(i_texUnit);
-    glBindTexture(GL_TEXTURE_2D, d_texId);
+    d_lastUsedFrame = currentFrame;
+    utils::GLStateCache::getInstance().bindTexture(i_texUnit - GL_TEXTURE0, GL_TEXTURE_2D, d_texId.get());
 }
 
 GLuint utils::Texture::getId() const
 {
-    return d_texId;
+    return d_texId.get();
 }
 
 aiTextureType utils::Texture::getType() const
@@ -68,15 +256,50 @@ aiTextureType utils::Texture::getType() const
     return d_textureType;
 }
 
+size_t utils::Texture::getResidentLevel() const
+{
+    return d_residentLevel;
+}
+
+size_t utils::Texture::getLevelsCount() const
+{
+    return d_levelBytes.size();
+}
+
+size_t utils::Texture::getGpuBytes() const
+{
+    return std::accumulate(d_levelBytes.begin(), d_levelBytes.end(), size_t(0));
+}
+
+std::uint64_t utils::Texture::getLastUsedFrame() const
+{
+    return d_lastUsedFrame;
+}
+
+std::uint64_t utils::Texture::getCurrentFrame()
+{
+    return currentFrame;
+}
+
+void utils::Texture::setCurrentFrame(std::uint64_t i_frame)
+{
+    currentFrame = i_frame;
+}
+
 std::string utils::Texture::getTypeAsString() const
+{
+    return getTypeAsString(d_textureType);
+}
+
+std::string utils::Texture::getTypeAsString(aiTextureType i_textureType)
 {
     static const std::unordered_map<aiTextureType, std::string> typeToString = {
         {aiTextureType::aiTextureType_DIFFUSE, "diffuse"},
         {aiTextureType::aiTextureType_SPECULAR, "specular"}
     };
 
-    auto it = typeToString.find(d_textureType);
+    auto it = typeToString.find(i_textureType);
     if (it == typeToString.end())
-        throw std::runtime_error("Bad texture type: " + static_cast<int>(d_textureType));
+        throw std::runtime_error("Bad texture type: " + std::to_string(static_cast<int>(i_textureType)));
     return it->second;
 }
@@ -0,0 +1,117 @@
+#include "TextureArray.hpp"
+
+#include "GLStateCache.hpp"
+#include "Hash.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <variant>
+
+std::uint64_t utils::getTextureArrayKey(const utils::TextureImage& i_image)
+{
+    // the kind of image is part of the key, an RGB image and a BC1 one of the same size don't mix
+    const std::uint32_t kind = static_cast<std::uint32_t>(i_image.index());
+    auto key = utils::fnv1a(&kind, sizeof(kind));
+    return std::visit([key](const auto& i_data)
+    {
+        using Image = std::decay_t<decltype(i_data)>;
+        std::array<std::int64_t, 4> description = {};
+        if constexpr (std::is_same_v<Image, utils::ImageData>)
+            description = { i_data.d_width, i_data.d_height, i_data.d_channels, 0 };
+        else
+            description = { i_data.d_mips.front().d_width, i_data.d_mips.front().d_height, static_cast<std::int64_t>(i_data.d_format),
+                            static_cast<std::int64_t>(i_data.d_mips.size()) };
+        return utils::fnv1a(description.data(), sizeof(description), key);
+    }, i_image);
+}
+
+utils::TextureArray::TextureArray(std::span<const utils::TextureImage* const> i_images, GLenum i_wrapParam /* = GL_REPEAT */)
+    : d_texId(utils::TextureHandle::create()), d_layersCount(i_images.size())
+{
+    if (i_images.empty() || i_images.size() > getMaxLayersCount())
+        throw std::runtime_error("Bad texture array layers count: " + std::to_string(i_images.size()));
+
+    // uploads go through unit 0, pixels come from client memory
+    auto& glState = utils::GLStateCache::getInstance();
+    glState.bindTexture(0, GL_TEXTURE_2D_ARRAY, d_texId.get());
+    glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, i_wrapParam);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, i_wrapParam);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    std::visit([this, i_images](const auto& i_first) { upload(i_images, i_first); }, *i_images.front());
+}
+
+void utils::TextureArray::upload(std::span<const utils::TextureImage* const> i_images, const utils::ImageData& i_first)
+{
+    const auto format = utils::getImageFormat(i_first);
+    const auto layersCount = static_cast<GLsizei>(i_images.size());
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, static_cast<GLint>(format), i_first.d_width, i_first.d_height, layersCount, 0, format, GL_UNSIGNED_BYTE, nullptr);
+    for (GLsizei layer = 0; layer < layersCount; ++layer)
+    {
+        const auto& image = std::get<utils::ImageData>(*i_images[layer]);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, image.d_width, image.d_height, 1, format, GL_UNSIGNED_BYTE, image.d_pixels.get());
+    }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    // the mips add a third, drivers usually pad RGB to four bytes per texel
+    const size_t texelBytes = i_first.d_channels == 3 ? 4 : static_cast<size_t>(i_first.d_channels);
+    d_gpuBytes = static_cast<size_t>(i_first.d_width) * i_first.d_height * texelBytes * i_images.size() * 4 / 3;
+}
+
+void utils::TextureArray::upload(std::span<const utils::TextureImage* const> i_images, const utils::CompressedImage& i_first)
+{
+    const auto format = utils::getCompressedGLFormat(i_first.d_format);
+    const auto layersCount = static_cast<GLsizei>(i_images.size());
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(i_first.d_mips.size()) - 1);
+    for (size_t level = 0; level < i_first.d_mips.size(); ++level)
+    {
+        const auto& mip = i_first.d_mips[level];
+        glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), format, mip.d_width, mip.d_height, layersCount, 0,
+                               static_cast<GLsizei>(mip.d_size * i_images.size()), nullptr);
+        for (GLsizei layer = 0; layer < layersCount; ++layer)
+        {
+            const auto& image = std::get<utils::CompressedImage>(*i_images[layer]);
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), 0, 0, layer, mip.d_width, mip.d_height, 1, format,
+                                      static_cast<GLsizei>(mip.d_size), image.d_data.data() + image.d_mips[level].d_offset);
+        }
+    }
+    d_gpuBytes = i_first.d_data.size() * i_images.size();
+}
+
+void utils::TextureArray::activate(GLenum i_texUnit) const
+{
+    utils::GLStateCache::getInstance().bindTexture(i_texUnit - GL_TEXTURE0, GL_TEXTURE_2D_ARRAY, d_texId.get());
+}
+
+GLuint utils::TextureArray::getId() const
+{
+    return d_texId.get();
+}
+
+size_t utils::TextureArray::getLayersCount() const
+{
+    return d_layersCount;
+}
+
+size_t utils::TextureArray::getGpuBytes() const
+{
+    return d_gpuBytes;
+}
+
+size_t utils::TextureArray::getMaxLayersCount()
+{
+    // at least 256 in GL 3.3, the query is done once
+    static const size_t maxLayersCount = []()
+    {
+        GLint layersCount = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &layersCount);
+        return static_cast<size_t>(std::max(layersCount, 1));
+    }();
+    return maxLayersCount;
+}
@@ -0,0 +1,202 @@
+#include "TextureCache.hpp"
+
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+static constexpr std::string_view CACHE_DIR = "cache/textures";
+// bumped whenever the encoder output changes, it is part of the key and stored in the header
+static constexpr std::uint32_t ENCODER_VERSION = 1;
+
+constexpr std::uint32_t makeFourCC(const char (&i_code)[5])
+{
+    return static_cast<std::uint32_t>(static_cast<std::uint8_t>(i_code[0])) | static_cast<std::uint32_t>(static_cast<std::uint8_t>(i_code[1])) << 8 |
+           static_cast<std::uint32_t>(static_cast<std::uint8_t>(i_code[2])) << 16 | static_cast<std::uint32_t>(static_cast<std::uint8_t>(i_code[3])) << 24;
+}
+
+static constexpr std::uint32_t DDS_MAGIC = makeFourCC("DDS ");
+static constexpr std::uint32_t CACHE_TAG = makeFourCC("LOGL");
+
+// DDS_HEADER and DDS_PIXELFORMAT, see the DirectDraw Surface documentation
+struct DdsPixelFormat
+{
+    std::uint32_t d_size;
+    std::uint32_t d_flags;
+    std::uint32_t d_fourCC;
+    std::uint32_t d_rgbBitCount;
+    std::array<std::uint32_t, 4> d_masks;
+};
+
+struct DdsHeader
+{
+    std::uint32_t d_size;
+    std::uint32_t d_flags;
+    std::uint32_t d_height;
+    std::uint32_t d_width;
+    std::uint32_t d_pitchOrLinearSize;
+    std::uint32_t d_depth;
+    std::uint32_t d_mipMapCount;
+    std::array<std::uint32_t, 11> d_reserved1; // [0] CACHE_TAG, [1] ENCODER_VERSION
+    DdsPixelFormat d_pixelFormat;
+    std::uint32_t d_caps;
+    std::uint32_t d_caps2;
+    std::uint32_t d_caps3;
+    std::uint32_t d_caps4;
+    std::uint32_t d_reserved2;
+};
+static_assert(sizeof(DdsPixelFormat) == 32);
+static_assert(sizeof(DdsHeader) == 124);
+
+static constexpr std::uint32_t DDSD_CAPS = 0x1;
+static constexpr std::uint32_t DDSD_HEIGHT = 0x2;
+static constexpr std::uint32_t DDSD_WIDTH = 0x4;
+static constexpr std::uint32_t DDSD_PIXELFORMAT = 0x1000;
+static constexpr std::uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+static constexpr std::uint32_t DDSD_LINEARSIZE = 0x80000;
+static constexpr std::uint32_t DDPF_FOURCC = 0x4;
+static constexpr std::uint32_t DDSCAPS_COMPLEX = 0x8;
+static constexpr std::uint32_t DDSCAPS_TEXTURE = 0x1000;
+static constexpr std::uint32_t DDSCAPS_MIPMAP = 0x400000;
+
+struct FormatCode
+{
+    utils::BlockFormat d_format;
+    std::uint32_t d_fourCC;
+};
+
+static constexpr std::array<FormatCode, 4> FORMAT_CODES = { {
+    { utils::BlockFormat::BC1, makeFourCC("DXT1") },
+    { utils::BlockFormat::BC3, makeFourCC("DXT5") },
+    { utils::BlockFormat::BC4, makeFourCC("ATI1") },
+    { utils::BlockFormat::BC5, makeFourCC("ATI2") },
+} };
+}
+
+utils::TextureCache::TextureCache(const std::filesystem::path& i_sourcePath)
+{
+    // identical content gives the same entry whatever the file is called
+    const utils::MappedFile source(i_sourcePath);
+    d_sourceHash = utils::fnv1a(&ENCODER_VERSION, sizeof(ENCODER_VERSION));
+    d_sourceHash = utils::fnv1a(source.getData(), source.getSize(), d_sourceHash);
+
+    std::ostringstream fileName;
+    fileName << std::hex << std::setw(16) << std::setfill('0') << d_sourceHash << ".dds";
+    d_cachePath = std::filesystem::path(CACHE_DIR) / fileName.str();
+}
+
+std::optional<utils::CompressedImage> utils::TextureCache::load() const
+{
+    std::error_code ec;
+    if (!std::filesystem::exists(d_cachePath, ec))
+        return std::nullopt;
+
+    try
+    {
+        const utils::MappedFile file(d_cachePath);
+        if (file.getSize() < sizeof(DDS_MAGIC) + sizeof(DdsHeader))
+            return std::nullopt;
+
+        std::uint32_t magic = 0;
+        DdsHeader header;
+        std::memcpy(&magic, file.getData(), sizeof(magic));
+        std::memcpy(&header, file.getData() + sizeof(magic), sizeof(header));
+        if (magic != DDS_MAGIC || header.d_size != sizeof(DdsHeader) || header.d_reserved1[0] != CACHE_TAG || header.d_reserved1[1] != ENCODER_VERSION ||
+            header.d_mipMapCount == 0 || header.d_mipMapCount > 32)
+        {
+            return std::nullopt;
+        }
+
+        const auto formatCode = std::find_if(FORMAT_CODES.begin(), FORMAT_CODES.end(), [&header](const FormatCode& i_code)
+        {
+            return i_code.d_fourCC == header.d_pixelFormat.d_fourCC;
+        });
+        if (formatCode == FORMAT_CODES.end())
+            return std::nullopt;
+
+        utils::CompressedImage image;
+        image.d_format = formatCode->d_format;
+        int width = static_cast<int>(header.d_width);
+        int height = static_cast<int>(header.d_height);
+        size_t offset = 0;
+        for (std::uint32_t i = 0; i < header.d_mipMapCount; ++i)
+        {
+            const size_t size = utils::getCompressedSize(image.d_format, width, height);
+            image.d_mips.push_back({ width, height, offset, size });
+            offset += size;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+
+        const size_t dataOffset = sizeof(DDS_MAGIC) + sizeof(DdsHeader);
+        if (file.getSize() != dataOffset + offset)
+            return std::nullopt;
+
+        image.d_data.assign(file.getData() + dataOffset, file.getData() + dataOffset + offset);
+        return image;
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Ignoring texture cache " << d_cachePath << ": " << e.what() << '\n';
+        return std::nullopt;
+    }
+}
+
+void utils::TextureCache::store(const utils::CompressedImage& i_image) const
+{
+    if (i_image.d_mips.empty())
+        return;
+
+    std::error_code ec;
+    std::filesystem::create_directories(d_cachePath.parent_path(), ec);
+    if (ec)
+    {
+        std::cout << "Failed to create texture cache directory: " << ec.message() << '\n';
+        return;
+    }
+
+    const auto formatCode = std::find_if(FORMAT_CODES.begin(), FORMAT_CODES.end(), [&i_image](const FormatCode& i_code)
+    {
+        return i_code.d_format == i_image.d_format;
+    });
+
+    DdsHeader header{};
+    header.d_size = sizeof(DdsHeader);
+    header.d_flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    header.d_height = static_cast<std::uint32_t>(i_image.d_mips.front().d_height);
+    header.d_width = static_cast<std::uint32_t>(i_image.d_mips.front().d_width);
+    header.d_pitchOrLinearSize = static_cast<std::uint32_t>(i_image.d_mips.front().d_size);
+    header.d_mipMapCount = static_cast<std::uint32_t>(i_image.d_mips.size());
+    header.d_reserved1[0] = CACHE_TAG;
+    header.d_reserved1[1] = ENCODER_VERSION;
+    header.d_pixelFormat.d_size = sizeof(DdsPixelFormat);
+    header.d_pixelFormat.d_flags = DDPF_FOURCC;
+    header.d_pixelFormat.d_fourCC = formatCode->d_fourCC;
+    header.d_caps = DDSCAPS_TEXTURE | DDSCAPS_MIPMAP | DDSCAPS_COMPLEX;
+
+    // write to a temporary file first, so a crash never leaves a half-written cache behind;
+    // its name is unique, two models may compress the same image at the same time
+    const auto tmpPath = utils::getTemporaryPath(d_cachePath);
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(i_image.d_data.data()), static_cast<std::streamsize>(i_image.d_data.size()));
+
+        if (!file)
+        {
+            std::cout << "Failed to write texture cache: " << tmpPath << '\n';
+            return;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, d_cachePath, ec);
+}
@@ -0,0 +1,431 @@
+#include "TextureCompression.hpp"
+
+#include "Texture.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+// pixels of one 4x4 block, always RGBA
+using BlockPixels = std::array<std::array<std::uint8_t, 4>, 16>;
+
+struct Color565
+{
+    std::uint16_t d_packed;
+    std::array<int, 3> d_rgb; // expanded back to 8 bits, what the GPU interpolates
+};
+
+Color565 quantize565(float i_r, float i_g, float i_b)
+{
+    const int r = std::clamp(static_cast<int>(std::lround(i_r * 31.0f / 255.0f)), 0, 31);
+    const int g = std::clamp(static_cast<int>(std::lround(i_g * 63.0f / 255.0f)), 0, 63);
+    const int b = std::clamp(static_cast<int>(std::lround(i_b * 31.0f / 255.0f)), 0, 31);
+    return { static_cast<std::uint16_t>((r << 11) | (g << 5) | b), { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) } };
+}
+
+void writeLittleEndian(std::byte* o_data, std::uint64_t i_value, size_t i_bytes)
+{
+    for (size_t i = 0; i < i_bytes; ++i)
+        o_data[i] = static_cast<std::byte>((i_value >> (8 * i)) & 0xff);
+}
+
+// picks the 2-bit index of the closest palette entry for every pixel, returns the squared error
+int assignColorIndices(const BlockPixels& i_pixels, const Color565& i_color0, const Color565& i_color1, std::array<std::uint8_t, 16>& o_indices)
+{
+    std::array<std::array<int, 3>, 4> palette;
+    palette[0] = i_color0.d_rgb;
+    palette[1] = i_color1.d_rgb;
+    for (int c = 0; c < 3; ++c)
+    {
+        palette[2][c] = (2 * i_color0.d_rgb[c] + i_color1.d_rgb[c]) / 3;
+        palette[3][c] = (i_color0.d_rgb[c] + 2 * i_color1.d_rgb[c]) / 3;
+    }
+
+    int error = 0;
+    for (size_t i = 0; i < 16; ++i)
+    {
+        int bestError = std::numeric_limits<int>::max();
+        for (std::uint8_t j = 0; j < 4; ++j)
+        {
+            int pixelError = 0;
+            for (int c = 0; c < 3; ++c)
+            {
+                const int difference = i_pixels[i][c] - palette[j][c];
+                pixelError += difference * difference;
+            }
+            if (pixelError < bestError)
+            {
+                bestError = pixelError;
+                o_indices[i] = j;
+            }
+        }
+        error += bestError;
+    }
+    return error;
+}
+
+// least squares endpoints for the given indices, false if all pixels use the same weight
+bool fitEndpoints(const BlockPixels& i_pixels, const std::array<std::uint8_t, 16>& i_indices, std::array<float, 3>& o_color0, std::array<float, 3>& o_color1)
+{
+    static constexpr std::array<float, 4> WEIGHTS = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+    float alpha2 = 0.0f;
+    float beta2 = 0.0f;
+    float alphaBeta = 0.0f;
+    std::array<float, 3> alphaX = {};
+    std::array<float, 3> betaX = {};
+    for (size_t i = 0; i < 16; ++i)
+    {
+        const float alpha = WEIGHTS[i_indices[i]];
+        const float beta = 1.0f - alpha;
+        alpha2 += alpha * alpha;
+        beta2 += beta * beta;
+        alphaBeta += alpha * beta;
+        for (int c = 0; c < 3; ++c)
+        {
+            alphaX[c] += alpha * i_pixels[i][c];
+            betaX[c] += beta * i_pixels[i][c];
+        }
+    }
+
+    const float determinant = alpha2 * beta2 - alphaBeta * alphaBeta;
+    if (std::abs(determinant) < 1e-6f)
+        return false;
+
+    for (int c = 0; c < 3; ++c)
+    {
+        o_color0[c] = std::clamp((alphaX[c] * beta2 - betaX[c] * alphaBeta) / determinant, 0.0f, 255.0f);
+        o_color1[c] = std::clamp((betaX[c] * alpha2 - alphaX[c] * alphaBeta) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+// BC1 color block in the 4-color mode: endpoints from the principal axis of the colors, then refined once by least squares
+void encodeColorBlock(const BlockPixels& i_pixels, std::byte* o_block)
+{
+    std::array<float, 3> mean = {};
+    for (const auto& pixel : i_pixels)
+    {
+        for (int c = 0; c < 3; ++c)
+            mean[c] += pixel[c] / 16.0f;
+    }
+
+    // covariance: rr, rg, rb, gg, gb, bb
+    std::array<float, 6> covariance = {};
+    for (const auto& pixel : i_pixels)
+    {
+        const float r = pixel[0] - mean[0];
+        const float g = pixel[1] - mean[1];
+        const float b = pixel[2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    // power iteration, converges in a few steps for the dominant axis; starts from the column of the channel varying the most
+    std::array<float, 3> axis = { covariance[0], covariance[1], covariance[2] };
+    if (covariance[3] > covariance[0] && covariance[3] >= covariance[5])
+        axis = { covariance[1], covariance[3], covariance[4] };
+    else if (covariance[5] > covariance[0] && covariance[5] > covariance[3])
+        axis = { covariance[2], covariance[4], covariance[5] };
+    for (int iteration = 0; iteration < 4; ++iteration)
+    {
+        const std::array<float, 3> next = {
+            covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+            covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+            covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2],
+        };
+        const float length = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]) });
+        if (length < 1e-6f)
+            break;
+        for (int c = 0; c < 3; ++c)
+            axis[c] = next[c] / length;
+    }
+
+    float minProjection = std::numeric_limits<float>::max();
+    float maxProjection = std::numeric_limits<float>::lowest();
+    for (const auto& pixel : i_pixels)
+    {
+        const float projection = (pixel[0] - mean[0]) * axis[0] + (pixel[1] - mean[1]) * axis[1] + (pixel[2] - mean[2]) * axis[2];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    const float axisLength2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    std::array<float, 3> color0;
+    std::array<float, 3> color1;
+    for (int c = 0; c < 3; ++c)
+    {
+        color0[c] = mean[c] + axis[c] * maxProjection / std::max(axisLength2, 1e-6f);
+        color1[c] = mean[c] + axis[c] * minProjection / std::max(axisLength2, 1e-6f);
+    }
+
+    Color565 endpoint0 = quantize565(color0[0], color0[1], color0[2]);
+    Color565 endpoint1 = quantize565(color1[0], color1[1], color1[2]);
+    std::array<std::uint8_t, 16> indices;
+    int error = assignColorIndices(i_pixels, endpoint0, endpoint1, indices);
+
+    std::array<std::uint8_t, 16> refinedIndices;
+    if (error > 0 && fitEndpoints(i_pixels, indices, color0, color1))
+    {
+        const Color565 refined0 = quantize565(color0[0], color0[1], color0[2]);
+        const Color565 refined1 = quantize565(color1[0], color1[1], color1[2]);
+        const int refinedError = assignColorIndices(i_pixels, refined0, refined1, refinedIndices);
+        if (refinedError < error)
+        {
+            endpoint0 = refined0;
+            endpoint1 = refined1;
+            indices = refinedIndices;
+        }
+    }
+
+    // color0 > color1 selects the 4-color mode, swapping the endpoints swaps the index pairs 0/1 and 2/3
+    if (endpoint0.d_packed < endpoint1.d_packed)
+    {
+        std::swap(endpoint0, endpoint1);
+        for (auto& index : indices)
+            index ^= 1;
+    }
+    else if (endpoint0.d_packed == endpoint1.d_packed)
+    {
+        indices.fill(0);
+    }
+
+    std::uint32_t packedIndices = 0;
+    for (size_t i = 0; i < 16; ++i)
+        packedIndices |= static_cast<std::uint32_t>(indices[i]) << (2 * i);
+
+    writeLittleEndian(o_block, endpoint0.d_packed, 2);
+    writeLittleEndian(o_block + 2, endpoint1.d_packed, 2);
+    writeLittleEndian(o_block + 4, packedIndices, 4);
+}
+
+// BC4 block of one channel in the 8-value mode: the endpoints are the extremes, 6 values are interpolated between them
+void encodeChannelBlock(const BlockPixels& i_pixels, size_t i_channel, std::byte* o_block)
+{
+    int minValue = 255;
+    int maxValue = 0;
+    for (const auto& pixel : i_pixels)
+    {
+        minValue = std::min<int>(minValue, pixel[i_channel]);
+        maxValue = std::max<int>(maxValue, pixel[i_channel]);
+    }
+
+    std::uint64_t packedIndices = 0;
+    if (maxValue > minValue)
+    {
+        // position 0 is value0 (max), 7 is value1 (min), position k in between is stored as index k + 1
+        static constexpr std::array<std::uint64_t, 8> POSITION_TO_INDEX = { 0, 2, 3, 4, 5, 6, 7, 1 };
+        const int range = maxValue - minValue;
+        for (size_t i = 0; i < 16; ++i)
+        {
+            const int position = ((maxValue - i_pixels[i][i_channel]) * 7 + range / 2) / range;
+            packedIndices |= POSITION_TO_INDEX[position] << (3 * i);
+        }
+    }
+
+    o_block[0] = static_cast<std::byte>(maxValue);
+    o_block[1] = static_cast<std::byte>(minValue);
+    writeLittleEndian(o_block + 2, packedIndices, 6);
+}
+
+void encodeBlock(const BlockPixels& i_pixels, utils::BlockFormat i_format, std::byte* o_block)
+{
+    switch (i_format)
+    {
+    case utils::BlockFormat::BC1:
+        encodeColorBlock(i_pixels, o_block);
+        break;
+    case utils::BlockFormat::BC3:
+        encodeChannelBlock(i_pixels, 3, o_block);
+        encodeColorBlock(i_pixels, o_block + 8);
+        break;
+    case utils::BlockFormat::BC4:
+        encodeChannelBlock(i_pixels, 0, o_block);
+        break;
+    case utils::BlockFormat::BC5:
+        encodeChannelBlock(i_pixels, 0, o_block);
+        encodeChannelBlock(i_pixels, 1, o_block + 8);
+        break;
+    }
+}
+
+// RGBA pixels of one mip level, the channels the source doesn't have are 0 (alpha 255)
+struct MipLevel
+{
+    int d_width = 0;
+    int d_height = 0;
+    std::vector<std::uint8_t> d_pixels;
+};
+
+MipLevel toRgba(const utils::ImageData& i_image)
+{
+    MipLevel level{ i_image.d_width, i_image.d_height, {} };
+    level.d_pixels.resize(static_cast<size_t>(level.d_width) * level.d_height * 4);
+
+    // stb gives grey / grey alpha for one and two channels, they are stored as R / RG
+    const auto* source = i_image.d_pixels.get();
+    const size_t channels = static_cast<size_t>(i_image.d_channels);
+    for (size_t i = 0; i < static_cast<size_t>(level.d_width) * level.d_height; ++i)
+    {
+        auto* pixel = &level.d_pixels[4 * i];
+        pixel[3] = 255;
+        for (size_t c = 0; c < std::min<size_t>(channels, 4); ++c)
+            pixel[c] = source[channels * i + c];
+    }
+    return level;
+}
+
+MipLevel downsample(const MipLevel& i_level)
+{
+    MipLevel level{ std::max(1, i_level.d_width / 2), std::max(1, i_level.d_height / 2), {} };
+    level.d_pixels.resize(static_cast<size_t>(level.d_width) * level.d_height * 4);
+
+    for (int y = 0; y < level.d_height; ++y)
+    {
+        const int y0 = std::min(2 * y, i_level.d_height - 1);
+        const int y1 = std::min(2 * y + 1, i_level.d_height - 1);
+        for (int x = 0; x < level.d_width; ++x)
+        {
+            const int x0 = std::min(2 * x, i_level.d_width - 1);
+            const int x1 = std::min(2 * x + 1, i_level.d_width - 1);
+            for (int c = 0; c < 4; ++c)
+            {
+                const auto sample = [&](int i_x, int i_y) { return i_level.d_pixels[(static_cast<size_t>(i_y) * i_level.d_width + i_x) * 4 + c]; };
+                const int sum = sample(x0, y0) + sample(x1, y0) + sample(x0, y1) + sample(x1, y1);
+                level.d_pixels[(static_cast<size_t>(y) * level.d_width + x) * 4 + c] = static_cast<std::uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+    return level;
+}
+
+void encodeLevel(const MipLevel& i_level, utils::BlockFormat i_format, std::byte* o_data)
+{
+    const int blocksX = (i_level.d_width + 3) / 4;
+    const int blocksY = (i_level.d_height + 3) / 4;
+    const size_t blockBytes = utils::getBlockBytes(i_format);
+
+    utils::ThreadPool::getInstance().parallelFor(static_cast<size_t>(blocksY), [&](size_t i_blockY)
+    {
+        BlockPixels pixels;
+        for (int blockX = 0; blockX < blocksX; ++blockX)
+        {
+            // blocks hanging over the edge repeat the last row / column
+            for (int y = 0; y < 4; ++y)
+            {
+                const int sourceY = std::min(static_cast<int>(i_blockY) * 4 + y, i_level.d_height - 1);
+                for (int x = 0; x < 4; ++x)
+                {
+                    const int sourceX = std::min(blockX * 4 + x, i_level.d_width - 1);
+                    std::memcpy(pixels[4 * y + x].data(), &i_level.d_pixels[(static_cast<size_t>(sourceY) * i_level.d_width + sourceX) * 4], 4);
+                }
+            }
+
+            encodeBlock(pixels, i_format, o_data + (i_blockY * blocksX + blockX) * blockBytes);
+        }
+    });
+}
+}
+
+const char* utils::getBlockFormatName(utils::BlockFormat i_format)
+{
+    switch (i_format)
+    {
+    case utils::BlockFormat::BC1:
+        return "BC1";
+    case utils::BlockFormat::BC3:
+        return "BC3";
+    case utils::BlockFormat::BC4:
+        return "BC4";
+    case utils::BlockFormat::BC5:
+        return "BC5";
+    }
+    return "unknown";
+}
+
+std::size_t utils::getBlockBytes(utils::BlockFormat i_format)
+{
+    return i_format == utils::BlockFormat::BC1 || i_format == utils::BlockFormat::BC4 ? 8 : 16;
+}
+
+std::size_t utils::getCompressedSize(utils::BlockFormat i_format, int i_width, int i_height)
+{
+    return static_cast<std::size_t>((i_width + 3) / 4) * ((i_height + 3) / 4) * getBlockBytes(i_format);
+}
+
+GLenum utils::getCompressedGLFormat(utils::BlockFormat i_format)
+{
+    switch (i_format)
+    {
+    case utils::BlockFormat::BC1:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case utils::BlockFormat::BC3:
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case utils::BlockFormat::BC4:
+        return GL_COMPRESSED_RED_RGTC1;
+    case utils::BlockFormat::BC5:
+        return GL_COMPRESSED_RG_RGTC2;
+    }
+    return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+bool utils::isBlockFormatSupported(utils::BlockFormat i_format)
+{
+    if (i_format == utils::BlockFormat::BC1 || i_format == utils::BlockFormat::BC3)
+        return GLAD_GL_EXT_texture_compression_s3tc != 0;
+    return true;
+}
+
+utils::BlockFormat utils::chooseBlockFormat(const utils::ImageData& i_image)
+{
+    switch (i_image.d_channels)
+    {
+    case 1:
+        return utils::BlockFormat::BC4;
+    case 2:
+        return utils::BlockFormat::BC5;
+    case 3:
+        return utils::BlockFormat::BC1;
+    default:
+        break;
+    }
+
+    const auto* pixels = i_image.d_pixels.get();
+    const size_t pixelsCount = static_cast<size_t>(i_image.d_width) * i_image.d_height;
+    for (size_t i = 0; i < pixelsCount; ++i)
+    {
+        if (pixels[4 * i + 3] != 255)
+            return utils::BlockFormat::BC3;
+    }
+    return utils::BlockFormat::BC1;
+}
+
+utils::CompressedImage utils::compressImage(const utils::ImageData& i_image, utils::BlockFormat i_format)
+{
+    utils::CompressedImage image;
+    image.d_format = i_format;
+
+    MipLevel level = toRgba(i_image);
+    while (true)
+    {
+        const utils::CompressedMip mip{ level.d_width, level.d_height, image.d_data.size(), getCompressedSize(i_format, level.d_width, level.d_height) };
+        image.d_data.resize(mip.d_offset + mip.d_size);
+        encodeLevel(level, i_format, image.d_data.data() + mip.d_offset);
+        image.d_mips.push_back(mip);
+
+        if (level.d_width == 1 && level.d_height == 1)
+            break;
+        level = downsample(level);
+    }
+
+    return image;
+}
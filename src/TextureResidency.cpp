@@ -0,0 +1,149 @@
+#include "TextureResidency.hpp"
+
+#include "TextureStreamer.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+utils::TextureResidency::TextureResidency(std::size_t i_budgetBytes, utils::TextureStreamer* i_streamer /* = nullptr */,
+                                          std::uint64_t i_minIdleFrames /* = 60 */)
+    : d_budgetBytes(i_budgetBytes), d_streamer(i_streamer), d_minIdleFrames(i_minIdleFrames), d_frame(utils::Texture::getCurrentFrame())
+{
+    d_stats.d_budgetBytes = d_budgetBytes;
+}
+
+void utils::TextureResidency::track(const std::shared_ptr<utils::Texture>& i_texture, const std::string& i_path, bool i_compress)
+{
+    // the address of a freed texture can be reused by a new one
+    std::erase_if(d_textures, [](const auto& i_entry) { return i_entry.second.d_texture.expired(); });
+
+    auto [it, isInserted] = d_textures.try_emplace(i_texture.get());
+    if (!isInserted)
+        return;
+
+    it->second.d_texture = i_texture;
+    it->second.d_path = i_path;
+    it->second.d_compress = i_compress;
+}
+
+void utils::TextureResidency::update()
+{
+    std::erase_if(d_textures, [](const auto& i_entry) { return i_entry.second.d_texture.expired(); });
+
+    finishReloads();
+    startReloads();
+    enforceBudget();
+
+    d_stats.d_trackedTextures = d_textures.size();
+    d_stats.d_residentBytes = 0;
+    for (const auto& [key, tracked] : d_textures)
+        d_stats.d_residentBytes += key->getGpuBytes();
+
+    utils::Texture::setCurrentFrame(++d_frame);
+}
+
+void utils::TextureResidency::finishReloads()
+{
+    for (auto& [key, tracked] : d_textures)
+    {
+        if (!tracked.d_reload.valid() || tracked.d_reload.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            continue;
+
+        // a failed reload is not retried, the texture keeps sampling its remaining mips
+        tracked.d_isReduced = false;
+        try
+        {
+            auto image = tracked.d_reload.get();
+            const auto texture = tracked.d_texture.lock();
+            auto* compressed = std::get_if<utils::CompressedImage>(&image);
+            if (d_streamer && compressed)
+                d_streamer->stream(texture, std::make_shared<const utils::CompressedImage>(std::move(*compressed)));
+            else
+                texture->reload(image);
+            ++d_stats.d_reloads;
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "Failed to reload texture " << tracked.d_path << ": " << e.what() << '\n';
+        }
+    }
+}
+
+void utils::TextureResidency::startReloads()
+{
+    for (auto& [key, tracked] : d_textures)
+    {
+        // only reduced textures bound during the frame that just ended
+        if (!tracked.d_isReduced || tracked.d_reload.valid() || key->getLastUsedFrame() < d_frame)
+            continue;
+
+        tracked.d_reload = utils::ThreadPool::getInstance().submit([path = tracked.d_path, compress = tracked.d_compress]()
+        {
+            return utils::loadTextureImage(path, compress);
+        });
+    }
+}
+
+void utils::TextureResidency::enforceBudget()
+{
+    size_t residentBytes = 0;
+    for (const auto& [key, tracked] : d_textures)
+        residentBytes += key->getGpuBytes();
+    if (residentBytes <= d_budgetBytes)
+        return;
+
+    // least recently used first, textures on screen and those being reloaded are left alone
+    std::vector<TrackedTexture*> candidates;
+    for (auto& [key, tracked] : d_textures)
+    {
+        if (d_frame - key->getLastUsedFrame() >= d_minIdleFrames && !tracked.d_reload.valid())
+            candidates.push_back(&tracked);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const TrackedTexture* i_lhs, const TrackedTexture* i_rhs)
+    {
+        return i_lhs->d_texture.lock()->getLastUsedFrame() < i_rhs->d_texture.lock()->getLastUsedFrame();
+    });
+
+    // halving keeps a texture usable from a distance, dropping all but the smallest mip is the last resort
+    for (const bool isEviction : { false, true })
+    {
+        for (auto* tracked : candidates)
+        {
+            if (residentBytes <= d_budgetBytes)
+                return;
+
+            const auto texture = tracked->d_texture.lock();
+            const size_t lastLevel = texture->getLevelsCount() - 1;
+            const size_t level = isEviction ? lastLevel : std::min(texture->getResidentLevel() + 1, lastLevel);
+            if (level <= texture->getResidentLevel())
+                continue;
+
+            const size_t bytes = texture->getGpuBytes();
+            texture->dropLevels(level);
+            residentBytes -= bytes - texture->getGpuBytes();
+            tracked->d_isReduced = true;
+            ++(isEviction ? d_stats.d_evictions : d_stats.d_reductions);
+        }
+    }
+}
+
+void utils::TextureResidency::setBudget(std::size_t i_budgetBytes)
+{
+    d_budgetBytes = i_budgetBytes;
+    d_stats.d_budgetBytes = i_budgetBytes;
+}
+
+const utils::TextureResidencyStats& utils::TextureResidency::getStats() const
+{
+    return d_stats;
+}
+
+void utils::TextureResidency::resetStats()
+{
+    d_stats.d_reductions = 0;
+    d_stats.d_evictions = 0;
+    d_stats.d_reloads = 0;
+}
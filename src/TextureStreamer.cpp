@@ -0,0 +1,154 @@
+#include "TextureStreamer.hpp"
+
+#include "GLStateCache.hpp"
+#include "Texture.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+utils::TextureStreamer::TextureStreamer(int i_residentSize /* = 64 */, std::size_t i_buffersCount /* = 3 */)
+    : d_residentSize(i_residentSize), d_buffers(std::max<std::size_t>(i_buffersCount, 1))
+{
+    // storage is allocated on first use, sized to the largest mip copied through each buffer
+    for (auto& staging : d_buffers)
+        staging.d_buffer = utils::BufferHandle::create();
+}
+
+utils::TextureStreamer::~TextureStreamer()
+{
+    for (auto& staging : d_buffers)
+    {
+        if (staging.d_fence)
+            glDeleteSync(staging.d_fence);
+    }
+}
+
+std::shared_ptr<utils::Texture> utils::TextureStreamer::create(std::shared_ptr<const utils::CompressedImage> i_image, aiTextureType i_textureType,
+                                                               GLenum i_wrapParam /* = GL_REPEAT */)
+{
+    size_t firstLevel = 0;
+    while (firstLevel + 1 < i_image->d_mips.size() &&
+           std::max(i_image->d_mips[firstLevel].d_width, i_image->d_mips[firstLevel].d_height) > d_residentSize)
+    {
+        ++firstLevel;
+    }
+
+    auto texture = std::make_shared<utils::Texture>(*i_image, firstLevel, i_textureType, i_wrapParam);
+    stream(texture, std::move(i_image));
+    return texture;
+}
+
+void utils::TextureStreamer::stream(const std::shared_ptr<utils::Texture>& i_texture, std::shared_ptr<const utils::CompressedImage> i_image)
+{
+    if (i_texture->getResidentLevel() == 0)
+        return;
+
+    const auto pending = std::find_if(d_pending.begin(), d_pending.end(), [&i_texture](const PendingTexture& i_pending)
+    {
+        return i_pending.d_texture.lock() == i_texture;
+    });
+    if (pending != d_pending.end())
+        pending->d_image = std::move(i_image);
+    else
+        d_pending.push_back({ i_texture, std::move(i_image) });
+
+    d_stats.d_pendingTextures = d_pending.size();
+}
+
+std::size_t utils::TextureStreamer::process(std::size_t i_byteBudget)
+{
+    // textures of destroyed models are forgotten with their images, as are those completed by a reload
+    std::erase_if(d_pending, [](const PendingTexture& i_pending)
+    {
+        const auto texture = i_pending.d_texture.lock();
+        return !texture || texture->getResidentLevel() == 0;
+    });
+
+    auto& glState = utils::GLStateCache::getInstance();
+    std::size_t uploadedBytes = 0;
+    while (!d_pending.empty())
+    {
+        // the smallest missing mip is the coarsest, so all textures sharpen together instead of one after the other
+        const auto pending = std::min_element(d_pending.begin(), d_pending.end(), [](const PendingTexture& i_lhs, const PendingTexture& i_rhs)
+        {
+            return i_lhs.d_image->d_mips[i_lhs.d_texture.lock()->getResidentLevel() - 1].d_size <
+                   i_rhs.d_image->d_mips[i_rhs.d_texture.lock()->getResidentLevel() - 1].d_size;
+        });
+        const auto texture = pending->d_texture.lock();
+        const size_t level = texture->getResidentLevel() - 1;
+        const auto& mip = pending->d_image->d_mips[level];
+        if (uploadedBytes > 0 && uploadedBytes + mip.d_size > i_byteBudget)
+            break;
+
+        auto& staging = d_buffers[d_nextBuffer];
+        if (!isAvailable(staging))
+        {
+            ++d_stats.d_stalls;
+            break;
+        }
+
+        glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.d_buffer.get());
+        if (mip.d_size > staging.d_capacity)
+        {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(mip.d_size), nullptr, GL_STREAM_DRAW);
+            staging.d_capacity = mip.d_size;
+        }
+
+        // the fence already guarantees the GPU is done with the buffer, the driver doesn't have to synchronize again
+        void* data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(mip.d_size),
+                                      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!data)
+            break;
+        std::memcpy(data, pending->d_image->d_data.data() + mip.d_offset, mip.d_size);
+        // the contents can be lost, e.g. on a display mode change, the level is simply copied again next frame
+        if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+            break;
+
+        texture->uploadStreamedLevel(*pending->d_image, level);
+        staging.d_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        d_nextBuffer = (d_nextBuffer + 1) % d_buffers.size();
+
+        uploadedBytes += mip.d_size;
+        ++d_stats.d_uploadedLevels;
+        if (level == 0)
+            d_pending.erase(pending);
+    }
+
+    // the other uploads read client memory
+    glState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    d_stats.d_uploadedBytes += uploadedBytes;
+    d_stats.d_pendingTextures = d_pending.size();
+    return uploadedBytes;
+}
+
+bool utils::TextureStreamer::isAvailable(StagingBuffer& io_buffer) const
+{
+    if (!io_buffer.d_fence)
+        return true;
+
+    // the flush makes sure the fence is submitted and eventually signals, waiting is never done
+    if (glClientWaitSync(io_buffer.d_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+        return false;
+
+    glDeleteSync(io_buffer.d_fence);
+    io_buffer.d_fence = nullptr;
+    return true;
+}
+
+bool utils::TextureStreamer::isIdle() const
+{
+    return d_pending.empty();
+}
+
+const utils::TextureStreamerStats& utils::TextureStreamer::getStats() const
+{
+    return d_stats;
+}
+
+void utils::TextureStreamer::resetStats()
+{
+    d_stats.d_uploadedLevels = 0;
+    d_stats.d_uploadedBytes = 0;
+    d_stats.d_stalls = 0;
+}
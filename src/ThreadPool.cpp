@@ -0,0 +1,135 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+namespace
+{
+std::size_t getDefaultWorkersCount()
+{
+    if (const char* workers = std::getenv("LEARNOPENGL_WORKERS"))
+        return static_cast<std::size_t>(std::max(0, std::atoi(workers)));
+
+    // the thread calling parallelFor does its share of the work too
+    const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+}
+
+utils::ThreadPool::ThreadPool(std::size_t i_workersCount)
+{
+    d_workers.reserve(i_workersCount);
+    for (std::size_t i = 0; i < i_workersCount; ++i)
+        d_workers.emplace_back([this]() { workerLoop(); });
+}
+
+utils::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(d_mutex);
+        d_isStopping = true;
+    }
+    d_condition.notify_all();
+
+    for (auto& worker : d_workers)
+        worker.join();
+}
+
+utils::ThreadPool& utils::ThreadPool::getInstance()
+{
+    static ThreadPool pool(getDefaultWorkersCount());
+    return pool;
+}
+
+void utils::ThreadPool::parallelFor(std::size_t i_count, const std::function<void(std::size_t)>& i_func)
+{
+    // helpers may only get scheduled after the caller already finished all the work,
+    // so everything they touch is kept alive by a shared state instead of the caller's stack
+    struct LoopState
+    {
+        std::function<void(std::size_t)> d_func;
+        std::size_t d_count = 0;
+        std::atomic<std::size_t> d_nextIndex = 0;
+        std::size_t d_doneCount = 0;
+        std::exception_ptr d_error;
+        std::mutex d_mutex;
+        std::condition_variable d_condition;
+
+        void run()
+        {
+            for (std::size_t i = d_nextIndex++; i < d_count; i = d_nextIndex++)
+            {
+                std::exception_ptr error;
+                try
+                {
+                    d_func(i);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+
+                std::lock_guard lock(d_mutex);
+                if (error && !d_error)
+                    d_error = error;
+                if (++d_doneCount == d_count)
+                    d_condition.notify_all();
+            }
+        }
+    };
+
+    if (i_count == 0)
+        return;
+
+    auto state = std::make_shared<LoopState>();
+    state->d_func = i_func;
+    state->d_count = i_count;
+
+    const std::size_t helpersCount = std::min(d_workers.size(), i_count - 1);
+    for (std::size_t i = 0; i < helpersCount; ++i)
+        enqueue([state]() { state->run(); });
+
+    // waiting on the items rather than on the helpers keeps nested parallelFor calls from deadlocking
+    state->run();
+    std::unique_lock lock(state->d_mutex);
+    state->d_condition.wait(lock, [&state]() { return state->d_doneCount == state->d_count; });
+
+    if (state->d_error)
+        std::rethrow_exception(state->d_error);
+}
+
+std::size_t utils::ThreadPool::getWorkersCount() const
+{
+    return d_workers.size();
+}
+
+void utils::ThreadPool::enqueue(std::function<void()> i_task)
+{
+    {
+        std::lock_guard lock(d_mutex);
+        d_tasks.push(std::move(i_task));
+    }
+    d_condition.notify_one();
+}
+
+void utils::ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(d_mutex);
+            d_condition.wait(lock, [this]() { return d_isStopping || !d_tasks.empty(); });
+            if (d_isStopping && d_tasks.empty())
+                return;
+
+            task = std::move(d_tasks.front());
+            d_tasks.pop();
+        }
+
+        task();
+    }
+}
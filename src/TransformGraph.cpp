@@ -0,0 +1,133 @@
+#include "TransformGraph.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define UTILS_TRANSFORM_SSE
+#endif
+
+namespace
+{
+// o_result = i_lhs * i_rhs for column-major matrices, o_result may not alias the inputs
+void multiply(const float* i_lhs, const float* i_rhs, float* o_result)
+{
+#if defined(UTILS_TRANSFORM_SSE)
+    const __m128 lhs0 = _mm_loadu_ps(i_lhs);
+    const __m128 lhs1 = _mm_loadu_ps(i_lhs + 4);
+    const __m128 lhs2 = _mm_loadu_ps(i_lhs + 8);
+    const __m128 lhs3 = _mm_loadu_ps(i_lhs + 12);
+
+    for (int column = 0; column < 4; ++column)
+    {
+        const float* rhs = i_rhs + column * 4;
+        __m128 result = _mm_mul_ps(lhs0, _mm_set1_ps(rhs[0]));
+        result = _mm_add_ps(result, _mm_mul_ps(lhs1, _mm_set1_ps(rhs[1])));
+        result = _mm_add_ps(result, _mm_mul_ps(lhs2, _mm_set1_ps(rhs[2])));
+        result = _mm_add_ps(result, _mm_mul_ps(lhs3, _mm_set1_ps(rhs[3])));
+        _mm_storeu_ps(o_result + column * 4, result);
+    }
+#else
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            o_result[column * 4 + row] = i_lhs[row] * i_rhs[column * 4] + i_lhs[4 + row] * i_rhs[column * 4 + 1]
+                                       + i_lhs[8 + row] * i_rhs[column * 4 + 2] + i_lhs[12 + row] * i_rhs[column * 4 + 3];
+        }
+    }
+#endif
+}
+
+// world transforms of a batch of nodes whose parents are already up to date
+void multiplyBatch(std::span<const std::uint32_t> i_nodes, const std::uint32_t* i_parents, const glm::mat4* i_localTransforms, glm::mat4* io_worldTransforms)
+{
+    for (const auto node : i_nodes)
+    {
+        const auto parent = i_parents[node];
+        if (parent == utils::NO_PARENT_NODE)
+            io_worldTransforms[node] = i_localTransforms[node];
+        else
+            multiply(&io_worldTransforms[parent][0][0], &i_localTransforms[node][0][0], &io_worldTransforms[node][0][0]);
+    }
+}
+}
+
+utils::TransformGraph::TransformGraph(std::span<const utils::TransformNode> i_nodes)
+{
+    d_parents.reserve(i_nodes.size());
+    d_localTransforms.reserve(i_nodes.size());
+    d_worldTransforms.reserve(i_nodes.size());
+    d_isDirty.reserve(i_nodes.size());
+
+    for (const auto& node : i_nodes)
+        addNode(node.d_parent, node.d_localTransform);
+}
+
+std::uint32_t utils::TransformGraph::addNode(std::uint32_t i_parent, const glm::mat4& i_localTransform)
+{
+    const auto node = static_cast<std::uint32_t>(d_parents.size());
+    if (i_parent != utils::NO_PARENT_NODE && i_parent >= node)
+        throw std::runtime_error("Transform graph parent has to be added before its children");
+
+    d_parents.push_back(i_parent);
+    d_localTransforms.push_back(i_localTransform);
+    d_worldTransforms.push_back(i_localTransform);
+    d_isDirty.push_back(1);
+    d_firstDirtyNode = std::min(d_firstDirtyNode, node);
+
+    return node;
+}
+
+void utils::TransformGraph::setLocalTransform(std::uint32_t i_node, const glm::mat4& i_localTransform)
+{
+    d_localTransforms[i_node] = i_localTransform;
+    d_isDirty[i_node] = 1;
+    d_firstDirtyNode = std::min(d_firstDirtyNode, i_node);
+}
+
+const glm::mat4& utils::TransformGraph::getLocalTransform(std::uint32_t i_node) const
+{
+    return d_localTransforms[i_node];
+}
+
+std::uint32_t utils::TransformGraph::getParent(std::uint32_t i_node) const
+{
+    return d_parents[i_node];
+}
+
+const glm::mat4& utils::TransformGraph::getWorldTransform(std::uint32_t i_node) const
+{
+    return d_worldTransforms[i_node];
+}
+
+std::size_t utils::TransformGraph::update()
+{
+    const auto nodesCount = static_cast<std::uint32_t>(d_parents.size());
+
+    // parents come first, so one pass pushes the flags down to whole subtrees
+    d_dirtyNodes.clear();
+    for (std::uint32_t node = d_firstDirtyNode; node < nodesCount; ++node)
+    {
+        const auto parent = d_parents[node];
+        if (parent != utils::NO_PARENT_NODE)
+            d_isDirty[node] |= d_isDirty[parent];
+
+        if (d_isDirty[node])
+            d_dirtyNodes.push_back(node);
+    }
+
+    multiplyBatch(d_dirtyNodes, d_parents.data(), d_localTransforms.data(), d_worldTransforms.data());
+
+    for (const auto node : d_dirtyNodes)
+        d_isDirty[node] = 0;
+    d_firstDirtyNode = nodesCount;
+
+    return d_dirtyNodes.size();
+}
+
+std::size_t utils::TransformGraph::size() const
+{
+    return d_parents.size();
+}
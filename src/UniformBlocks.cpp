@@ -0,0 +1,25 @@
+#include "UniformBlocks.hpp"
+
+#include "GLStateCache.hpp"
+
+#include <stdexcept>
+#include <string>
+
+utils::UniformBuffer::UniformBuffer(GLuint i_binding, std::size_t i_size)
+    : d_buffer(utils::BufferHandle::create())
+    , d_size(i_size)
+{
+    auto& glState = utils::GLStateCache::getInstance();
+    glState.bindBuffer(GL_UNIFORM_BUFFER, d_buffer.get());
+    glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(d_size), nullptr, GL_DYNAMIC_DRAW);
+    glState.bindBufferBase(GL_UNIFORM_BUFFER, i_binding, d_buffer.get());
+}
+
+void utils::UniformBuffer::upload(std::span<const std::byte> i_bytes)
+{
+    if (i_bytes.size() > d_size)
+        throw std::runtime_error("Uniform buffer of " + std::to_string(d_size) + " bytes can't take " + std::to_string(i_bytes.size()));
+
+    utils::GLStateCache::getInstance().bindBuffer(GL_UNIFORM_BUFFER, d_buffer.get());
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(i_bytes.size()), i_bytes.data());
+}
@@ -0,0 +1,37 @@
+#include "UploadQueue.hpp"
+
+void utils::UploadQueue::push(std::function<void()> i_task)
+{
+    std::lock_guard lock(d_mutex);
+    d_tasks.push_back(std::move(i_task));
+}
+
+std::size_t utils::UploadQueue::process(std::chrono::microseconds i_budget)
+{
+    const auto deadline = std::chrono::steady_clock::now() + i_budget;
+
+    std::size_t tasksCount = 0;
+    do
+    {
+        std::function<void()> task;
+        {
+            std::lock_guard lock(d_mutex);
+            if (d_tasks.empty())
+                break;
+
+            task = std::move(d_tasks.front());
+            d_tasks.pop_front();
+        }
+
+        task();
+        ++tasksCount;
+    } while (std::chrono::steady_clock::now() < deadline);
+
+    return tasksCount;
+}
+
+bool utils::UploadQueue::isEmpty() const
+{
+    std::lock_guard lock(d_mutex);
+    return d_tasks.empty();
+}
@@ -0,0 +1,149 @@
+#include "VertexFormat.hpp"
+
+#include "Mesh.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+std::uint32_t packNormal(const glm::vec3& i_normal)
+{
+    return glm::packSnorm3x10_1x2(glm::vec4(i_normal, 0.0f));
+}
+
+std::uint32_t packTexCoords(const glm::vec2& i_texCoords)
+{
+    return glm::packHalf2x16(i_texCoords);
+}
+
+std::uint16_t quantize(float i_value, float i_offset, float i_scale)
+{
+    const float normalized = std::clamp((i_value - i_offset) / i_scale, 0.0f, 1.0f);
+    return static_cast<std::uint16_t>(std::lround(normalized * 65535.0f));
+}
+
+template <typename T>
+std::vector<std::byte> asBytes(const std::vector<T>& i_vertices)
+{
+    std::vector<std::byte> bytes(i_vertices.size() * sizeof(T));
+    std::memcpy(bytes.data(), i_vertices.data(), bytes.size());
+    return bytes;
+}
+}
+
+std::size_t utils::getVertexSize(utils::VertexFormat i_format)
+{
+    switch (i_format)
+    {
+    case VertexFormat::Float:
+        return sizeof(utils::Vertex);
+    case VertexFormat::Packed:
+        return sizeof(utils::PackedVertex);
+    case VertexFormat::Quantized:
+        return sizeof(utils::QuantizedVertex);
+    }
+    throw std::runtime_error("Bad vertex format: " + std::to_string(static_cast<int>(i_format)));
+}
+
+std::vector<std::byte> utils::packVertices(std::span<const utils::Vertex> i_vertices, utils::VertexFormat i_format, utils::PositionTransform& o_transform)
+{
+    o_transform = PositionTransform();
+
+    switch (i_format)
+    {
+    case VertexFormat::Float:
+    {
+        std::vector<std::byte> bytes(i_vertices.size_bytes());
+        std::memcpy(bytes.data(), i_vertices.data(), bytes.size());
+        return bytes;
+    }
+    case VertexFormat::Packed:
+    {
+        std::vector<utils::PackedVertex> vertices;
+        vertices.reserve(i_vertices.size());
+        for (const auto& vertex : i_vertices)
+            vertices.push_back({ vertex.d_position, packNormal(vertex.d_normal), packTexCoords(vertex.d_texCoords) });
+        return asBytes(vertices);
+    }
+    case VertexFormat::Quantized:
+    {
+        glm::vec3 minPos(std::numeric_limits<float>::max());
+        glm::vec3 maxPos(std::numeric_limits<float>::lowest());
+        for (const auto& vertex : i_vertices)
+        {
+            minPos = glm::min(minPos, vertex.d_position);
+            maxPos = glm::max(maxPos, vertex.d_position);
+        }
+
+        if (!i_vertices.empty())
+        {
+            o_transform.d_offset = minPos;
+            for (int i = 0; i < 3; ++i)
+            {
+                // flat meshes still need a non-zero scale to divide by
+                const float extent = maxPos[i] - minPos[i];
+                o_transform.d_scale[i] = extent > 0.0f ? extent : 1.0f;
+            }
+        }
+
+        std::vector<utils::QuantizedVertex> vertices;
+        vertices.reserve(i_vertices.size());
+        for (const auto& vertex : i_vertices)
+        {
+            utils::QuantizedVertex& packed = vertices.emplace_back();
+            for (int i = 0; i < 3; ++i)
+                packed.d_position[i] = quantize(vertex.d_position[i], o_transform.d_offset[i], o_transform.d_scale[i]);
+            packed.d_position[3] = 0;
+            packed.d_normal = packNormal(vertex.d_normal);
+            packed.d_texCoords = packTexCoords(vertex.d_texCoords);
+        }
+        return asBytes(vertices);
+    }
+    }
+    throw std::runtime_error("Bad vertex format: " + std::to_string(static_cast<int>(i_format)));
+}
+
+void utils::setVertexAttributes(utils::VertexFormat i_format)
+{
+    const auto stride = static_cast<GLsizei>(utils::getVertexSize(i_format));
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+
+    switch (i_format)
+    {
+    case VertexFormat::Float:
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(utils::Vertex, d_position));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(utils::Vertex, d_normal));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(utils::Vertex, d_texCoords));
+        break;
+    case VertexFormat::Packed:
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(utils::PackedVertex, d_position));
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(utils::PackedVertex, d_normal));
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(utils::PackedVertex, d_texCoords));
+        break;
+    case VertexFormat::Quantized:
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(utils::QuantizedVertex, d_position));
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(utils::QuantizedVertex, d_normal));
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(utils::QuantizedVertex, d_texCoords));
+        break;
+    }
+}
+
+GLenum utils::getIndexType(std::size_t i_verticesCount)
+{
+    return i_verticesCount <= std::numeric_limits<std::uint16_t>::max() + std::size_t(1) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+std::size_t utils::getIndexSize(GLenum i_indexType)
+{
+    return i_indexType == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+}
@@ -1,13 +1,22 @@
 #include <glad/glad.h> // should be included first
 
+#include "AssetRegistry.hpp"
 #include "CameraManager.hpp"
+#include "DeferredRenderer.hpp"
+#include "GLStateCache.hpp"
+#include "LightClusters.hpp"
 #include "Mesh.hpp"
 #include "Model.hpp"
+#include "RenderQueue.hpp"
+#include "ShaderVariants.hpp"
 #include "ShadersManager.hpp"
 #include "Texture.hpp"
+#include "TextureResidency.hpp"
+#include "TextureStreamer.hpp"
+#include "UniformBlocks.hpp"
+#include "UploadQueue.hpp"
 #include "Vertices.hpp"
 
-#define STB_IMAGE_IMPLEMENTATION
 #include <GLFW/glfw3.h>
 #include <stb_image.h>
 #include <glm/glm.hpp>
@@ -16,10 +25,16 @@
 
 #include <iostream>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 void framebuffer_size_callback(GLFWwindow*, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    utils::GLStateCache::getInstance().setViewport(0, 0, width, height);
 }
 
 void process_input(GLFWwindow* window, utils::Camera& io_camera, float& io_deltaTime, float& io_lastFrame)
@@ -46,61 +61,122 @@ void scroll_callback(GLFWwindow* window, double i_xOffset, double i_yOffset)
         camera->processScrollInput(i_xOffset, i_yOffset);
 }
 
-int main()
+static constexpr std::string_view MODEL_PATH = "../../../backpack/backpack.obj";
+
+// loads the model once with its mesh cache deleted and once from the cache that load wrote;
+// the textures are decoded the same way both times, so only the mesh import differs
+void benchmark_mesh_cache()
 {
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    const auto timeLoad = []()
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        const utils::Model model(MODEL_PATH);
+        const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        return std::pair(milliseconds, model.isMeshCacheHit());
+    };
 
-    GLFWwindow* window = glfwCreateWindow(800, 600, "LearnOpenGl", nullptr, nullptr);
-    if (!window)
+    utils::Model::invalidateMeshCache(MODEL_PATH);
+    const auto [coldMilliseconds, isColdHit] = timeLoad();
+    const auto [warmMilliseconds, isWarmHit] = timeLoad();
+    std::cout << "Mesh cache benchmark: cold load " << coldMilliseconds << " ms (cache " << (isColdHit ? "hit" : "miss") << "), warm load "
+              << warmMilliseconds << " ms (cache " << (isWarmHit ? "hit" : "miss") << ")\n";
+}
+
+// owns every GL resource of the scene, so they are released before the context is destroyed
+void run_scene(GLFWwindow* window, utils::Camera& io_camera, bool i_isDeferred)
+{
+    // only the directional light and the clustered ones are set, the variants skip the fixed point and spot ones
+    static constexpr utils::ShaderFeatures SCENE_FEATURES = utils::SHADER_DIR_LIGHT | utils::SHADER_CLUSTERED_LIGHTS;
+    utils::ShaderVariants modelShaders("shaders/vertex.vs", "shaders/fragment.fs");
+    // the deferred path lights every pixel once, the geometry pass only needs the material features
+    std::optional<utils::DeferredRenderer> deferredRenderer;
+    if (i_isDeferred)
     {
-        std::cout << "Failed to create GLWF window\n";
-        glfwTerminate();
-        return -1;
+        deferredRenderer.emplace("shaders/vertex.vs", "shaders/gbuffer.fs", "shaders/fullscreen.vs", "shaders/fragment.fs");
+        const std::array<utils::ShaderFeatures, 2> geometryVariants = { 0, utils::SHADER_SPECULAR_MAP };
+        deferredRenderer->getGeometryShaders().prewarm(geometryVariants);
+        const std::array<utils::ShaderFeatures, 1> lightingVariants = { SCENE_FEATURES | utils::SHADER_DEFERRED_LIGHTING };
+        deferredRenderer->getLightingShaders().prewarm(lightingVariants);
     }
-    glfwMakeContextCurrent(window);
-
-    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+    else
     {
-        std::cout << "Failed to initialize GLAD\n";
-        return -1;
+        const std::array<utils::ShaderFeatures, 2> modelVariants = { SCENE_FEATURES, SCENE_FEATURES | utils::SHADER_SPECULAR_MAP };
+        modelShaders.prewarm(modelVariants);
     }
 
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-    glm::vec3 cameraPos(0.0f, 0.0f, 3.0f);
-    glm::vec3 cameraFront(0.0f, 0.0f, -1.0f);
-    glm::vec3 cameraUp(0.0f, 1.0f, 0.0f);
-    utils::Camera camera(cameraPos, cameraFront, cameraUp);
+    // GL uploads of streamed assets get at most this much of every frame
+    static constexpr std::chrono::milliseconds UPLOAD_BUDGET(2);
+    utils::UploadQueue uploadQueue;
+    // mips of the model's textures arriving after it is resident, at most this many bytes per frame
+    static constexpr size_t TEXTURE_STREAMING_BUDGET = 2 << 20;
+    utils::TextureStreamer textureStreamer;
+    // textures not drawn for a while are reduced once they take more video memory than this
+    static constexpr size_t TEXTURE_BUDGET = 256 << 20;
+    utils::TextureResidency textureResidency(TEXTURE_BUDGET, &textureStreamer);
+    utils::RenderQueue renderQueue;
+    utils::RenderQueueStats lastStats;
+    utils::AssetRegistryStats lastAssetStats;
+    utils::ModelOptions modelOptions;
+    modelOptions.d_vertexFormat = utils::VertexFormat::Quantized;
+    modelOptions.d_useGeometryPool = true;
+    modelOptions.d_releaseCpuGeometry = true;
+    modelOptions.d_compressTextures = true;
+    modelOptions.d_textureStreamer = &textureStreamer;
+    modelOptions.d_textureResidency = &textureResidency;
+    auto modelLoader = utils::Model::loadAsync(MODEL_PATH, uploadQueue, modelOptions);
 
-    glfwSetWindowUserPointer(window, &camera);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-
-    stbi_set_flip_vertically_on_load(true);
+    glm::vec3 dirLightDir(0.2f, 1.0f, 0.3f);
 
-    utils::ShadersManager modelShader("shaders/vertex.vs", "shaders/model_loading.fs");
+    // shared by all programs, uploaded once per frame instead of as uniforms of every program
+    utils::UniformBuffer frameUniformBuffer(utils::FRAME_UNIFORMS_BINDING, sizeof(utils::FrameUniforms));
+    utils::UniformBuffer lightUniformBuffer(utils::LIGHT_UNIFORMS_BINDING, sizeof(utils::LightUniforms));
 
-    utils::Model modelLoader("../../../backpack/backpack.obj");
+    // the lights don't move, the point and spot ones stay black until the scene places them (and SCENE_FEATURES enables them)
+    utils::LightUniforms lights;
+    lights.d_dirLight.d_direction = -dirLightDir;
+    lights.d_dirLight.d_ambient = glm::vec3(0.1f);
+    lights.d_dirLight.d_diffuse = glm::vec3(0.8f);
+    lights.d_dirLight.d_specular = glm::vec3(1.0f);
+    lightUniformBuffer.update(lights);
 
-    glm::vec3 dirLightDir(0.2f, 1.0f, 0.3f);
+    // point lights circling the model, binned into the clusters of the view frustum every frame
+    static constexpr size_t CLUSTERED_LIGHTS_COUNT = 1024;
+    std::vector<utils::PointLightUniforms> clusteredLights(CLUSTERED_LIGHTS_COUNT);
+    std::vector<glm::vec3> clusteredLightOrbits(CLUSTERED_LIGHTS_COUNT); // radius, height, phase
+    for (size_t i = 0; i < CLUSTERED_LIGHTS_COUNT; ++i)
+    {
+        const float t = static_cast<float>(i);
+        clusteredLightOrbits[i] = glm::vec3(2.0f + std::fmod(t * 0.618f, 1.0f) * 18.0f, std::sin(t * 1.3f) * 2.0f, t * 2.4f);
+        auto& light = clusteredLights[i];
+        light.d_diffuse = 0.3f * glm::vec3(0.5f + 0.5f * std::sin(t * 2.4f), 0.5f + 0.5f * std::sin(t * 2.4f + 2.1f), 0.5f + 0.5f * std::sin(t * 2.4f + 4.2f));
+        light.d_specular = light.d_diffuse;
+        light.d_linear = 0.7f;
+        light.d_quadratic = 1.8f;
+    }
+    utils::LightClusters lightClusters;
+    utils::LightClusterBuffers lightClusterBuffers(lightClusters);
 
     float deltaTime = 0.0f;
     float lastFrame = deltaTime;
 
-    glEnable(GL_DEPTH_TEST);
+    auto& glState = utils::GLStateCache::getInstance();
+    glState.setDepthTest(true);
+
+    // redundant GL calls the state cache dropped, reported every few seconds
+    static constexpr double STATS_PERIOD = 5.0;
+    double statsStartTime = glfwGetTime();
+    size_t statsFrames = 0;
 
     while(!glfwWindowShouldClose(window))
     {
-        process_input(window, camera, deltaTime, lastFrame);
+        process_input(window, io_camera, deltaTime, lastFrame);
+        uploadQueue.process(UPLOAD_BUDGET);
+        textureResidency.update();
+        textureStreamer.process(TEXTURE_STREAMING_BUDGET);
+
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        modelShader.render();
-
          //const float t = glfwGetTime();
          //lightDir.x = 2.0f * std::sin(t);
          //lightDir.y = -0.0f;
@@ -109,21 +185,156 @@ int main()
         // positions
 
         // view/projection transforms
-        auto view = camera.getView();
-        auto projection = camera.getProjection();
-        modelShader.setMatrix4fv("view", view);
-        modelShader.setMatrix4fv("projection", projection);
+        utils::FrameUniforms frame;
+        frame.d_view = io_camera.getView();
+        frame.d_projection = io_camera.getProjection();
+        frame.d_viewProjection = frame.d_projection * frame.d_view;
+        frame.d_viewPos = io_camera.getCameraPos();
+        frame.d_time = static_cast<float>(glfwGetTime());
+        frameUniformBuffer.update(frame);
+
+        for (size_t i = 0; i < CLUSTERED_LIGHTS_COUNT; ++i)
+        {
+            const auto& orbit = clusteredLightOrbits[i];
+            const float angle = orbit.z + frame.d_time * 0.2f;
+            clusteredLights[i].d_position = glm::vec3(orbit.x * std::cos(angle), orbit.y, orbit.x * std::sin(angle));
+        }
+        int framebufferWidth = 0;
+        int framebufferHeight = 0;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        lightClusters.build(frame.d_view, frame.d_projection, clusteredLights, {});
+        lightClusterBuffers.update(lightClusters, clusteredLights, {}, glm::vec2(static_cast<float>(framebufferWidth), static_cast<float>(framebufferHeight)));
 
         // world transform
         auto model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f));
         model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
-        modelShader.setMatrix4fv("model", model);
-        modelLoader.Draw(modelShader);
+        if (deferredRenderer)
+        {
+            deferredRenderer->beginGeometryPass(framebufferWidth, framebufferHeight);
+            modelLoader->Draw(renderQueue, deferredRenderer->getGeometryShaders(), 0, io_camera, model);
+            renderQueue.submit();
+            deferredRenderer->drawLighting(SCENE_FEATURES, frame.d_viewProjection);
+        }
+        else
+        {
+            modelLoader->Draw(renderQueue, modelShaders, SCENE_FEATURES, io_camera, model);
+            renderQueue.submit();
+        }
+
+        // only reported when they change, e.g. once the model is resident or meshes get culled
+        const auto& unsortedStats = renderQueue.getUnsortedStats();
+        const auto& sortedStats = renderQueue.getSortedStats();
+        if (sortedStats != lastStats)
+        {
+            std::cout << "Draws: " << sortedStats.d_drawsCount << ", state changes unsorted/sorted: programs "
+                      << unsortedStats.d_programChanges << '/' << sortedStats.d_programChanges << ", materials "
+                      << unsortedStats.d_materialChanges << '/' << sortedStats.d_materialChanges << ", vertex arrays "
+                      << unsortedStats.d_vertexArrayChanges << '/' << sortedStats.d_vertexArrayChanges << '\n';
+            lastStats = sortedStats;
+        }
+
+        // what sharing textures, meshes and programs between their users saved
+        const auto assetStats = utils::AssetRegistry::getInstance().getStats();
+        if (assetStats != lastAssetStats)
+        {
+            const auto printAssetStats = [](const char* i_name, const utils::AssetStats& i_stats)
+            {
+                std::cout << i_name << ' ' << i_stats.d_liveCount << " live/" << i_stats.d_reusedCount << " reused";
+                if (i_stats.d_savedBytes > 0)
+                    std::cout << " (" << i_stats.d_savedBytes / 1024 << " KB saved)";
+            };
+            std::cout << "Assets: ";
+            printAssetStats("textures", assetStats.d_textures);
+            printAssetStats(", meshes", assetStats.d_meshes);
+            printAssetStats(", programs", assetStats.d_programs);
+            std::cout << '\n';
+            lastAssetStats = assetStats;
+        }
+
+        ++statsFrames;
+        if (glfwGetTime() - statsStartTime >= STATS_PERIOD)
+        {
+            const auto& glStats = glState.getStats();
+            std::cout << "GL state calls per frame: " << glStats.d_issuedCalls / statsFrames << " issued, "
+                      << glStats.d_skippedCalls / statsFrames << " skipped\n";
+            glState.resetStats();
+
+            const auto& streamingStats = textureStreamer.getStats();
+            if (streamingStats.d_uploadedLevels > 0)
+            {
+                std::cout << "Texture streaming: " << streamingStats.d_uploadedLevels << " mips, " << streamingStats.d_uploadedBytes / 1024 << " KB uploaded, "
+                          << streamingStats.d_stalls << " stalls, " << streamingStats.d_pendingTextures << " textures pending\n";
+                textureStreamer.resetStats();
+            }
+
+            const auto& residencyStats = textureResidency.getStats();
+            std::cout << "Textures: " << residencyStats.d_trackedTextures << " tracked, " << residencyStats.d_residentBytes / 1024 << " of "
+                      << residencyStats.d_budgetBytes / 1024 << " KB resident, " << residencyStats.d_reductions << " reduced, " << residencyStats.d_evictions
+                      << " evicted, " << residencyStats.d_reloads << " reloaded\n";
+            textureResidency.resetStats();
+
+            const auto& clusterStats = lightClusters.getStats();
+            std::cout << "Light clusters: " << clusterStats.d_visibleLightsCount << " of " << clusterStats.d_lightsCount << " lights visible, "
+                      << clusterStats.d_lightIndicesCount << " indices, at most " << clusterStats.d_maxClusterLights << " per cluster ("
+                      << clusterStats.d_droppedLights << " dropped), binned in " << clusterStats.d_buildMilliseconds << " ms\n";
+            statsStartTime = glfwGetTime();
+            statsFrames = 0;
+        }
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
+}
+
+// --deferred selects the deferred shading path, --mesh-cache-benchmark reports the cold and warm model load times first
+int main(int argc, char** argv)
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(800, 600, "LearnOpenGl", nullptr, nullptr);
+    if (!window)
+    {
+        std::cout << "Failed to create GLWF window\n";
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+    {
+        std::cout << "Failed to initialize GLAD\n";
+        return -1;
+    }
+
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    glm::vec3 cameraPos(0.0f, 0.0f, 3.0f);
+    glm::vec3 cameraFront(0.0f, 0.0f, -1.0f);
+    glm::vec3 cameraUp(0.0f, 1.0f, 0.0f);
+    utils::Camera camera(cameraPos, cameraFront, cameraUp);
+
+    glfwSetWindowUserPointer(window, &camera);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+
+    stbi_set_flip_vertically_on_load(true);
+
+    bool isDeferred = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--deferred")
+            isDeferred = true;
+        else if (arg == "--mesh-cache-benchmark")
+            benchmark_mesh_cache();
+    }
+    std::cout << (isDeferred ? "Deferred" : "Forward") << " shading\n";
+    run_scene(window, camera, isDeferred);
 
     glfwTerminate();
     return 0;
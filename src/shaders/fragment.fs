@@ -1,9 +1,16 @@
 #version 330 core
 
+#ifdef DEFERRED_LIGHTING
+// the lighting pass of DeferredRenderer, drawn with fullscreen.vs; read back from the G-buffer, see readGBuffer()
+vec3 Normal;
+vec3 FragPos;
+#else
 in vec3 Normal;
 in vec3 FragPos;
 in vec2 TexCoords;
+#endif
 
+// members are ordered so that every vec3 is followed by a float, like the structs of UniformBlocks.hpp
 struct DirLight
 {
     vec3 direction;
@@ -15,29 +22,25 @@ struct DirLight
 struct PointLight
 {
     vec3 position;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-
     float constant;
+    vec3 ambient;
     float linear;
+    vec3 diffuse;
     float quadratic;
+    vec3 specular;
 };
 
 struct SpotLight
 {
     vec3 position;
-    vec3 direction;
     float cutOff;
+    vec3 direction;
     float outerCutOff;
-
     vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-
     float constant;
+    vec3 diffuse;
     float linear;
+    vec3 specular;
     float quadratic;
 };
 
@@ -57,101 +60,224 @@ struct Light
     float quadratic;
 };
 
-struct Material
+// the sampler names Mesh::bindMaterial sets, with TEXTURE_ARRAY they are layers of texture arrays;
+// the lighting pass reads the material from the G-buffer instead, its position from the depth
+#ifdef DEFERRED_LIGHTING
+uniform sampler2D gbufferAlbedoSpecular;
+uniform sampler2D gbufferNormal;
+uniform sampler2D gbufferDepth;
+uniform mat4 inverseViewProjection;
+#elif defined(TEXTURE_ARRAY)
+uniform sampler2DArray texture_diffuse0;
+uniform float texture_diffuse0_layer;
+#ifdef SPECULAR_MAP
+uniform sampler2DArray texture_specular0;
+uniform float texture_specular0_layer;
+#endif
+#else
+uniform sampler2D texture_diffuse0;
+#ifdef SPECULAR_MAP
+uniform sampler2D texture_specular0;
+#endif
+#endif
+// uniform Light light;
+
+const float SHININESS = 32.0;
+
+// shared by all programs, see UniformBlocks.hpp
+layout (std140) uniform FrameData
 {
-    sampler2D diffuse;
-    sampler2D specular;
-    float shiness;
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 viewPos;
+    float time;
 };
 
-uniform vec3 viewPos;
-uniform Material material;
-// uniform Light light;
-uniform DirLight dirLight;
+// the variant's features (see ShaderVariants.hpp) pick the lights that are evaluated,
+// the block always has room for all of them so every program shares its layout
+#define MAX_POINT_LIGHTS 4
+#ifndef POINT_LIGHTS_CNT
+#define POINT_LIGHTS_CNT 0
+#endif
+
+layout (std140) uniform LightData
+{
+    DirLight dirLight;
+    PointLight pointLights[MAX_POINT_LIGHTS];
+    SpotLight spotLight;
+};
 
-#define POINT_LIGHTS_CNT 4
-uniform PointLight pointLights[POINT_LIGHTS_CNT];
+#ifdef CLUSTERED_LIGHTS
+// any number of point and spot lights, binned into the clusters of the view frustum by LightClusters
+layout (std140) uniform ClusterData
+{
+    uvec4 clusterGrid;   // tiles along x and y, depth slices
+    vec4 clusterDepth;   // slice = log(view depth) * x + y
+    vec4 clusterScreen;  // tile = gl_FragCoord.xy * xy
+};
 
-uniform SpotLight spotLight;
+uniform samplerBuffer clusterLights;        // 5 texels per light, laid out like SpotLight
+uniform usamplerBuffer clusterRanges;       // offset into clusterLightIndices and lights count of every cluster
+uniform usamplerBuffer clusterLightIndices;
+#endif
 
 out vec4 FragColor;
 
-vec3 calcDirLight(DirLight i_dirLight, vec3 i_normal, vec3 i_viewDir)
+// the material's colors are sampled once and shared by all lights
+vec3 diffuseColor;
+vec3 specularColor;
+
+vec3 calcLight(vec3 i_lightDir, vec3 i_ambient, vec3 i_diffuse, vec3 i_specular, vec3 i_normal, vec3 i_viewDir)
 {
-    vec3 lightDir = normalize(-i_dirLight.direction);
-    float diffuseCoef = max(dot(i_normal, lightDir), 0.0);
+    float diffuseCoef = max(dot(i_normal, i_lightDir), 0.0);
+    vec3 result = diffuseColor * (i_ambient + diffuseCoef * i_diffuse);
 
-    vec3 reflectDir = reflect(-lightDir, i_normal);
-    float specularCoef = pow(max(dot(i_viewDir, reflectDir), 0.0), material.shiness);
+#if defined(SPECULAR_MAP) || defined(DEFERRED_LIGHTING)
+    vec3 reflectDir = reflect(-i_lightDir, i_normal);
+    float specularCoef = pow(max(dot(i_viewDir, reflectDir), 0.0), SHININESS);
+    result += specularColor * specularCoef * i_specular;
+#endif
 
-    vec3 diffuse = vec3(texture(material.diffuse, TexCoords)) * diffuseCoef * i_dirLight.diffuse;
-    vec3 ambient = vec3(texture(material.diffuse, TexCoords)) * i_dirLight.ambient;
-    vec3 specular = vec3(texture(material.specular, TexCoords)) * specularCoef * i_dirLight.specular;
+    return result;
+}
 
-    return ambient + diffuse + specular;
+vec3 calcDirLight(DirLight i_dirLight, vec3 i_normal, vec3 i_viewDir)
+{
+    vec3 lightDir = normalize(-i_dirLight.direction);
+    return calcLight(lightDir, i_dirLight.ambient, i_dirLight.diffuse, i_dirLight.specular, i_normal, i_viewDir);
 }
 
 vec3 calcPointLight(PointLight i_pointLight, vec3 i_normal, vec3 i_fragPos, vec3 i_viewDir)
 {
     vec3 lightDir = normalize(i_pointLight.position - i_fragPos);
-    float diffuseCoef = max(dot(i_normal, lightDir), 0.0);
-
-    vec3 reflectDir = reflect(-lightDir, i_normal);
-    float specularCoef = pow(max(dot(i_viewDir, reflectDir), 0.0), material.shiness);
-
-    vec3 diffuse = vec3(texture(material.diffuse, TexCoords)) * diffuseCoef * i_pointLight.diffuse;
-    vec3 ambient = vec3(texture(material.diffuse, TexCoords)) * i_pointLight.ambient;
-    vec3 specular = vec3(texture(material.specular, TexCoords)) * specularCoef * i_pointLight.specular;
 
     float distance = length(i_pointLight.position - i_fragPos);
     float attenuation = 1.0 / (i_pointLight.quadratic * distance * distance + i_pointLight.linear * distance + i_pointLight.constant);
-    ambient *= attenuation;
-    diffuse *= attenuation;
-    specular *= attenuation;
 
-    return ambient + diffuse + specular;
+    return attenuation * calcLight(lightDir, i_pointLight.ambient, i_pointLight.diffuse, i_pointLight.specular, i_normal, i_viewDir);
 }
 
 vec3 calcSpotLight(SpotLight i_spotLight, vec3 i_normal, vec3 i_fragPos, vec3 i_viewDir)
 {
     vec3 lightDir = normalize(i_spotLight.position - i_fragPos);
-    float diffuseCoef = max(dot(i_normal, lightDir), 0.0);
-
-    vec3 reflectDir = reflect(-lightDir, i_normal);
-    float specularCoef = pow(max(dot(i_viewDir, reflectDir), 0.0), material.shiness);
-
-    vec3 diffuse = vec3(texture(material.diffuse, TexCoords)) * diffuseCoef * i_spotLight.diffuse;
-    vec3 ambient = vec3(texture(material.diffuse, TexCoords)) * i_spotLight.ambient;
-    vec3 specular = vec3(texture(material.specular, TexCoords)) * specularCoef * i_spotLight.specular;
 
     float distance = length(i_spotLight.position - i_fragPos);
     float attenuation = 1.0 / (i_spotLight.quadratic * distance * distance + i_spotLight.linear * distance + i_spotLight.constant);
-    ambient *= attenuation;
-    diffuse *= attenuation;
-    specular *= attenuation;
 
-    // spotlight with soft edges
+    // spotlight with soft edges, the ambient part is not affected
     float theta = dot(lightDir, normalize(-i_spotLight.direction));
     float epsilon = i_spotLight.cutOff - i_spotLight.outerCutOff;
     float intensity = clamp((theta - i_spotLight.outerCutOff) / epsilon, 0.0, 1.0);
-    diffuse *= intensity;
-    specular *= intensity;
 
-    return ambient + diffuse + specular;
+    return attenuation * calcLight(lightDir, i_spotLight.ambient, intensity * i_spotLight.diffuse, intensity * i_spotLight.specular, i_normal, i_viewDir);
+}
+
+#ifdef CLUSTERED_LIGHTS
+vec3 calcClusteredLights(vec3 i_normal, vec3 i_fragPos, vec3 i_viewDir)
+{
+    float viewDepth = -(view * vec4(i_fragPos, 1.0)).z;
+    uvec3 cluster = uvec3(gl_FragCoord.xy * clusterScreen.xy, max(log(viewDepth) * clusterDepth.x + clusterDepth.y, 0.0));
+    cluster = min(cluster, clusterGrid.xyz - 1u);
+    uvec2 range = texelFetch(clusterRanges, int((cluster.z * clusterGrid.y + cluster.y) * clusterGrid.x + cluster.x)).xy;
+
+    // point lights come as spot lights whose cone covers every direction
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < range.y; ++i)
+    {
+        int texel = int(texelFetch(clusterLightIndices, int(range.x + i)).x) * 5;
+        vec4 positionCutOff = texelFetch(clusterLights, texel);
+        vec4 directionOuterCutOff = texelFetch(clusterLights, texel + 1);
+        vec4 ambientConstant = texelFetch(clusterLights, texel + 2);
+        vec4 diffuseLinear = texelFetch(clusterLights, texel + 3);
+        vec4 specularQuadratic = texelFetch(clusterLights, texel + 4);
+
+        SpotLight clusterLight = SpotLight(positionCutOff.xyz, positionCutOff.w, directionOuterCutOff.xyz, directionOuterCutOff.w,
+                                           ambientConstant.xyz, ambientConstant.w, diffuseLinear.xyz, diffuseLinear.w,
+                                           specularQuadratic.xyz, specularQuadratic.w);
+        result += calcSpotLight(clusterLight, i_normal, i_fragPos, i_viewDir);
+    }
+    return result;
+}
+#endif
+
+#ifdef DEFERRED_LIGHTING
+vec3 decodeNormal(vec2 i_encoded)
+{
+    vec3 normal = vec3(i_encoded, 1.0 - abs(i_encoded.x) - abs(i_encoded.y));
+    if (normal.z < 0.0)
+    {
+        vec2 signs = vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+        normal.xy = (1.0 - abs(normal.yx)) * signs;
+    }
+    return normalize(normal);
+}
+
+// the surface the geometry pass left in the pixel, false for the background
+bool readGBuffer()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gbufferDepth, pixel, 0).r;
+    if (depth == 1.0)
+        return false;
+
+    vec4 albedoSpecular = texelFetch(gbufferAlbedoSpecular, pixel, 0);
+    diffuseColor = albedoSpecular.rgb;
+    specularColor = vec3(albedoSpecular.a);
+    Normal = decodeNormal(texelFetch(gbufferNormal, pixel, 0).xy);
+
+    vec3 ndc = vec3(gl_FragCoord.xy / vec2(textureSize(gbufferDepth, 0)), depth) * 2.0 - 1.0;
+    vec4 position = inverseViewProjection * vec4(ndc, 1.0);
+    FragPos = position.xyz / position.w;
+    return true;
 }
+#endif
 
 void main()
 {
+#ifdef DEFERRED_LIGHTING
+    if (!readGBuffer())
+        discard;
+#else
+#ifdef TEXTURE_ARRAY
+    diffuseColor = vec3(texture(texture_diffuse0, vec3(TexCoords, texture_diffuse0_layer)));
+#else
+    diffuseColor = vec3(texture(texture_diffuse0, TexCoords));
+#endif
+#if defined(SPECULAR_MAP) && defined(TEXTURE_ARRAY)
+    specularColor = vec3(texture(texture_specular0, vec3(TexCoords, texture_specular0_layer)));
+#elif defined(SPECULAR_MAP)
+    specularColor = vec3(texture(texture_specular0, TexCoords));
+#else
+    specularColor = vec3(0.0);
+#endif
+#endif
+
+#if !defined(DIR_LIGHT) && !defined(SPOT_LIGHT) && !defined(CLUSTERED_LIGHTS) && POINT_LIGHTS_CNT == 0
+    // no lights, unlit
+    vec3 result = diffuseColor;
+#else
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(viewPos - FragPos);
-    vec3 output = calcDirLight(dirLight, norm, viewDir);
+    vec3 result = vec3(0.0);
+
+#ifdef DIR_LIGHT
+    result += calcDirLight(dirLight, norm, viewDir);
+#endif
 
     for (int i = 0; i < POINT_LIGHTS_CNT; ++i)
-        output += calcPointLight(pointLights[i], norm, FragPos, viewDir);
+        result += calcPointLight(pointLights[i], norm, FragPos, viewDir);
+
+#ifdef SPOT_LIGHT
+    result += calcSpotLight(spotLight, norm, FragPos, viewDir);
+#endif
 
-    output += calcSpotLight(spotLight, norm, FragPos, viewDir);
+#ifdef CLUSTERED_LIGHTS
+    result += calcClusteredLights(norm, FragPos, viewDir);
+#endif
+#endif
 
-    FragColor = vec4(output, 1.0);
+    FragColor = vec4(result, 1.0);
 
     /*
     // ambient
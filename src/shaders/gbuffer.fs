@@ -0,0 +1,55 @@
+#version 330 core
+
+in vec3 Normal;
+in vec3 FragPos;
+in vec2 TexCoords;
+
+// the sampler names Mesh::bindMaterial sets, with TEXTURE_ARRAY they are layers of texture arrays
+#ifdef TEXTURE_ARRAY
+uniform sampler2DArray texture_diffuse0;
+uniform float texture_diffuse0_layer;
+#ifdef SPECULAR_MAP
+uniform sampler2DArray texture_specular0;
+uniform float texture_specular0_layer;
+#endif
+#else
+uniform sampler2D texture_diffuse0;
+#ifdef SPECULAR_MAP
+uniform sampler2D texture_specular0;
+#endif
+#endif
+
+// the G-buffer of DeferredRenderer, the depth comes from the depth attachment
+layout (location = 0) out vec4 AlbedoSpecular; // diffuse color, specular intensity
+layout (location = 1) out vec2 EncodedNormal;  // octahedral world space normal
+
+// the unit octahedron unfolded onto a square, two components for a normal with an even precision over all directions
+vec2 encodeNormal(vec3 i_normal)
+{
+    vec3 normal = i_normal / (abs(i_normal.x) + abs(i_normal.y) + abs(i_normal.z));
+    if (normal.z < 0.0)
+    {
+        vec2 signs = vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+        normal.xy = (1.0 - abs(normal.yx)) * signs;
+    }
+    return normal.xy;
+}
+
+void main()
+{
+#ifdef TEXTURE_ARRAY
+    AlbedoSpecular.rgb = vec3(texture(texture_diffuse0, vec3(TexCoords, texture_diffuse0_layer)));
+#else
+    AlbedoSpecular.rgb = vec3(texture(texture_diffuse0, TexCoords));
+#endif
+    // specular maps are gray, one channel is enough
+#if defined(SPECULAR_MAP) && defined(TEXTURE_ARRAY)
+    AlbedoSpecular.a = texture(texture_specular0, vec3(TexCoords, texture_specular0_layer)).r;
+#elif defined(SPECULAR_MAP)
+    AlbedoSpecular.a = texture(texture_specular0, TexCoords).r;
+#else
+    AlbedoSpecular.a = 0.0;
+#endif
+
+    EncodedNormal = encodeNormal(normalize(Normal));
+}
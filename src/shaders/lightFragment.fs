@@ -19,9 +19,23 @@ struct Material
     float shiness;
 };
 
-uniform vec3 viewPos;
 uniform Material material;
-uniform Light light;
+
+// shared by all programs, see UniformBlocks.hpp
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 viewPos;
+    float time;
+};
+
+// only the directional light, the first member of the block, has the layout of Light
+layout (std140) uniform LightData
+{
+    Light light;
+};
 
 out vec4 FragColor;
 
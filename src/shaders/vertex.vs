@@ -4,9 +4,29 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#ifdef INSTANCED
+// per instance, see InstanceBuffer
+layout (location = 3) in mat4 aInstanceTransform;
+layout (location = 7) in vec4 aInstanceData;
+
+out vec4 InstanceData;
+#endif
+
+uniform mat4 model; // with INSTANCED the transform of the mesh inside of the model, applied before the instance one
+
+// shared by all programs, see UniformBlocks.hpp
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 viewPos;
+    float time;
+};
+
+// dequantizes positions of compact vertex formats, identity for float ones
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
 
 out vec3 Normal;
 out vec3 FragPos;
@@ -14,8 +34,15 @@ out vec2 TexCoords;
 
 void main()
 {
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+#ifdef INSTANCED
+    mat4 world = aInstanceTransform * model;
+    InstanceData = aInstanceData;
+#else
+    mat4 world = model;
+#endif
+    vec3 position = positionOffset + positionScale * aPos;
+    Normal = mat3(transpose(inverse(world))) * aNormal;
+    FragPos = vec3(world * vec4(position, 1.0));
+    gl_Position = viewProjection * world * vec4(position, 1.0);
     TexCoords = aTexCoords;
 }
@@ -0,0 +1,160 @@
+#include "Tests.hpp"
+
+#include "DeferredRenderer.hpp"
+#include "GLObject.hpp"
+#include "GLStateCache.hpp"
+#include "ShadersManager.hpp"
+#include "UniformBlocks.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+// position, normal and texture coordinates, the attributes of vertex.vs
+struct Vertex
+{
+    glm::vec3 d_position;
+    glm::vec3 d_normal;
+    glm::vec2 d_texCoords;
+};
+
+// two triangles facing +z at i_z, from i_left to i_right and over the whole height of the view
+void addQuad(std::vector<Vertex>& io_vertices, float i_left, float i_right, float i_z)
+{
+    static constexpr float HALF_HEIGHT = 10.0f;
+    const glm::vec3 normal(0.0f, 0.0f, 1.0f);
+    const std::array<Vertex, 4> corners = {
+        Vertex{ glm::vec3(i_left, -HALF_HEIGHT, i_z), normal, glm::vec2(0.0f, 0.0f) },
+        Vertex{ glm::vec3(i_right, -HALF_HEIGHT, i_z), normal, glm::vec2(1.0f, 0.0f) },
+        Vertex{ glm::vec3(i_right, HALF_HEIGHT, i_z), normal, glm::vec2(1.0f, 1.0f) },
+        Vertex{ glm::vec3(i_left, HALF_HEIGHT, i_z), normal, glm::vec2(0.0f, 1.0f) },
+    };
+    for (const std::size_t corner : { 0, 1, 2, 0, 2, 3 })
+        io_vertices.push_back(corners[corner]);
+}
+
+bool isColor(const std::uint8_t* i_pixel, int i_red, int i_green, int i_blue)
+{
+    static constexpr int TOLERANCE = 2;
+    return std::abs(i_pixel[0] - i_red) <= TOLERANCE && std::abs(i_pixel[1] - i_green) <= TOLERANCE && std::abs(i_pixel[2] - i_blue) <= TOLERANCE;
+}
+}
+
+void tests::testDeferredRenderer()
+{
+    static constexpr int SIZE = tests::GL_WINDOW_SIZE;
+    auto& glState = utils::GLStateCache::getInstance();
+    utils::DeferredRenderer renderer("shaders/vertex.vs", "shaders/gbuffer.fs", "shaders/fullscreen.vs", "shaders/fragment.fs");
+
+    // the camera looks down -z from 3 units in front of the plane the scene's quad is in
+    utils::FrameUniforms frame;
+    frame.d_view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    frame.d_projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+    frame.d_viewProjection = frame.d_projection * frame.d_view;
+    frame.d_viewPos = glm::vec3(0.0f, 0.0f, 3.0f);
+    utils::UniformBuffer frameBuffer(utils::FRAME_UNIFORMS_BINDING, sizeof(utils::FrameUniforms));
+    frameBuffer.update(frame);
+
+    // a white surface facing the light is lit to ambient + diffuse
+    utils::LightUniforms lights;
+    lights.d_dirLight.d_direction = glm::vec3(0.0f, 0.0f, -1.0f);
+    lights.d_dirLight.d_ambient = glm::vec3(0.1f);
+    lights.d_dirLight.d_diffuse = glm::vec3(0.5f);
+    utils::UniformBuffer lightBuffer(utils::LIGHT_UNIFORMS_BINDING, sizeof(utils::LightUniforms));
+    lightBuffer.update(lights);
+    static constexpr int LIT = 153;
+
+    // the scene's quad covers the left half of the view, the forward one is behind it over the whole view
+    std::vector<Vertex> vertices;
+    addQuad(vertices, -10.0f, 0.0f, 0.0f);
+    addQuad(vertices, -10.0f, 10.0f, -1.0f);
+    const auto vertexArray = utils::VertexArrayHandle::create();
+    const auto vertexBuffer = utils::BufferHandle::create();
+    glState.bindVertexArray(vertexArray.get());
+    glState.bindBuffer(GL_ARRAY_BUFFER, vertexBuffer.get());
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size() * sizeof(Vertex)), vertices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, d_position)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, d_normal)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, d_texCoords)));
+
+    const auto white = utils::TextureHandle::create();
+    static constexpr std::array<std::uint8_t, 4> WHITE = { 255, 255, 255, 255 };
+    glState.bindTexture(0, GL_TEXTURE_2D, white.get());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, WHITE.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // the background of the default framebuffer is whatever was there, the deferred pass only shades the scene
+    glState.bindFramebuffer(0);
+    glState.setViewport(0, 0, SIZE, SIZE);
+    glState.setDepthMask(true);
+    glClearColor(0.1f, 0.2f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // the first pass creates the G-buffer, which binds its textures, so the mesh's texture is bound after it like Mesh binds its material
+    renderer.beginGeometryPass(SIZE, SIZE);
+    glState.bindTexture(0, GL_TEXTURE_2D, white.get());
+    const auto& geometryShaders = renderer.getGeometryShaders().get(0);
+    geometryShaders.render();
+    geometryShaders.setMatrix4fv("model", glm::mat4(1.0f));
+    geometryShaders.setVec3("positionOffset", glm::vec3(0.0f));
+    geometryShaders.setVec3("positionScale", glm::vec3(1.0f));
+    geometryShaders.setInt("texture_diffuse0", 0);
+    glState.bindVertexArray(vertexArray.get());
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    renderer.drawLighting(utils::SHADER_DIR_LIGHT, frame.d_viewProjection);
+    tests::check(glGetError() == GL_NO_ERROR, "The deferred passes raised a GL error, is the default framebuffer's depth of another format?");
+
+    // the scene's depth is in the default framebuffer, where the scene is
+    const glm::vec4 clipPosition = frame.d_viewProjection * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    const float sceneDepth = clipPosition.z / clipPosition.w * 0.5f + 0.5f;
+    std::vector<float> depths(static_cast<std::size_t>(SIZE) * SIZE);
+    std::vector<std::uint8_t> colors(static_cast<std::size_t>(SIZE) * SIZE * 4);
+    glState.bindFramebuffer(0);
+    glReadPixels(0, 0, SIZE, SIZE, GL_DEPTH_COMPONENT, GL_FLOAT, depths.data());
+    glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, colors.data());
+    for (int y = 0; y < SIZE; ++y)
+    {
+        for (int x = 0; x < SIZE; ++x)
+        {
+            const std::size_t pixel = static_cast<std::size_t>(y) * SIZE + x;
+            const bool isScene = x < SIZE / 2;
+            const std::string name = "Pixel " + std::to_string(x) + ',' + std::to_string(y);
+            const float expectedDepth = isScene ? sceneDepth : 1.0f;
+            tests::check(std::abs(depths[pixel] - expectedDepth) < 1e-5f,
+                         name + " has the depth " + std::to_string(depths[pixel]) + " instead of " + std::to_string(expectedDepth));
+            tests::check(isScene ? isColor(&colors[pixel * 4], LIT, LIT, LIT) : isColor(&colors[pixel * 4], 26, 51, 77),
+                         name + (isScene ? " isn't lit" : " isn't the background"));
+        }
+    }
+
+    // a forward draw behind the scene only shows where the scene isn't
+    geometryShaders.render();
+    glState.bindVertexArray(vertexArray.get());
+    glDrawArrays(GL_TRIANGLES, 6, 6);
+    glReadPixels(0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, colors.data());
+    for (int y = 0; y < SIZE; ++y)
+    {
+        for (int x = 0; x < SIZE; ++x)
+        {
+            const std::size_t pixel = static_cast<std::size_t>(y) * SIZE + x;
+            const bool isScene = x < SIZE / 2;
+            tests::check(isScene ? isColor(&colors[pixel * 4], LIT, LIT, LIT) : isColor(&colors[pixel * 4], 255, 255, 255),
+                         "Pixel " + std::to_string(x) + ',' + std::to_string(y) + (isScene ? " of the scene was drawn over" : " wasn't drawn"));
+        }
+    }
+    tests::check(glGetError() == GL_NO_ERROR, "The forward draw raised a GL error");
+}
@@ -0,0 +1,237 @@
+#include "Tests.hpp"
+
+#include "Frustum.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+static constexpr std::array<utils::CullKernel, 3> KERNELS = { utils::CullKernel::Scalar, utils::CullKernel::Sse, utils::CullKernel::Avx };
+
+const char* getKernelName(utils::CullKernel i_kernel)
+{
+    switch (i_kernel)
+    {
+    case utils::CullKernel::Scalar:
+        return "scalar";
+    case utils::CullKernel::Sse:
+        return "SSE";
+    case utils::CullKernel::Avx:
+        return "AVX";
+    }
+    return "unknown";
+}
+
+// a camera at the origin looking down -z, what Model::Draw extracts its planes from
+utils::Frustum createFrustum()
+{
+    const auto projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    const auto view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    return utils::extractFrustum(projection * view);
+}
+
+// boxes around the frustum, many of them inside, behind or crossing its planes
+std::vector<utils::Bounds> createBoxes(std::size_t i_count, unsigned int i_seed)
+{
+    std::mt19937 random(i_seed);
+    std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+    std::uniform_real_distribution<float> extent(0.0f, 8.0f);
+
+    std::vector<utils::Bounds> boxes(i_count);
+    for (auto& box : boxes)
+    {
+        box.d_center = glm::vec3(position(random), position(random), position(random));
+        box.d_extents = glm::vec3(extent(random), extent(random), extent(random));
+        box.d_radius = glm::length(box.d_extents);
+    }
+    return boxes;
+}
+
+// How far the box reaches into the frustum, in double precision from its 8 corners: negative when all corners are behind one plane.
+// The kernels only have to agree with it where it isn't close to 0, where float rounding may decide either way
+double getReferenceDistance(const utils::Frustum& i_frustum, const utils::Bounds& i_box)
+{
+    double distance = std::numeric_limits<double>::max();
+    for (const auto& plane : i_frustum.d_planes)
+    {
+        double furthestCorner = std::numeric_limits<double>::lowest();
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            const double x = static_cast<double>(i_box.d_center.x) + ((corner & 1) ? 1.0 : -1.0) * i_box.d_extents.x;
+            const double y = static_cast<double>(i_box.d_center.y) + ((corner & 2) ? 1.0 : -1.0) * i_box.d_extents.y;
+            const double z = static_cast<double>(i_box.d_center.z) + ((corner & 4) ? 1.0 : -1.0) * i_box.d_extents.z;
+            furthestCorner = std::max(furthestCorner, plane.x * x + plane.y * y + plane.z * z + plane.w);
+        }
+        distance = std::min(distance, furthestCorner);
+    }
+    return distance;
+}
+
+utils::AabbBatch createBatch(const std::vector<utils::Bounds>& i_boxes)
+{
+    utils::AabbBatch batch;
+    for (const auto& box : i_boxes)
+        batch.add(box);
+    return batch;
+}
+
+// culls i_boxes with i_kernel and compares every clear result with the reference, returns the count of visible boxes
+std::size_t checkKernel(utils::CullKernel i_kernel, const utils::Frustum& i_frustum, const std::vector<utils::Bounds>& i_boxes)
+{
+    static constexpr double MARGIN = 1e-3;
+
+    const auto batch = createBatch(i_boxes);
+    // one more element than needed, the kernels must not write past the batch
+    std::vector<std::uint8_t> visible(i_boxes.size() + 1, 2);
+    batch.cull(i_frustum, visible, i_kernel);
+    tests::check(visible.back() == 2, std::string(getKernelName(i_kernel)) + " wrote past the batch");
+
+    std::size_t visibleCount = 0;
+    for (std::size_t i = 0; i < i_boxes.size(); ++i)
+    {
+        tests::check(visible[i] <= 1, std::string(getKernelName(i_kernel)) + " left box " + std::to_string(i) + " unset");
+        visibleCount += visible[i];
+
+        const double distance = getReferenceDistance(i_frustum, i_boxes[i]);
+        if (std::abs(distance) > MARGIN)
+        {
+            tests::check(visible[i] == (distance > 0.0 ? 1 : 0), std::string(getKernelName(i_kernel)) + " box " + std::to_string(i) + " of "
+                                                                 + std::to_string(i_boxes.size()) + " is " + (visible[i] ? "visible" : "culled")
+                                                                 + ", the reference distance is " + std::to_string(distance));
+        }
+    }
+    return visibleCount;
+}
+}
+
+void tests::testFrustumCulling()
+{
+    const auto frustum = createFrustum();
+
+    // the obvious cases, through the single box test too
+    {
+        const auto box = [](const glm::vec3& i_center, float i_extent)
+        {
+            utils::Bounds bounds;
+            bounds.d_center = i_center;
+            bounds.d_extents = glm::vec3(i_extent);
+            bounds.d_radius = glm::length(bounds.d_extents);
+            return bounds;
+        };
+        const std::vector<std::pair<utils::Bounds, bool>> cases = {
+            { box(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f), true },   // in front
+            { box(glm::vec3(0.0f, 0.0f, 10.0f), 1.0f), false },   // behind
+            { box(glm::vec3(0.0f, 0.0f, -200.0f), 1.0f), false }, // past the far plane
+            { box(glm::vec3(0.0f, 0.0f, -100.5f), 1.0f), true },  // crossing the far plane
+            { box(glm::vec3(-40.0f, 0.0f, -10.0f), 1.0f), false }, // left of the frustum
+            { box(glm::vec3(-10.5f, 0.0f, -10.0f), 1.0f), true }, // crossing the left plane
+            { box(glm::vec3(0.0f, 0.0f, 0.0f), 0.5f), true },     // around the camera
+        };
+        std::vector<utils::Bounds> boxes;
+        for (const auto& [bounds, isVisible] : cases)
+        {
+            tests::check(utils::isVisible(frustum, bounds) == isVisible, "Box " + std::to_string(boxes.size()) + " should be "
+                                                                         + (isVisible ? "visible" : "culled"));
+            boxes.push_back(bounds);
+        }
+
+        for (const auto kernel : KERNELS)
+        {
+            if (!utils::isCullKernelSupported(kernel))
+                continue;
+
+            const auto batch = createBatch(boxes);
+            std::vector<std::uint8_t> visible(boxes.size());
+            batch.cull(frustum, visible, kernel);
+            for (std::size_t i = 0; i < cases.size(); ++i)
+                tests::check(visible[i] == (cases[i].second ? 1 : 0), std::string(getKernelName(kernel)) + " got box " + std::to_string(i) + " wrong");
+        }
+    }
+
+    // every batch size up to a few groups, so each kernel's remainder path runs
+    const auto boxes = createBoxes(10007, 1);
+    for (const auto kernel : KERNELS)
+    {
+        if (!utils::isCullKernelSupported(kernel))
+            continue;
+
+        for (std::size_t count = 0; count <= 19; ++count)
+            checkKernel(kernel, frustum, std::vector<utils::Bounds>(boxes.begin(), boxes.begin() + static_cast<std::ptrdiff_t>(count)));
+
+        // and a large batch, which has to have both visible and culled boxes to mean anything
+        const std::size_t visibleCount = checkKernel(kernel, frustum, boxes);
+        tests::check(visibleCount > 0 && visibleCount < boxes.size(), "Random boxes are all visible or all culled");
+    }
+
+    // the default is the widest kernel there is, unsupported ones are refused
+    tests::check(utils::isCullKernelSupported(utils::getBestCullKernel()), "The best kernel isn't supported");
+    for (const auto kernel : KERNELS)
+    {
+        if (utils::isCullKernelSupported(kernel))
+        {
+            tests::check(static_cast<int>(kernel) <= static_cast<int>(utils::getBestCullKernel()), "A wider kernel than the best is supported");
+            continue;
+        }
+
+        bool isRefused = false;
+        try
+        {
+            std::vector<std::uint8_t> visible(boxes.size());
+            createBatch(boxes).cull(frustum, visible, kernel);
+        }
+        catch (const std::runtime_error&)
+        {
+            isRefused = true;
+        }
+        tests::check(isRefused, std::string("Unsupported ") + getKernelName(kernel) + " kernel ran");
+    }
+
+    bool isRefused = false;
+    try
+    {
+        std::vector<std::uint8_t> visible(boxes.size() - 1);
+        createBatch(boxes).cull(frustum, visible);
+    }
+    catch (const std::runtime_error&)
+    {
+        isRefused = true;
+    }
+    tests::check(isRefused, "Culled into a result smaller than the batch");
+}
+
+void tests::benchmarkFrustumCulling()
+{
+    const auto frustum = createFrustum();
+    for (const std::size_t count : { std::size_t(100000), std::size_t(1000000) })
+    {
+        const auto batch = createBatch(createBoxes(count, 2));
+        std::vector<std::uint8_t> visible(count);
+
+        std::cout << "Frustum culling of " << count << " boxes:";
+        for (const auto kernel : KERNELS)
+        {
+            if (!utils::isCullKernelSupported(kernel))
+            {
+                std::cout << ' ' << getKernelName(kernel) << " unsupported;";
+                continue;
+            }
+
+            const double milliseconds = tests::measureMilliseconds(20, [&]() { batch.cull(frustum, visible, kernel); });
+            std::cout << ' ' << getKernelName(kernel) << ' ' << milliseconds << " ms (" << static_cast<double>(count) / (milliseconds * 1e3)
+                      << " MBoxes/s);";
+        }
+        std::cout << " the default is " << getKernelName(utils::getBestCullKernel()) << '\n';
+    }
+}
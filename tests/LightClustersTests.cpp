@@ -0,0 +1,269 @@
+#include "Tests.hpp"
+
+#include "LightClusters.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+static constexpr float NEAR = 0.1f;
+static constexpr float FAR = 100.0f;
+static constexpr float TAN_HALF_FOV_Y = 0.57735027f; // 60 degrees
+static constexpr float ASPECT_RATIO = 16.0f / 9.0f;
+
+struct Scene
+{
+    glm::mat4 d_view;
+    glm::mat4 d_projection;
+    std::vector<utils::PointLightUniforms> d_pointLights;
+    std::vector<utils::SpotLightUniforms> d_spotLights;
+};
+
+// the view space position at i_ndc in [-1, 1] and i_depth in front of the camera
+glm::vec3 getFrustumPosition(const glm::vec2& i_ndc, float i_depth)
+{
+    return glm::vec3(i_ndc * glm::vec2(TAN_HALF_FOV_Y * ASPECT_RATIO, TAN_HALF_FOV_Y) * i_depth, -i_depth);
+}
+
+// lights spread evenly through a city block sized box around the frustum, some of them behind the camera, with ranges from 0.5 to 4 units
+Scene createScene(std::size_t i_pointLightsCount, std::size_t i_spotLightsCount, unsigned int i_seed)
+{
+    Scene scene;
+    scene.d_view = glm::lookAt(glm::vec3(0.0f, 2.0f, 5.0f), glm::vec3(0.0f, 0.0f, -20.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    scene.d_projection = glm::perspective(glm::radians(60.0f), ASPECT_RATIO, NEAR, FAR);
+
+    std::mt19937 random(i_seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> range(0.5f, 4.0f);
+    const auto getPosition = [&]()
+    {
+        return glm::vec3(-80.0f + 160.0f * unit(random), -10.0f + 50.0f * unit(random), -105.0f + 120.0f * unit(random));
+    };
+    // the brightest channel is 1, so the range is where 1 / (1 + quadratic * d^2) reaches 1/256
+    const auto getQuadratic = [&]()
+    {
+        const float lightRange = range(random);
+        return 255.0f / (lightRange * lightRange);
+    };
+
+    scene.d_pointLights.resize(i_pointLightsCount);
+    for (auto& light : scene.d_pointLights)
+    {
+        light.d_position = getPosition();
+        light.d_diffuse = glm::vec3(1.0f, unit(random), unit(random));
+        light.d_quadratic = getQuadratic();
+    }
+
+    std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> outerCutOff(0.0f, 0.99f);
+    scene.d_spotLights.resize(i_spotLightsCount);
+    for (auto& light : scene.d_spotLights)
+    {
+        light.d_position = getPosition();
+        light.d_direction = glm::vec3(direction(random), direction(random), direction(random)) + glm::vec3(0.0f, 0.0f, 0.01f);
+        light.d_outerCutOff = outerCutOff(random);
+        light.d_cutOff = std::min(light.d_outerCutOff + 0.01f, 1.0f);
+        light.d_specular = glm::vec3(unit(random), 1.0f, unit(random));
+        light.d_quadratic = getQuadratic();
+    }
+    return scene;
+}
+
+// how far inside a light's volume a world space position is, relative to its range: negative outside.
+// The exact volume, a spot light's is its cone, not the sphere around it the clusters are built from
+float getLightDepth(const utils::PointLightUniforms& i_light, float i_range, const glm::vec3& i_position)
+{
+    return 1.0f - glm::length(i_position - i_light.d_position) / i_range;
+}
+
+float getLightDepth(const utils::SpotLightUniforms& i_light, float i_range, const glm::vec3& i_position)
+{
+    const glm::vec3 toPosition = i_position - i_light.d_position;
+    const float distance = glm::length(toPosition);
+    const float cosAngle = glm::dot(toPosition, glm::normalize(i_light.d_direction)) / distance;
+    return std::min(1.0f - distance / i_range, cosAngle - i_light.d_outerCutOff);
+}
+
+// the fraction of i_value past its integer part, how close a coordinate is to a cluster's side
+float getCellFraction(float i_value)
+{
+    return i_value - std::floor(i_value);
+}
+}
+
+void tests::testLightClusters()
+{
+    static constexpr std::size_t POINT_LIGHTS_COUNT = 10000;
+    static constexpr std::size_t SPOT_LIGHTS_COUNT = 1000;
+    static constexpr std::size_t SAMPLES_COUNT = 20000;
+    // positions this close to a light's volume or a cluster's side may go either way with float rounding
+    static constexpr float MARGIN = 1e-3f;
+
+    const auto scene = createScene(POINT_LIGHTS_COUNT, SPOT_LIGHTS_COUNT, 1);
+    // large enough for the densest cluster, nothing is dropped
+    utils::LightClusters clusters(glm::uvec3(16, 9, 24), POINT_LIGHTS_COUNT + SPOT_LIGHTS_COUNT);
+    clusters.build(scene.d_view, scene.d_projection, scene.d_pointLights, scene.d_spotLights);
+
+    const auto& stats = clusters.getStats();
+    const auto clusterRanges = clusters.getClusters();
+    const auto lightIndices = clusters.getLightIndices();
+    tests::check(stats.d_lightsCount == POINT_LIGHTS_COUNT + SPOT_LIGHTS_COUNT, "Wrong lights count " + std::to_string(stats.d_lightsCount));
+    tests::check(stats.d_droppedLights == 0, std::to_string(stats.d_droppedLights) + " lights dropped under the limit");
+    tests::check(stats.d_lightIndicesCount == lightIndices.size(), "Stats and light indices disagree");
+    tests::check(stats.d_visibleLightsCount > 0 && stats.d_visibleLightsCount < stats.d_lightsCount,
+                 "All lights or none visible: " + std::to_string(stats.d_visibleLightsCount));
+
+    // the clusters tile the light indices in order, every cluster's lights sorted by index
+    std::uint32_t nextOffset = 0;
+    for (const auto& range : clusterRanges)
+    {
+        tests::check(range.x == nextOffset, "Cluster light indices not packed");
+        const auto clusterLights = lightIndices.subspan(range.x, range.y);
+        tests::check(std::adjacent_find(clusterLights.begin(), clusterLights.end(), std::greater_equal<>()) == clusterLights.end(),
+                     "Cluster lights not sorted by index");
+        nextOffset += range.y;
+    }
+    tests::check(nextOffset == lightIndices.size(), "Light indices past the last cluster");
+
+    // brute force: the cluster of a random position in the frustum, found like the shaders do, has every light reaching it
+    const auto& gridSize = clusters.getGridSize();
+    const auto uniforms = clusters.getUniforms(glm::vec2(1920.0f, 1080.0f));
+    const glm::mat4 inverseView = glm::inverse(scene.d_view);
+    std::mt19937 random(2);
+    std::uniform_real_distribution<float> ndc(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<float> pointRanges;
+    for (const auto& light : scene.d_pointLights)
+        pointRanges.push_back(utils::getLightRange(light));
+    std::vector<float> spotRanges;
+    for (const auto& light : scene.d_spotLights)
+        spotRanges.push_back(utils::getLightRange(light));
+
+    std::size_t reachedCount = 0;
+    for (std::size_t sample = 0; sample < SAMPLES_COUNT; ++sample)
+    {
+        const glm::vec2 sampleNdc(ndc(random), ndc(random));
+        const glm::vec3 viewPosition = getFrustumPosition(sampleNdc, NEAR + (FAR - NEAR) * unit(random));
+        const glm::vec2 tile = (sampleNdc * 0.5f + 0.5f) * glm::vec2(gridSize);
+        const float slice = std::log(-viewPosition.z) * uniforms.d_depthParams.x + uniforms.d_depthParams.y;
+        const auto isNearSide = [](float i_coordinate) { return getCellFraction(i_coordinate) < MARGIN || getCellFraction(i_coordinate) > 1.0f - MARGIN; };
+        if (isNearSide(tile.x) || isNearSide(tile.y) || isNearSide(slice))
+            continue;
+
+        const auto cell = glm::min(glm::uvec3(glm::vec3(tile, slice)), gridSize - 1u);
+        const auto& range = clusterRanges[(cell.z * gridSize.y + cell.y) * gridSize.x + cell.x];
+        const auto clusterLights = lightIndices.subspan(range.x, range.y);
+        const auto checkLight = [&](std::uint32_t i_light)
+        {
+            ++reachedCount;
+            tests::check(std::binary_search(clusterLights.begin(), clusterLights.end(), i_light),
+                         "Light " + std::to_string(i_light) + " reaches cluster " + std::to_string(cell.x) + ", " + std::to_string(cell.y) + ", "
+                             + std::to_string(cell.z) + " but isn't in it");
+        };
+
+        const glm::vec3 position = glm::vec3(inverseView * glm::vec4(viewPosition, 1.0f));
+        for (std::size_t light = 0; light < scene.d_pointLights.size(); ++light)
+        {
+            if (getLightDepth(scene.d_pointLights[light], pointRanges[light], position) > MARGIN)
+                checkLight(static_cast<std::uint32_t>(light));
+        }
+        for (std::size_t light = 0; light < scene.d_spotLights.size(); ++light)
+        {
+            if (getLightDepth(scene.d_spotLights[light], spotRanges[light], position) > MARGIN)
+                checkLight(static_cast<std::uint32_t>(scene.d_pointLights.size() + light));
+        }
+    }
+    tests::check(reachedCount > SAMPLES_COUNT / 4, "Too few lit samples to mean anything: " + std::to_string(reachedCount));
+
+    // The other way, the binning is conservative but only as far as a light's bounds: its view space bounding box overlaps
+    // the bounding box of every cluster it is in. A spot light's cone is inside the sphere of range * sqrt(2) around its apex
+    std::vector<glm::vec4> lightSpheres;
+    for (std::size_t light = 0; light < scene.d_pointLights.size(); ++light)
+        lightSpheres.push_back(glm::vec4(glm::vec3(scene.d_view * glm::vec4(scene.d_pointLights[light].d_position, 1.0f)), pointRanges[light]));
+    for (std::size_t light = 0; light < scene.d_spotLights.size(); ++light)
+        lightSpheres.push_back(glm::vec4(glm::vec3(scene.d_view * glm::vec4(scene.d_spotLights[light].d_position, 1.0f)), spotRanges[light] * 1.4142136f));
+
+    const glm::vec2 tanHalfFov(TAN_HALF_FOV_Y * ASPECT_RATIO, TAN_HALF_FOV_Y);
+    for (std::uint32_t cluster = 0; cluster < clusterRanges.size(); ++cluster)
+    {
+        const glm::uvec3 cell(cluster % gridSize.x, cluster / gridSize.x % gridSize.y, cluster / (gridSize.x * gridSize.y));
+        const float nearDepth = NEAR * std::pow(FAR / NEAR, static_cast<float>(cell.z) / static_cast<float>(gridSize.z));
+        const float farDepth = NEAR * std::pow(FAR / NEAR, static_cast<float>(cell.z + 1) / static_cast<float>(gridSize.z));
+        const glm::vec2 lowNdc = glm::vec2(static_cast<float>(cell.x), static_cast<float>(cell.y)) / glm::vec2(gridSize) * 2.0f - 1.0f;
+        const glm::vec2 highNdc = glm::vec2(static_cast<float>(cell.x + 1), static_cast<float>(cell.y + 1)) / glm::vec2(gridSize) * 2.0f - 1.0f;
+        const glm::vec3 low(glm::min(lowNdc * tanHalfFov * nearDepth, lowNdc * tanHalfFov * farDepth), -farDepth);
+        const glm::vec3 high(glm::max(highNdc * tanHalfFov * nearDepth, highNdc * tanHalfFov * farDepth), -nearDepth);
+
+        for (const auto light : lightIndices.subspan(clusterRanges[cluster].x, clusterRanges[cluster].y))
+        {
+            const glm::vec4& sphere = lightSpheres[light];
+            const float tolerance = MARGIN * (1.0f + sphere.w);
+            const glm::vec3 center(sphere);
+            bool isOverlapping = true;
+            for (int axis = 0; axis < 3; ++axis)
+                isOverlapping = isOverlapping && center[axis] - sphere.w <= high[axis] + tolerance && center[axis] + sphere.w + tolerance >= low[axis];
+            tests::check(isOverlapping, "Light " + std::to_string(light) + " is in cluster " + std::to_string(cell.x) + ", " + std::to_string(cell.y)
+                                            + ", " + std::to_string(cell.z) + " far from its bounds");
+        }
+    }
+}
+
+void tests::testLightClusterBuffers()
+{
+    // the light buffer takes 5 texels per light, the lights of the benchmarks fit the GL 3.3 minimum of 65536 texels
+    const auto scene = createScene(9000, 1000, 4);
+    utils::LightClusters clusters;
+    clusters.build(scene.d_view, scene.d_projection, scene.d_pointLights, scene.d_spotLights);
+    utils::LightClusterBuffers buffers(clusters);
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    tests::check(buffers.getMaxLightsCount() == static_cast<std::size_t>(maxTexels) / 5,
+                 std::to_string(buffers.getMaxLightsCount()) + " lights allowed in " + std::to_string(maxTexels) + " texels");
+    buffers.update(clusters, scene.d_pointLights, scene.d_spotLights, glm::vec2(1280.0f, 720.0f));
+    tests::check(glGetError() == GL_NO_ERROR, "Uploading the lights raised a GL error");
+
+    // one light more than the buffer holds is refused instead of read out of range, where the limit is small enough to allocate them
+    if (buffers.getMaxLightsCount() >= 1000000)
+        return;
+    const std::vector<utils::PointLightUniforms> pointLights(buffers.getMaxLightsCount() + 1);
+    bool isRefused = false;
+    try
+    {
+        buffers.update(clusters, pointLights, {}, glm::vec2(1280.0f, 720.0f));
+    }
+    catch (const std::runtime_error&)
+    {
+        isRefused = true;
+    }
+    tests::check(isRefused, std::to_string(pointLights.size()) + " lights were uploaded to " + std::to_string(maxTexels) + " texels");
+}
+
+void tests::benchmarkLightClusters()
+{
+    for (const std::size_t lightsCount : { std::size_t(1000), std::size_t(10000), std::size_t(50000) })
+    {
+        const auto scene = createScene(lightsCount - lightsCount / 10, lightsCount / 10, 3);
+        utils::LightClusters clusters;
+        const double milliseconds = tests::measureMilliseconds(10, [&]()
+        {
+            clusters.build(scene.d_view, scene.d_projection, scene.d_pointLights, scene.d_spotLights);
+        });
+
+        const auto& stats = clusters.getStats();
+        std::cout << "Light clusters: " << lightsCount << " lights (" << stats.d_visibleLightsCount << " visible) binned in " << milliseconds << " ms, "
+                  << stats.d_lightIndicesCount << " light indices, at most " << stats.d_maxClusterLights << " per cluster, " << stats.d_droppedLights
+                  << " dropped\n";
+    }
+}
@@ -0,0 +1,189 @@
+#include "Tests.hpp"
+
+#include "Mesh.hpp"
+#include "MeshSimplifier.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+// closed unit sphere, the seam and the poles share their vertices so no edge is a border
+utils::MeshData createSphere(unsigned int i_rings, unsigned int i_segments)
+{
+    utils::MeshData mesh;
+    const auto addVertex = [&mesh](const glm::vec3& i_position)
+    {
+        mesh.d_vertices.push_back({ i_position, i_position, glm::vec2(0.0f) });
+    };
+
+    addVertex(glm::vec3(0.0f, 1.0f, 0.0f));
+    for (unsigned int ring = 1; ring < i_rings; ++ring)
+    {
+        const float theta = 3.14159265f * static_cast<float>(ring) / static_cast<float>(i_rings);
+        for (unsigned int segment = 0; segment < i_segments; ++segment)
+        {
+            const float phi = 6.28318531f * static_cast<float>(segment) / static_cast<float>(i_segments);
+            addVertex(glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+        }
+    }
+    addVertex(glm::vec3(0.0f, -1.0f, 0.0f));
+
+    const auto ringVertex = [i_segments](unsigned int i_ring, unsigned int i_segment)
+    {
+        return 1 + (i_ring - 1) * i_segments + i_segment % i_segments;
+    };
+    const auto southPole = static_cast<unsigned int>(mesh.d_vertices.size() - 1);
+    for (unsigned int segment = 0; segment < i_segments; ++segment)
+    {
+        mesh.d_indices.insert(mesh.d_indices.end(), { 0, ringVertex(1, segment + 1), ringVertex(1, segment) });
+        for (unsigned int ring = 1; ring + 1 < i_rings; ++ring)
+        {
+            const unsigned int a = ringVertex(ring, segment);
+            const unsigned int b = ringVertex(ring, segment + 1);
+            const unsigned int c = ringVertex(ring + 1, segment);
+            const unsigned int d = ringVertex(ring + 1, segment + 1);
+            mesh.d_indices.insert(mesh.d_indices.end(), { a, b, c, b, d, c });
+        }
+        mesh.d_indices.insert(mesh.d_indices.end(), { southPole, ringVertex(i_rings - 1, segment), ringVertex(i_rings - 1, segment + 1) });
+    }
+    return mesh;
+}
+
+// flat square of i_size x i_size quads in the xz plane, its outline is a border
+utils::MeshData createGrid(unsigned int i_size)
+{
+    utils::MeshData mesh;
+    for (unsigned int z = 0; z <= i_size; ++z)
+    {
+        for (unsigned int x = 0; x <= i_size; ++x)
+            mesh.d_vertices.push_back({ glm::vec3(static_cast<float>(x), 0.0f, static_cast<float>(z)), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.0f) });
+    }
+    for (unsigned int z = 0; z < i_size; ++z)
+    {
+        for (unsigned int x = 0; x < i_size; ++x)
+        {
+            const unsigned int a = z * (i_size + 1) + x;
+            const unsigned int c = a + i_size + 1;
+            mesh.d_indices.insert(mesh.d_indices.end(), { a, c, a + 1, a + 1, c, c + 1 });
+        }
+    }
+    return mesh;
+}
+
+void checkTriangles(const std::vector<unsigned int>& i_indices, std::size_t i_verticesCount)
+{
+    tests::check(i_indices.size() % 3 == 0, "Indices are not whole triangles");
+    for (std::size_t i = 0; i < i_indices.size(); i += 3)
+    {
+        const unsigned int a = i_indices[i];
+        const unsigned int b = i_indices[i + 1];
+        const unsigned int c = i_indices[i + 2];
+        tests::check(a < i_verticesCount && b < i_verticesCount && c < i_verticesCount, "Index out of the vertex buffer");
+        tests::check(a != b && b != c && a != c, "Degenerate triangle " + std::to_string(i / 3));
+    }
+}
+}
+
+void tests::testMeshSimplifier()
+{
+    // a closed mesh reaches the target and stays close to its surface
+    {
+        const auto sphere = createSphere(32, 64);
+        const std::size_t targetIndicesCount = sphere.d_indices.size() / 4 / 3 * 3;
+        float error = -1.0f;
+        const auto indices = utils::simplifyMesh(sphere.d_vertices, sphere.d_indices, targetIndicesCount, 0.1f, &error);
+
+        checkTriangles(indices, sphere.d_vertices.size());
+        tests::check(indices.size() <= targetIndicesCount, "Sphere not reduced to its target: " + std::to_string(indices.size()) + " indices");
+        tests::check(indices.size() >= targetIndicesCount / 2, "Sphere reduced far past its target: " + std::to_string(indices.size()) + " indices");
+        // the extent of the unit sphere is 2
+        tests::check(error > 0.0f && error <= 0.1f * 2.0f, "Sphere error out of range: " + std::to_string(error));
+    }
+
+    // the error bound stops the collapses before the target
+    {
+        const auto sphere = createSphere(32, 64);
+        float error = -1.0f;
+        const auto indices = utils::simplifyMesh(sphere.d_vertices, sphere.d_indices, 0, 0.01f, &error);
+
+        checkTriangles(indices, sphere.d_vertices.size());
+        tests::check(!indices.empty(), "Error bound collapsed the whole sphere");
+        tests::check(error <= 0.01f * 2.0f, "Error bound exceeded: " + std::to_string(error));
+    }
+
+    // a plane loses its inner vertices without any error, its border doesn't move
+    {
+        static constexpr unsigned int GRID_SIZE = 16;
+        const auto grid = createGrid(GRID_SIZE);
+        float error = -1.0f;
+        const auto indices = utils::simplifyMesh(grid.d_vertices, grid.d_indices, 0, 0.01f, &error);
+
+        checkTriangles(indices, grid.d_vertices.size());
+        tests::check(indices.size() < grid.d_indices.size() / 4, "Plane barely simplified: " + std::to_string(indices.size()) + " indices");
+        tests::check(error < 1e-4f, "Plane simplified with an error: " + std::to_string(error));
+
+        std::vector<bool> isUsed(grid.d_vertices.size(), false);
+        for (const auto index : indices)
+            isUsed[index] = true;
+        for (std::size_t i = 0; i < grid.d_vertices.size(); ++i)
+        {
+            const auto& position = grid.d_vertices[i].d_position;
+            const bool isCorner = (position.x == 0.0f || position.x == GRID_SIZE) && (position.z == 0.0f || position.z == GRID_SIZE);
+            tests::check(!isCorner || isUsed[i], "Corner vertex " + std::to_string(i) + " collapsed");
+        }
+    }
+
+    // the chain shrinks from LOD to LOD and its errors add up
+    {
+        auto sphere = createSphere(32, 64);
+        const std::size_t lod0IndicesCount = sphere.d_indices.size();
+        utils::generateLods(sphere, 4, 0.5f, 0.1f);
+
+        tests::check(sphere.d_lods.size() == 4, "Expected 4 LODs, got " + std::to_string(sphere.d_lods.size()));
+        tests::check(sphere.d_lods[0].d_indexOffset == 0 && sphere.d_lods[0].d_indicesCount == lod0IndicesCount, "LOD 0 isn't the source mesh");
+        for (std::size_t lod = 1; lod < sphere.d_lods.size(); ++lod)
+        {
+            const auto& previous = sphere.d_lods[lod - 1];
+            const auto& current = sphere.d_lods[lod];
+            tests::check(current.d_indexOffset == previous.d_indexOffset + previous.d_indicesCount, "LOD " + std::to_string(lod) + " not packed");
+            tests::check(current.d_indicesCount < previous.d_indicesCount, "LOD " + std::to_string(lod) + " not smaller");
+            tests::check(current.d_error >= previous.d_error, "LOD " + std::to_string(lod) + " error decreased");
+
+            const std::vector<unsigned int> indices(sphere.d_indices.begin() + current.d_indexOffset,
+                                                    sphere.d_indices.begin() + current.d_indexOffset + current.d_indicesCount);
+            checkTriangles(indices, sphere.d_vertices.size());
+        }
+        tests::check(sphere.d_indices.size() == sphere.d_lods.back().d_indexOffset + sphere.d_lods.back().d_indicesCount, "Indices past the last LOD");
+    }
+}
+
+void tests::benchmarkMeshSimplifier()
+{
+    // about 260k triangles, the size of a detailed asset's mesh
+    const auto sphere = createSphere(256, 512);
+    const std::size_t trianglesCount = sphere.d_indices.size() / 3;
+
+    std::size_t halfIndicesCount = 0;
+    const double halfMilliseconds = tests::measureMilliseconds(3, [&]()
+    {
+        halfIndicesCount = utils::simplifyMesh(sphere.d_vertices, sphere.d_indices, sphere.d_indices.size() / 2 / 3 * 3, 0.05f).size();
+    });
+
+    std::size_t lodsCount = 0;
+    const double lodsMilliseconds = tests::measureMilliseconds(3, [&]()
+    {
+        auto mesh = sphere;
+        utils::generateLods(mesh, 4, 0.5f, 0.05f);
+        lodsCount = mesh.d_lods.size();
+    });
+
+    std::cout << "Mesh simplifier: " << trianglesCount << " triangles halved to " << halfIndicesCount / 3 << " in " << halfMilliseconds << " ms ("
+              << static_cast<double>(trianglesCount) / (halfMilliseconds * 1e3) << " MTriangles/s), " << lodsCount << " LODs generated in "
+              << lodsMilliseconds << " ms\n";
+}
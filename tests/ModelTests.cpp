@@ -0,0 +1,47 @@
+#include "Tests.hpp"
+
+#include "AssetRegistry.hpp"
+#include "Model.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace
+{
+// a quad facing +z, written next to the tests so the models have a file to import
+std::filesystem::path writeQuadModel()
+{
+    const std::filesystem::path path = "model_tests_quad.obj";
+    std::ofstream file(path);
+    file << "v -1 -1 0\nv 1 -1 0\nv 1 1 0\nv -1 1 0\n"
+         << "vn 0 0 1\nvn 0 0 1\nvn 0 0 1\nvn 0 0 1\n"
+         << "f 1//1 2//2 3//3\nf 1//1 3//3 4//4\n";
+    return path;
+}
+}
+
+void tests::testModelMeshSharing()
+{
+    const std::string file = writeQuadModel().string();
+    const std::string_view path = file;
+    auto& registry = utils::AssetRegistry::getInstance();
+
+    // models loaded with the same options share their meshes
+    const auto startStats = registry.getStats().d_meshes;
+    const utils::Model model(path);
+    const utils::Model sameModel(path);
+    const auto sharedStats = registry.getStats().d_meshes;
+    tests::check(sharedStats.d_liveCount == startStats.d_liveCount + 1, "Models with the same options don't share their mesh");
+    tests::check(sharedStats.d_reusedCount == startStats.d_reusedCount + 1, "The shared mesh wasn't counted as reused");
+
+    // the material of a mesh is its textures, a model compressing them can't take the mesh of one that doesn't
+    utils::ModelOptions compressedOptions;
+    compressedOptions.d_compressTextures = true;
+    const utils::Model compressedModel(path, compressedOptions);
+    const auto compressedStats = registry.getStats().d_meshes;
+    tests::check(compressedStats.d_liveCount == sharedStats.d_liveCount + 1,
+                 "A model with compressed textures got the mesh of one without, " + std::to_string(compressedStats.d_liveCount) + " live meshes");
+    tests::check(compressedStats.d_reusedCount == sharedStats.d_reusedCount, "A model with compressed textures reused a mesh");
+}
@@ -0,0 +1,45 @@
+#include "Tests.hpp"
+
+#include "GLObject.hpp"
+#include "Hash.hpp"
+#include "ProgramCache.hpp"
+#include "ShaderVariants.hpp"
+#include "ShadersManager.hpp"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+void tests::testProgramCache()
+{
+    if (!utils::ProgramCache::isSupported())
+        return;
+
+    // the entry of a program the application draws with, under a key of its own
+    utils::ShaderVariants variants("shaders/vertex.vs", "shaders/fragment.fs");
+    const auto sourcesHash = utils::fnv1a("program cache test");
+    utils::ProgramCache(sourcesHash).store(variants.get(0).getId(), 1.0);
+    utils::ProgramCache cache(sourcesHash);
+    const auto path = cache.getCachePath();
+    tests::check(cache.load(utils::ProgramHandle::create().get()), "The stored binary wasn't loaded");
+
+    // a binary size past the end of the file is a miss, not an allocation of that size
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        static constexpr std::streamoff BINARY_SIZE_OFFSET = 24; // after the magic, version, format and key
+        const std::uint64_t binarySize = std::numeric_limits<std::uint64_t>::max() / 2;
+        file.seekp(BINARY_SIZE_OFFSET);
+        file.write(reinterpret_cast<const char*>(&binarySize), sizeof(binarySize));
+    }
+    tests::check(!cache.load(utils::ProgramHandle::create().get()), "A binary larger than its file was loaded");
+
+    // so is a truncated binary
+    utils::ProgramCache(sourcesHash).store(variants.get(0).getId(), 1.0);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    tests::check(!cache.load(utils::ProgramHandle::create().get()), "A truncated binary was loaded");
+    tests::check(!cache.isRejected(), "A truncated binary was given to the driver");
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,85 @@
+#include "Tests.hpp"
+
+#include "ShaderVariants.hpp"
+#include "ShadersManager.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <string>
+#include <string_view>
+
+namespace
+{
+// every uniform with a location is found at the one the driver has for it, through its plain name for arrays
+void checkReflection(const utils::ShadersManager& i_shaders, const std::string& i_name)
+{
+    const GLuint program = i_shaders.getId();
+    GLint uniformsCount = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformsCount);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    int locationsCount = 0;
+    std::string name(static_cast<std::size_t>(maxNameLength), '\0');
+    for (GLint i = 0; i < uniformsCount; ++i)
+    {
+        GLsizei nameLength = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, static_cast<GLuint>(i), maxNameLength, &nameLength, &size, &type, name.data());
+        std::string_view uniformName(name.data(), static_cast<std::size_t>(nameLength));
+        const GLint location = glGetUniformLocation(program, name.c_str());
+        if (uniformName.ends_with("[0]"))
+            uniformName.remove_suffix(3);
+
+        const GLint reflectedLocation = i_shaders.getUniformLocation(utils::UniformId::fromName(uniformName));
+        tests::check(reflectedLocation == location, i_name + ' ' + std::string(uniformName) + " reflected at " + std::to_string(reflectedLocation)
+                                                        + ", the driver has it at " + std::to_string(location));
+        locationsCount += location != -1;
+    }
+    tests::check(locationsCount > 0, i_name + " has no uniforms outside of blocks, nothing was checked");
+    tests::check(i_shaders.getUniformLocation("notAUniform") == -1, i_name + " found a uniform it doesn't have");
+}
+}
+
+void tests::testShadersManager()
+{
+    // literals are hashed at compile time, to what their names hash to at runtime
+    {
+        static constexpr utils::UniformId MODEL_UNIFORM = "model";
+        const std::string modelName = "model";
+        tests::check(MODEL_UNIFORM.d_hash == utils::UniformId::fromName(modelName).d_hash, "Compile time and runtime hashes differ");
+        tests::check(std::string_view(MODEL_UNIFORM.d_name) == "model", "The literal's name isn't kept");
+        tests::check(utils::UniformId::fromName(modelName).d_name == nullptr, "A runtime name is kept");
+        tests::check(utils::UniformId("model").d_hash != utils::UniformId("modeL").d_hash, "Different names hash the same");
+    }
+}
+
+void tests::testShadersManagerReflection()
+{
+    // the variants the application draws with, between them every kind of uniform: matrices, samplers, arrays and floats
+    utils::ShaderVariants variants("shaders/vertex.vs", "shaders/fragment.fs");
+    static constexpr utils::ShaderFeatures FEATURES[] = {
+        0,
+        utils::SHADER_DIR_LIGHT | utils::SHADER_SPECULAR_MAP,
+        utils::SHADER_DIR_LIGHT | utils::SHADER_CLUSTERED_LIGHTS | utils::SHADER_TEXTURE_ARRAY | utils::SHADER_SPECULAR_MAP,
+        utils::SHADER_DIR_LIGHT | utils::SHADER_CLUSTERED_LIGHTS | utils::SHADER_DEFERRED_LIGHTING,
+    };
+    for (const auto features : FEATURES)
+        checkReflection(variants.get(features), "Variant " + std::to_string(features));
+
+    // setting a uniform goes to the reflected location, a missing one is ignored like GL ignores location -1
+    const auto& shaders = variants.get(0);
+    shaders.render();
+    const glm::mat4 model(glm::vec4(1.0f, 2.0f, 3.0f, 0.0f), glm::vec4(4.0f, 5.0f, 6.0f, 0.0f), glm::vec4(7.0f, 8.0f, 9.0f, 0.0f),
+                          glm::vec4(10.0f, 11.0f, 12.0f, 1.0f));
+    shaders.setMatrix4fv("model", model);
+    shaders.setFloat("notAUniform", 1.0f);
+    tests::check(glGetError() == GL_NO_ERROR, "Setting uniforms raised a GL error");
+
+    glm::mat4 readModel(0.0f);
+    glGetUniformfv(shaders.getId(), glGetUniformLocation(shaders.getId(), "model"), glm::value_ptr(readModel));
+    tests::check(readModel == model, "The model matrix didn't reach its uniform");
+}
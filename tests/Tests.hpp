@@ -0,0 +1,61 @@
+#ifndef __TESTS_HPP__
+#define __TESTS_HPP__
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace utils
+{
+struct ImageData;
+}
+
+namespace tests
+{
+// throws std::runtime_error with i_message if i_condition doesn't hold, which fails the running test
+void check(bool i_condition, const std::string& i_message);
+
+// the fastest of i_runs calls of i_func in milliseconds, the first run warms the caches up like any other
+template <typename Func>
+double measureMilliseconds(std::size_t i_runs, Func&& i_func)
+{
+    double bestMilliseconds = 0.0;
+    for (std::size_t run = 0; run < i_runs; ++run)
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        i_func();
+        const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        if (run == 0 || milliseconds < bestMilliseconds)
+            bestMilliseconds = milliseconds;
+    }
+    return bestMilliseconds;
+}
+
+// i_width x i_height image of i_channels channels, i_pixel(x, y, channel) gives every value
+utils::ImageData createImage(int i_width, int i_height, int i_channels, const std::function<std::uint8_t(int, int, int)>& i_pixel);
+
+// GL cases run in a hidden window of this size, its default framebuffer has GLFW's default 24 bit depth and 8 bit stencil buffer
+static constexpr int GL_WINDOW_SIZE = 64;
+
+// tests and benchmarks of every module, registered in TestsMain.cpp
+void testMeshSimplifier();
+void benchmarkMeshSimplifier();
+void testFrustumCulling();
+void benchmarkFrustumCulling();
+void testLightClusters();
+void testLightClusterBuffers();
+void benchmarkLightClusters();
+void testTextureCompression();
+void benchmarkTextureCompression();
+void testShadersManager();
+void testShadersManagerReflection();
+void testProgramCache();
+void testTextureArray();
+void testTextureArrayLayers();
+void testDeferredRenderer();
+void testModelMeshSharing();
+}
+
+#endif // __TESTS_HPP__
@@ -0,0 +1,134 @@
+#include "Tests.hpp"
+
+#include <glad/glad.h> // should be included first
+#include <GLFW/glfw3.h>
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+struct TestCase
+{
+    const char* d_name;
+    void (*d_run)();
+    bool d_isUsingGL = false; // skipped where no OpenGL 3.3 context can be created
+};
+
+// The hidden window the GL cases run in, created by the first of them and current until the end of the run
+class GLContext
+{
+public:
+    ~GLContext()
+    {
+        if (d_window)
+            glfwDestroyWindow(d_window);
+        if (d_isInitialized)
+            glfwTerminate();
+    }
+
+    bool isAvailable()
+    {
+        if (d_isCreated)
+            return d_window != nullptr;
+        d_isCreated = true;
+
+        d_isInitialized = glfwInit();
+        if (!d_isInitialized)
+            return false;
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        d_window = glfwCreateWindow(tests::GL_WINDOW_SIZE, tests::GL_WINDOW_SIZE, "learnopengl_tests", nullptr, nullptr);
+        if (!d_window)
+            return false;
+
+        glfwMakeContextCurrent(d_window);
+        if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+        {
+            glfwDestroyWindow(d_window);
+            d_window = nullptr;
+        }
+        return d_window != nullptr;
+    }
+
+private:
+    GLFWwindow* d_window = nullptr;
+    bool d_isCreated = false;
+    bool d_isInitialized = false;
+};
+
+static constexpr TestCase TESTS[] = {
+    { "MeshSimplifier", tests::testMeshSimplifier },
+    { "FrustumCulling", tests::testFrustumCulling },
+    { "LightClusters", tests::testLightClusters },
+    { "LightClusterBuffers", tests::testLightClusterBuffers, true },
+    { "TextureCompression", tests::testTextureCompression },
+    { "ShadersManager", tests::testShadersManager },
+    { "ShadersManagerReflection", tests::testShadersManagerReflection, true },
+    { "ProgramCache", tests::testProgramCache, true },
+    { "TextureArray", tests::testTextureArray },
+    { "TextureArrayLayers", tests::testTextureArrayLayers, true },
+    { "DeferredRenderer", tests::testDeferredRenderer, true },
+    { "ModelMeshSharing", tests::testModelMeshSharing, true },
+};
+
+static constexpr TestCase BENCHMARKS[] = {
+    { "MeshSimplifier", tests::benchmarkMeshSimplifier },
+    { "FrustumCulling", tests::benchmarkFrustumCulling },
+    { "LightClusters", tests::benchmarkLightClusters },
+    { "TextureCompression", tests::benchmarkTextureCompression },
+};
+
+// runs the cases whose name contains i_filter, a failing case doesn't stop the others
+template <std::size_t Count>
+int runCases(const TestCase (&i_cases)[Count], std::string_view i_filter, GLContext& io_glContext)
+{
+    int failuresCount = 0;
+    for (const auto& testCase : i_cases)
+    {
+        if (std::string_view(testCase.d_name).find(i_filter) == std::string_view::npos)
+            continue;
+        if (testCase.d_isUsingGL && !io_glContext.isAvailable())
+        {
+            std::cout << "[ SKIP ] " << testCase.d_name << ": no OpenGL 3.3 context\n";
+            continue;
+        }
+
+        try
+        {
+            testCase.d_run();
+            std::cout << "[  OK  ] " << testCase.d_name << '\n';
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "[FAILED] " << testCase.d_name << ": " << e.what() << '\n';
+            ++failuresCount;
+        }
+    }
+    return failuresCount;
+}
+}
+
+void tests::check(bool i_condition, const std::string& i_message)
+{
+    if (!i_condition)
+        throw std::runtime_error(i_message);
+}
+
+// runs the tests, "--benchmark" runs the benchmarks instead; an optional last argument only runs the cases with it in their name
+int main(int argc, char** argv)
+{
+    const bool isBenchmark = argc > 1 && std::string_view(argv[1]) == "--benchmark";
+    const int filterIndex = isBenchmark ? 2 : 1;
+    const std::string_view filter = argc > filterIndex ? argv[filterIndex] : "";
+
+    GLContext glContext;
+    const int failuresCount = isBenchmark ? runCases(BENCHMARKS, filter, glContext) : runCases(TESTS, filter, glContext);
+    if (failuresCount > 0)
+        std::cout << failuresCount << " failed\n";
+    return failuresCount > 0 ? 1 : 0;
+}
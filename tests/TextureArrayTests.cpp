@@ -0,0 +1,145 @@
+#include "Tests.hpp"
+
+#include "Texture.hpp"
+#include "TextureArray.hpp"
+#include "TextureCompression.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace
+{
+// i_width x i_height image of one color per layer, every channel a different value
+utils::TextureImage createLayerImage(int i_width, int i_height, int i_channels, int i_layer)
+{
+    return tests::createImage(i_width, i_height, i_channels, [i_layer](int, int, int i_channel)
+    {
+        return static_cast<std::uint8_t>(40 * i_layer + 10 * i_channel + 5);
+    });
+}
+
+std::vector<const utils::TextureImage*> getPointers(const std::vector<utils::TextureImage>& i_images)
+{
+    std::vector<const utils::TextureImage*> pointers;
+    for (const auto& image : i_images)
+        pointers.push_back(&image);
+    return pointers;
+}
+
+bool isRefused(const std::vector<const utils::TextureImage*>& i_images)
+{
+    try
+    {
+        utils::TextureArray array(i_images);
+    }
+    catch (const std::runtime_error&)
+    {
+        return true;
+    }
+    return false;
+}
+}
+
+void tests::testTextureArray()
+{
+    // images share a key only with images of their size and format
+    const auto key = utils::getTextureArrayKey(createLayerImage(16, 16, 4, 0));
+    tests::check(utils::getTextureArrayKey(createLayerImage(16, 16, 4, 1)) == key, "Same size and format, different keys");
+    tests::check(utils::getTextureArrayKey(createLayerImage(16, 8, 4, 0)) != key, "Different heights, same key");
+    tests::check(utils::getTextureArrayKey(createLayerImage(8, 16, 4, 0)) != key, "Different widths, same key");
+    tests::check(utils::getTextureArrayKey(createLayerImage(16, 16, 3, 0)) != key, "Different channels, same key");
+
+    // compressed images also by their block format and mips, and never with uncompressed ones
+    const auto sourceImage = createLayerImage(16, 16, 4, 0);
+    const auto& source = std::get<utils::ImageData>(sourceImage);
+    const utils::TextureImage bc1 = utils::compressImage(source, utils::BlockFormat::BC1);
+    const utils::TextureImage bc3 = utils::compressImage(source, utils::BlockFormat::BC3);
+    auto bc1Truncated = utils::compressImage(source, utils::BlockFormat::BC1);
+    bc1Truncated.d_mips.pop_back();
+    tests::check(utils::getTextureArrayKey(utils::compressImage(source, utils::BlockFormat::BC1)) == utils::getTextureArrayKey(bc1),
+                 "Same compressed images, different keys");
+    tests::check(utils::getTextureArrayKey(bc1) != key, "Compressed and uncompressed images, same key");
+    tests::check(utils::getTextureArrayKey(bc1) != utils::getTextureArrayKey(bc3), "BC1 and BC3 images, same key");
+    tests::check(utils::getTextureArrayKey(bc1) != utils::getTextureArrayKey(utils::TextureImage(std::move(bc1Truncated))),
+                 "Different mips counts, same key");
+}
+
+void tests::testTextureArrayLayers()
+{
+    // every layer of every level holds its own image, the mips down to 1x1
+    {
+        static constexpr int SIZE = 8;
+        static constexpr int LAYERS_COUNT = 3;
+        std::vector<utils::TextureImage> images;
+        for (int layer = 0; layer < LAYERS_COUNT; ++layer)
+            images.push_back(createLayerImage(SIZE, SIZE, 4, layer));
+        const utils::TextureArray array(getPointers(images));
+        tests::check(array.getLayersCount() == LAYERS_COUNT, "Wrong layers count " + std::to_string(array.getLayersCount()));
+
+        array.activate(GL_TEXTURE0);
+        for (int level = 0, size = SIZE; size >= 1; ++level, size /= 2)
+        {
+            GLint depth = 0;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, level, GL_TEXTURE_DEPTH, &depth);
+            tests::check(depth == LAYERS_COUNT, "Level " + std::to_string(level) + " has " + std::to_string(depth) + " layers");
+
+            std::vector<std::uint8_t> texels(static_cast<std::size_t>(size) * size * 4 * LAYERS_COUNT);
+            glGetTexImage(GL_TEXTURE_2D_ARRAY, level, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+            for (int layer = 0; layer < LAYERS_COUNT; ++layer)
+            {
+                // every texel of a flat image is its color, in every level
+                const auto* expected = std::get<utils::ImageData>(images[static_cast<std::size_t>(layer)]).d_pixels.get();
+                const auto* layerTexels = texels.data() + static_cast<std::size_t>(layer) * size * size * 4;
+                tests::check(std::memcmp(layerTexels, expected, 4) == 0 && std::memcmp(layerTexels, layerTexels + (size * size - 1) * 4, 4) == 0,
+                             "Layer " + std::to_string(layer) + " of level " + std::to_string(level) + " isn't its image");
+            }
+        }
+    }
+
+    // compressed layers are uploaded level by level as they are, RGTC is core so BC4 is always there
+    for (const auto format : { utils::BlockFormat::BC4, utils::BlockFormat::BC1 })
+    {
+        if (!utils::isBlockFormatSupported(format))
+            continue;
+
+        std::vector<utils::TextureImage> images;
+        for (int layer = 0; layer < 2; ++layer)
+        {
+            const auto source = createLayerImage(16, 16, format == utils::BlockFormat::BC4 ? 1 : 3, layer);
+            images.push_back(utils::compressImage(std::get<utils::ImageData>(source), format));
+        }
+        const utils::TextureArray array(getPointers(images));
+        array.activate(GL_TEXTURE0);
+
+        const auto& firstImage = std::get<utils::CompressedImage>(images[0]);
+        for (std::size_t level = 0; level < firstImage.d_mips.size(); ++level)
+        {
+            const auto& mip = firstImage.d_mips[level];
+            std::vector<std::byte> data(mip.d_size * images.size());
+            glGetCompressedTexImage(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), data.data());
+            for (std::size_t layer = 0; layer < images.size(); ++layer)
+            {
+                const auto& image = std::get<utils::CompressedImage>(images[layer]);
+                tests::check(std::memcmp(data.data() + layer * mip.d_size, image.d_data.data() + image.d_mips[level].d_offset, mip.d_size) == 0,
+                             std::string(utils::getBlockFormatName(format)) + " layer " + std::to_string(layer) + " of level " + std::to_string(level)
+                                 + " isn't its blocks");
+            }
+        }
+        tests::check(array.getGpuBytes() == firstImage.d_data.size() * images.size(), "Compressed array size is off");
+    }
+    tests::check(glGetError() == GL_NO_ERROR, "Packing raised a GL error");
+
+    // no layers and more layers than the GL allows are refused
+    tests::check(isRefused({}), "An array without layers was created");
+    const auto image = createLayerImage(4, 4, 4, 0);
+    tests::check(isRefused(std::vector<const utils::TextureImage*>(utils::TextureArray::getMaxLayersCount() + 1, &image)),
+                 "An array past the layers limit was created");
+}
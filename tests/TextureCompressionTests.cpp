@@ -0,0 +1,254 @@
+#include "Tests.hpp"
+
+#include "Texture.hpp"
+#include "TextureCompression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+// smooth gradients with some high frequency detail, closer to a photo than a flat test pattern
+std::uint8_t getPhotoPixel(int i_x, int i_y, int i_channel)
+{
+    const float smooth = 0.5f + 0.25f * std::sin(static_cast<float>(i_x) * 0.013f + static_cast<float>(i_channel))
+                         + 0.25f * std::cos(static_cast<float>(i_y) * 0.021f - static_cast<float>(i_channel));
+    const unsigned int hash = (static_cast<unsigned int>(i_x) * 73856093u) ^ (static_cast<unsigned int>(i_y) * 19349663u)
+                              ^ (static_cast<unsigned int>(i_channel) * 83492791u);
+    return static_cast<std::uint8_t>(std::clamp(smooth * 230.0f + static_cast<float>(hash % 25u), 0.0f, 255.0f));
+}
+
+std::uint64_t readLittleEndian(const std::byte* i_data, std::size_t i_bytes)
+{
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < i_bytes; ++i)
+        value |= static_cast<std::uint64_t>(i_data[i]) << (8 * i);
+    return value;
+}
+
+// what the GPU decodes a BC1 block to, both modes, RGB of the 16 pixels
+std::array<std::array<int, 3>, 16> decodeColorBlock(const std::byte* i_block)
+{
+    const auto color0 = static_cast<unsigned int>(readLittleEndian(i_block, 2));
+    const auto color1 = static_cast<unsigned int>(readLittleEndian(i_block + 2, 2));
+    const auto expand = [](unsigned int i_color) -> std::array<int, 3>
+    {
+        const int r = static_cast<int>(i_color >> 11);
+        const int g = static_cast<int>((i_color >> 5) & 63);
+        const int b = static_cast<int>(i_color & 31);
+        return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+    };
+
+    std::array<std::array<int, 3>, 4> palette = { expand(color0), expand(color1) };
+    for (int c = 0; c < 3; ++c)
+    {
+        if (color0 > color1)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+
+    const auto indices = readLittleEndian(i_block + 4, 4);
+    std::array<std::array<int, 3>, 16> pixels;
+    for (std::size_t i = 0; i < 16; ++i)
+        pixels[i] = palette[(indices >> (2 * i)) & 3];
+    return pixels;
+}
+
+// what the GPU decodes a BC4 block to, both modes
+std::array<int, 16> decodeChannelBlock(const std::byte* i_block)
+{
+    const int value0 = static_cast<int>(i_block[0]);
+    const int value1 = static_cast<int>(i_block[1]);
+    std::array<int, 8> palette = { value0, value1 };
+    for (int i = 2; i < 8; ++i)
+    {
+        if (value0 > value1)
+            palette[i] = ((8 - i) * value0 + (i - 1) * value1) / 7;
+        else
+            palette[i] = i < 6 ? ((6 - i) * value0 + (i - 1) * value1) / 5 : (i == 6 ? 0 : 255);
+    }
+
+    const auto indices = readLittleEndian(i_block + 2, 6);
+    std::array<int, 16> values;
+    for (std::size_t i = 0; i < 16; ++i)
+        values[i] = palette[(indices >> (3 * i)) & 7];
+    return values;
+}
+
+// the largest difference of any decoded channel of the first mip to the source
+int getMaxError(const utils::ImageData& i_image, const utils::CompressedImage& i_compressed)
+{
+    const int blocksX = (i_image.d_width + 3) / 4;
+    const std::size_t blockBytes = utils::getBlockBytes(i_compressed.d_format);
+    const auto getSource = [&](int i_x, int i_y, int i_channel)
+    {
+        return static_cast<int>(i_image.d_pixels.get()[(static_cast<std::size_t>(i_y) * i_image.d_width + i_x) * i_image.d_channels + i_channel]);
+    };
+
+    int maxError = 0;
+    for (int y = 0; y < i_image.d_height; ++y)
+    {
+        for (int x = 0; x < i_image.d_width; ++x)
+        {
+            const std::byte* block = i_compressed.d_data.data() + (static_cast<std::size_t>(y / 4) * blocksX + x / 4) * blockBytes;
+            const std::size_t pixel = static_cast<std::size_t>(y % 4) * 4 + x % 4;
+            std::array<int, 4> decoded = {};
+            switch (i_compressed.d_format)
+            {
+            case utils::BlockFormat::BC1:
+            {
+                const auto color = decodeColorBlock(block)[pixel];
+                decoded = { color[0], color[1], color[2], 255 };
+                break;
+            }
+            case utils::BlockFormat::BC3:
+            {
+                const auto color = decodeColorBlock(block + 8)[pixel];
+                decoded = { color[0], color[1], color[2], decodeChannelBlock(block)[pixel] };
+                break;
+            }
+            case utils::BlockFormat::BC4:
+                decoded[0] = decodeChannelBlock(block)[pixel];
+                break;
+            case utils::BlockFormat::BC5:
+                decoded[0] = decodeChannelBlock(block)[pixel];
+                decoded[1] = decodeChannelBlock(block + 8)[pixel];
+                break;
+            }
+
+            for (int c = 0; c < std::min(i_image.d_channels, 4); ++c)
+                maxError = std::max(maxError, std::abs(decoded[static_cast<std::size_t>(c)] - getSource(x, y, c)));
+        }
+    }
+    return maxError;
+}
+}
+
+utils::ImageData tests::createImage(int i_width, int i_height, int i_channels, const std::function<std::uint8_t(int, int, int)>& i_pixel)
+{
+    // allocated like stb does, ImageData frees with stbi_image_free
+    utils::ImageData image;
+    image.d_width = i_width;
+    image.d_height = i_height;
+    image.d_channels = i_channels;
+    image.d_pixels.reset(static_cast<unsigned char*>(std::malloc(static_cast<std::size_t>(i_width) * i_height * i_channels)));
+    for (int y = 0; y < i_height; ++y)
+    {
+        for (int x = 0; x < i_width; ++x)
+        {
+            for (int c = 0; c < i_channels; ++c)
+                image.d_pixels.get()[(static_cast<std::size_t>(y) * i_width + x) * i_channels + c] = i_pixel(x, y, c);
+        }
+    }
+    return image;
+}
+
+void tests::testTextureCompression()
+{
+    // the format follows the channels, and the alpha of 4 channel images
+    {
+        const auto flat = [](int, int, int i_channel) { return static_cast<std::uint8_t>(i_channel == 3 ? 255 : 100); };
+        const auto translucent = [](int i_x, int, int i_channel) { return static_cast<std::uint8_t>(i_channel == 3 ? (i_x == 2 ? 128 : 255) : 100); };
+        tests::check(utils::chooseBlockFormat(tests::createImage(8, 8, 1, flat)) == utils::BlockFormat::BC4, "One channel isn't BC4");
+        tests::check(utils::chooseBlockFormat(tests::createImage(8, 8, 2, flat)) == utils::BlockFormat::BC5, "Two channels aren't BC5");
+        tests::check(utils::chooseBlockFormat(tests::createImage(8, 8, 3, flat)) == utils::BlockFormat::BC1, "Three channels aren't BC1");
+        tests::check(utils::chooseBlockFormat(tests::createImage(8, 8, 4, flat)) == utils::BlockFormat::BC1, "Opaque four channels aren't BC1");
+        tests::check(utils::chooseBlockFormat(tests::createImage(8, 8, 4, translucent)) == utils::BlockFormat::BC3, "Translucent four channels aren't BC3");
+    }
+
+    // the mip chain goes down to 1x1, every level packed after the previous one, odd sizes included
+    {
+        const auto image = tests::createImage(100, 37, 3, getPhotoPixel);
+        const auto compressed = utils::compressImage(image, utils::BlockFormat::BC1);
+        tests::check(compressed.d_mips.size() == 7, "Expected 7 mips of 100x37, got " + std::to_string(compressed.d_mips.size()));
+
+        std::size_t offset = 0;
+        int width = image.d_width;
+        int height = image.d_height;
+        for (const auto& mip : compressed.d_mips)
+        {
+            const std::string name = "Mip " + std::to_string(mip.d_width) + 'x' + std::to_string(mip.d_height);
+            tests::check(mip.d_width == width && mip.d_height == height, name + " should be " + std::to_string(width) + 'x' + std::to_string(height));
+            tests::check(mip.d_offset == offset, name + " not packed");
+            tests::check(mip.d_size == utils::getCompressedSize(utils::BlockFormat::BC1, width, height), name + " has the wrong size");
+            offset += mip.d_size;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        tests::check(offset == compressed.d_data.size(), "Data past the last mip");
+        tests::check(compressed.d_mips.back().d_width == 1 && compressed.d_mips.back().d_height == 1, "The chain doesn't end at 1x1");
+    }
+
+    // flat blocks only lose the endpoints' quantization, BC4 nothing
+    {
+        const auto flat = [](int, int, int i_channel) { return static_cast<std::uint8_t>(37 + 70 * i_channel); };
+        const int colorError = getMaxError(tests::createImage(16, 16, 3, flat), utils::compressImage(tests::createImage(16, 16, 3, flat), utils::BlockFormat::BC1));
+        tests::check(colorError <= 4, "Flat BC1 error " + std::to_string(colorError));
+        const int channelError = getMaxError(tests::createImage(16, 16, 1, flat), utils::compressImage(tests::createImage(16, 16, 1, flat), utils::BlockFormat::BC4));
+        tests::check(channelError == 0, "Flat BC4 error " + std::to_string(channelError));
+    }
+
+    // a gradient along a line through RGB is what BC1's palette fits, one channel gradients are 8 steps per block for BC4
+    {
+        const auto gradient = [](int i_x, int i_y, int i_channel) { return static_cast<std::uint8_t>((i_x * 3 + i_y) * (i_channel + 1) / 3); };
+        const struct
+        {
+            int d_channels;
+            utils::BlockFormat d_format;
+            int d_maxError;
+        } cases[] = {
+            { 3, utils::BlockFormat::BC1, 12 },
+            { 4, utils::BlockFormat::BC3, 12 },
+            { 1, utils::BlockFormat::BC4, 2 },
+            { 2, utils::BlockFormat::BC5, 2 },
+        };
+        for (const auto& gradientCase : cases)
+        {
+            const auto image = tests::createImage(32, 32, gradientCase.d_channels, gradient);
+            const int error = getMaxError(image, utils::compressImage(image, gradientCase.d_format));
+            tests::check(error <= gradientCase.d_maxError, std::string("Gradient ") + utils::getBlockFormatName(gradientCase.d_format) + " error "
+                                                              + std::to_string(error));
+        }
+    }
+}
+
+void tests::benchmarkTextureCompression()
+{
+    // the sizes and channel counts of a typical model's textures: diffuse, diffuse with alpha, roughness and normal maps
+    const struct
+    {
+        int d_width;
+        int d_height;
+        int d_channels;
+    } images[] = {
+        { 2048, 2048, 3 }, { 1024, 1024, 3 }, { 1024, 1024, 4 }, { 1024, 1024, 1 }, { 1024, 1024, 2 }, { 1000, 600, 3 },
+    };
+
+    for (const auto& size : images)
+    {
+        const auto image = tests::createImage(size.d_width, size.d_height, size.d_channels, getPhotoPixel);
+        const auto format = utils::chooseBlockFormat(image);
+        std::size_t compressedSize = 0;
+        const double milliseconds = tests::measureMilliseconds(3, [&]() { compressedSize = utils::compressImage(image, format).d_data.size(); });
+
+        // the whole chain is encoded, the rate is of the first level's pixels
+        const double megapixels = static_cast<double>(size.d_width) * size.d_height / 1e6;
+        std::cout << "Texture compression: " << size.d_width << 'x' << size.d_height << 'x' << size.d_channels << " to "
+                  << utils::getBlockFormatName(format) << " with mips in " << milliseconds << " ms (" << megapixels / (milliseconds / 1e3)
+                  << " MPixels/s), " << compressedSize / 1024 << " KiB\n";
+    }
+}